@@ -0,0 +1,202 @@
+/**
+ * @file main.cpp
+ * @brief The entry point of lightwave_bench, which runs benchmark files and compares their results against a baseline.
+ *
+ * Usage: lightwave_bench [--json <results.json>] [--baseline <baseline.json>] [--tolerance <fraction>] [files...]
+ *
+ * Without files, all benchmark files in this directory are run. Results can be written to JSON and compared against
+ * the JSON of an earlier run, in which case the process fails if any measurement got worse by more than the
+ * tolerance (10% by default).
+ */
+
+#include <lightwave/benchmark.hpp>
+#include <lightwave/core.hpp>
+#include <lightwave/logger.hpp>
+#include <lightwave/parallel.hpp>
+
+#include "../src/core/parser.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+using namespace lightwave;
+
+/// @brief Quotes a string for use in JSON.
+static std::string jsonString(const std::string &value) {
+    std::string result = "\"";
+    for (const char chr : value) {
+        if (chr == '"' || chr == '\\')
+            result += '\\';
+        result += chr;
+    }
+    return result + "\"";
+}
+
+/// @brief Returns the raw value of a key in a line of JSON written by @ref writeResults (or an empty string).
+static std::string jsonField(const std::string &line, const std::string &key) {
+    const std::string pattern = "\"" + key + "\": ";
+    size_t start = line.find(pattern);
+    if (start == std::string::npos)
+        return "";
+    start += pattern.size();
+
+    if (line[start] == '"') {
+        std::string result;
+        for (size_t i = start + 1; i < line.size() && line[i] != '"'; i++) {
+            if (line[i] == '\\')
+                i++;
+            result += line[i];
+        }
+        return result;
+    }
+    const size_t end = line.find_first_of(",}", start);
+    return line.substr(start, end - start);
+}
+
+static void print_exception(const std::exception &e, int level = 0) {
+    logger(EError, "%s%s", std::string(2 * level, ' '), e.what());
+    try {
+        std::rethrow_if_nested(e);
+    } catch (const std::exception &nestedException) {
+        print_exception(nestedException, level + 1);
+    } catch (...) {}
+}
+
+static std::string resultKey(const Benchmark::Result &result) {
+    return result.benchmark + " / " + result.subject + " / " + result.metric;
+}
+
+/// @brief Writes one result per line, which keeps the file easy to diff and to read back in @ref readResults .
+static void writeResults(const std::filesystem::path &path, const std::vector<Benchmark::Result> &results) {
+    std::ofstream file{ path };
+    if (!file)
+        lightwave_throw("could not write results to %s", path);
+
+    file << "{\n";
+#ifdef LW_DEBUG
+    file << "  \"debug\": true,\n";
+#else
+    file << "  \"debug\": false,\n";
+#endif
+    file << "  \"threads\": " << threadCount() << ",\n";
+    file << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &result = results[i];
+        file << tfm::format("    {\"benchmark\": %s, \"subject\": %s, \"metric\": %s, \"value\": %.9g, "
+                            "\"unit\": %s, \"lowerIsBetter\": %s}%s\n",
+                            jsonString(result.benchmark), jsonString(result.subject), jsonString(result.metric),
+                            result.value, jsonString(result.unit), result.lowerIsBetter ? "true" : "false",
+                            i + 1 < results.size() ? "," : "");
+    }
+    file << "  ]\n";
+    file << "}\n";
+    logger(EInfo, "wrote %d results to %s", results.size(), path);
+}
+
+static std::map<std::string, Benchmark::Result> readResults(const std::filesystem::path &path) {
+    std::ifstream file{ path };
+    if (!file)
+        lightwave_throw("could not read baseline %s", path);
+
+    std::map<std::string, Benchmark::Result> results;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find("\"benchmark\":") == std::string::npos)
+            continue;
+        Benchmark::Result result = {
+            .benchmark = jsonField(line, "benchmark"),
+            .subject = jsonField(line, "subject"),
+            .metric = jsonField(line, "metric"),
+            .value = std::stod(jsonField(line, "value")),
+            .unit = jsonField(line, "unit"),
+            .lowerIsBetter = jsonField(line, "lowerIsBetter") == "true",
+        };
+        results[resultKey(result)] = result;
+    }
+    return results;
+}
+
+/// @brief Compares results against a baseline and returns the number of measurements that got worse than tolerated.
+static int compare(const std::vector<Benchmark::Result> &results,
+                   const std::map<std::string, Benchmark::Result> &baseline, double tolerance) {
+    int regressions = 0;
+    for (const auto &result : results) {
+        const auto it = baseline.find(resultKey(result));
+        if (it == baseline.end()) {
+            logger(EWarn, "%s: not in baseline", resultKey(result));
+            continue;
+        }
+
+        const double base = it->second.value;
+        const double change = base != 0 ? result.value / base - 1 : 0;
+        const double slowdown = result.lowerIsBetter ? change : -change;
+        const bool regressed = slowdown > tolerance;
+        regressions += regressed;
+        logger(regressed ? EError : EInfo, "%s: %.3f -> %.3f %s (%+.1f%%)%s", resultKey(result), base, result.value,
+               result.unit, 100 * change, regressed ? " REGRESSION" : "");
+    }
+    return regressions;
+}
+
+int main(int argc, const char *argv[]) {
+    try {
+        std::vector<std::filesystem::path> files;
+        std::filesystem::path jsonPath;
+        std::filesystem::path baselinePath;
+        double tolerance = 0.1;
+
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (argument == "--json" && hasValue) {
+                jsonPath = argv[++i];
+            } else if (argument == "--baseline" && hasValue) {
+                baselinePath = argv[++i];
+            } else if (argument == "--tolerance" && hasValue) {
+                tolerance = std::stod(argv[++i]);
+            } else if (argument.starts_with("--")) {
+                logger(EError, "unexpected argument \"%s\"", argument);
+                return -1;
+            } else {
+                files.push_back(argument);
+            }
+        }
+
+        if (files.empty()) {
+            for (const auto &entry : std::filesystem::directory_iterator(LW_BENCHMARK_DIR)) {
+                if (entry.path().extension() == ".xml")
+                    files.push_back(entry.path());
+            }
+            std::sort(files.begin(), files.end());
+        }
+
+        for (const auto &file : files) {
+            logger(EInfo, "running benchmarks in %s", file);
+            SceneParser parser { file };
+            for (auto &object : parser.objects()) {
+                if (auto benchmark = dynamic_cast<Benchmark *>(object.get())) {
+                    benchmark->execute();
+                }
+            }
+        }
+
+        const auto &results = Benchmark::results();
+        if (!jsonPath.empty()) {
+            writeResults(jsonPath, results);
+        }
+        if (!baselinePath.empty()) {
+            const int regressions = compare(results, readResults(baselinePath), tolerance);
+            if (regressions > 0) {
+                logger(EError, "%d measurements regressed by more than %.0f%%", regressions, 100 * tolerance);
+                return 1;
+            }
+            logger(EInfo, "no regressions beyond %.0f%%", 100 * tolerance);
+        }
+    } catch (const std::exception &e) {
+        print_exception(e);
+        return 1;
+    }
+
+    return 0;
+}
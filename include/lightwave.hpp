@@ -14,15 +14,19 @@
 #include <lightwave/registry.hpp>
 
 // MARK: - utilities
+#include <lightwave/distribution.hpp>
 #include <lightwave/iterators.hpp>
 #include <lightwave/parallel.hpp>
 #include <lightwave/streaming.hpp>
+#include <lightwave/telemetry.hpp>
 #include <lightwave/warp.hpp>
 
 // MARK: - objects
+#include <lightwave/benchmark.hpp>
 #include <lightwave/bsdf.hpp>
 #include <lightwave/camera.hpp>
 #include <lightwave/emission.hpp>
+#include <lightwave/film.hpp>
 #include <lightwave/image.hpp>
 #include <lightwave/instance.hpp>
 #include <lightwave/integrator.hpp>
@@ -0,0 +1,90 @@
+/**
+ * @file benchmark.hpp
+ * @brief Contains the Benchmark interface, which are executable objects that measure the performance of parts of the renderer.
+ */
+
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/logger.hpp>
+#include <lightwave/properties.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+namespace lightwave {
+
+/// @brief An executable object (typically placed at the root of a scene), that measures the performance of individual components of your renderer.
+class Benchmark : public Executable {
+public:
+    /// @brief A single measurement reported by a benchmark.
+    struct Result {
+        /// @brief The id of the benchmark that took the measurement.
+        std::string benchmark;
+        /// @brief The object that was measured (e.g., the id of a sampler).
+        std::string subject;
+        /// @brief What was measured (e.g., "sample").
+        std::string metric;
+        double value;
+        /// @brief The unit of the value (e.g., "ns/call").
+        std::string unit;
+        /// @brief Whether smaller values are better (e.g., for times), which decides what counts as a regression.
+        bool lowerIsBetter;
+    };
+
+    /// @brief All results reported by benchmarks so far, in the order they were reported.
+    static std::vector<Result> &results() {
+        static std::vector<Result> results;
+        return results;
+    }
+
+protected:
+    /// @brief How often the measurement is repeated, the fastest repetition is reported to suppress outliers.
+    int m_repetitions;
+
+    /// @brief Logs a measurement and records it in @ref results .
+    void report(const std::string &subject, const std::string &metric, double value, const std::string &unit,
+                bool lowerIsBetter = true) const {
+        const std::string benchmark = id().empty() ? "unnamed" : id();
+        logger(EInfo, "%s: %s %s = %.3f %s", benchmark, subject, metric, value, unit);
+        results().push_back({ benchmark, subject, metric, value, unit, lowerIsBetter });
+    }
+
+    /**
+     * @brief Runs a workload @c m_repetitions times and returns the time of the fastest repetition in seconds.
+     * The workload receives the index of the repetition, e.g., to seed random number generators.
+     */
+    template <typename F> double fastestOf(F &&workload) const {
+        double best = std::numeric_limits<double>::infinity();
+        for (int repetition = 0; repetition < m_repetitions; repetition++) {
+            const auto start = std::chrono::steady_clock::now();
+            workload(repetition);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    /// @brief Returns a name for the @c index -th child object, which is its id if it has one.
+    static std::string subjectName(const Object &object, size_t index, const char *kind) {
+        return object.id().empty() ? tfm::format("%s %d", kind, index) : object.id();
+    }
+
+public:
+    Benchmark(const Properties &properties) {
+        m_repetitions = properties.get<int>("repetitions", 5);
+    }
+};
+
+/// @brief Prevents the compiler from optimizing away computations whose results are otherwise unused.
+template <typename T> inline void doNotOptimize(const T &value) {
+#if defined(LW_CC_GNU) || defined(LW_CC_CLANG)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T *sink;
+    sink = &value;
+#endif
+}
+
+}
@@ -18,6 +18,9 @@ struct BsdfSample {
     /// @brief The weight of the sample, given by @code cos(theta) * B(wi, wo) /
     /// p(wi) @endcode
     Color weight;
+    /// @brief The probability density of sampling @c wi (in solid angle),
+    /// which is infinite for specular (delta) reflection and refraction.
+    float pdf;
 
     /// @brief Return an invalid sample, used to denote that sampling has
     /// failed.
@@ -25,6 +28,7 @@ struct BsdfSample {
         return {
             .wi     = Vector(0),
             .weight = Color(0),
+            .pdf    = 0,
         };
     }
 
@@ -65,7 +69,7 @@ public:
      * @param wi The incoming direction light comes from, pointing away
      * from the surface, in local coordinates.
      */
-    virtual BsdfEval evaluate(const Point2& uv, const Vector& wo, const Vector& wi) const {
+    virtual BsdfEval evaluate(const TexCoord& uv, const Vector& wo, const Vector& wi) const {
         NOT_IMPLEMENTED
     }
 
@@ -79,7 +83,24 @@ public:
      * from the surface, in local coordinates.
      * @param rng A random number generator used to steer the sampling.
      */
-    virtual BsdfSample sample(const Point2& uv, const Vector& wo, Sampler& rng) const = 0;
+    virtual BsdfSample sample(const TexCoord& uv, const Vector& wo, Sampler& rng) const = 0;
+
+    /**
+     * @brief Returns the probability density (in solid angle) of @ref sample
+     * producing @c wi for the given @c wo in local coordinates.
+     * Specular (delta) components cannot produce a given direction by chance,
+     * hence they do not contribute to the density. The density must be zero
+     * wherever @ref evaluate is zero, since integrators rely on this to
+     * detect directions that cannot be found by light sampling.
+     * @param uv The texture coordinates of the surface.
+     * @param wo The outgoing direction light is scattered in, pointing away
+     * from the surface, in local coordinates.
+     * @param wi The incoming direction light comes from, pointing away
+     * from the surface, in local coordinates.
+     */
+    virtual float pdf(const TexCoord& uv, const Vector& wo, const Vector& wi) const {
+        return 0;
+    }
 };
 
 } // namespace lightwave
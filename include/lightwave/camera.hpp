@@ -15,8 +15,8 @@ namespace lightwave {
 
 /// @brief The result of sampling a Camera.
 struct CameraSample {
-    /// @brief The direction vector, pointing away from the camera.
-    Ray ray;
+    /// @brief The direction vector, pointing away from the camera, along with the rays through the neighboring pixels.
+    RayDifferential ray;
 
     /// @brief The weight of the sample.
     Color weight;
@@ -31,6 +31,14 @@ protected:
     /// @brief The transform that leads from local coordinates to world space coordinates.
     ref<Transform> m_transform;
 
+    /// @brief Whether sampled rays carry the rays through the neighboring pixels (see @ref RayDifferential ).
+    bool m_differentials = true;
+
+    /// @brief Returns the size of a pixel in normalized coordinates, i.e., the offset between neighboring pixels.
+    Vector2 normalizedPixelSize() const {
+        return { 2.0f / float(m_resolution.x()), 2.0f / float(m_resolution.y()) };
+    }
+
 public:
     Camera(const Properties &properties) {
         m_resolution.x() = properties.get<int>("width");
@@ -41,6 +49,13 @@ public:
     /// @brief Returns the resolution of the image that is being rendered. 
     const Vector2i &resolution() const { return m_resolution; }
 
+    /// @brief Returns the transform that leads from local coordinates to world space coordinates.
+    const ref<Transform> &transform() const { return m_transform; }
+    /// @brief Replaces the transform of the camera, e.g., to move the viewpoint between renders.
+    void setTransform(const ref<Transform> &transform) { m_transform = transform; }
+    /// @brief Sets whether sampled rays carry differentials, which can be skipped when no texture makes use of them.
+    void setDifferentials(bool differentials) { m_differentials = differentials; }
+
     /**
      * @brief Helper function to sample the camera model for a given pixel.
      * This function samples a random position within the given pixel, normalizes the pixel coordinates, and
@@ -51,10 +66,19 @@ public:
      */
     CameraSample sample(const Point2i &pixel, Sampler &rng) const;
 
+    /**
+     * @brief Samples the camera model for a given position on the image plane, given in pixel coordinates ranging
+     * from [0,0] (top left corner of the image) to [resolution().x(), resolution().y()].
+     * This allows integrators to decide where within a pixel to sample (e.g., to reconstruct pixels with a filter).
+     */
+    CameraSample sampleAt(const Point2 &position, Sampler &rng) const;
+
     /**
      * @brief Samples a ray according to this camera model in world space coordinates.
      * Sampling begins in local coordinates following the convention that [0,0,1] is the central viewing direction, and
      * then transforms the ray into world coordinates using the supplied @c m_transform object.
+     * Unless disabled, cameras should also provide the differentials of the ray (see @ref RayDifferential ), which allow
+     * textures to be filtered according to the footprint of the pixel.
      * 
      * @param normalized Normalized coordinates ranging from [-1, -1] (bottom left of the image) to [+1, +1] (top right of the image).
      * @param rng A random number generator used to steer the sampling.
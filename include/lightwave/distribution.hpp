@@ -0,0 +1,140 @@
+/**
+ * @file distribution.hpp
+ * @brief Contains discrete probability distributions that can be sampled efficiently.
+ */
+
+#pragma once
+
+#include <lightwave/core.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief A discrete distribution over indices, proportional to a list of non-negative weights, that can be sampled in
+ * constant time using Walker's alias method.
+ * Each index owns a bin of equal probability. A bin keeps its own index with probability @c q and otherwise redirects
+ * to its @c alias, which has been chosen during construction such that the resulting probabilities match the weights.
+ * @see "A Linear Algorithm For Generating Random Numbers With a Given Distribution" (Vose, 1991)
+ */
+class AliasTable {
+    struct Bin {
+        /// @brief The probability of keeping the index of this bin instead of redirecting to @c alias .
+        float q;
+        /// @brief The index returned when this bin is not kept.
+        int alias;
+        /// @brief The normalized probability of sampling the index of this bin.
+        float pmf;
+    };
+
+    std::vector<Bin> m_bins;
+    /// @brief The sum of all weights the table was built from.
+    double m_total = 0;
+
+public:
+    AliasTable() = default;
+
+    /// @brief Builds the table for the given weights. If all weights are zero, an empty table results.
+    explicit AliasTable(const std::vector<float> &weights) {
+        build(weights);
+    }
+
+    void build(const std::vector<float> &weights) {
+        m_bins.clear();
+        m_total = 0;
+        for (const float weight : weights) {
+            assert(weight >= 0);
+            m_total += weight;
+        }
+        if (m_total <= 0)
+            return;
+
+        const int n = int(weights.size());
+        m_bins.resize(n);
+
+        // scaled probabilities, such that the average bin has a probability of exactly one
+        std::vector<double> scaled(n);
+        std::vector<int> small, large;
+        for (int i = 0; i < n; i++) {
+            m_bins[i].pmf = float(weights[i] / m_total);
+            scaled[i] = weights[i] / m_total * n;
+            (scaled[i] < 1 ? small : large).push_back(i);
+        }
+
+        while (!small.empty() && !large.empty()) {
+            const int s = small.back();
+            small.pop_back();
+            const int l = large.back();
+
+            m_bins[s].q = float(scaled[s]);
+            m_bins[s].alias = l;
+
+            // the large bin donates the remaining probability mass to fill the small bin
+            scaled[l] -= 1 - scaled[s];
+            if (scaled[l] < 1) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        // whatever remains is (up to rounding errors) exactly one
+        for (const int i : large) {
+            m_bins[i].q = 1;
+            m_bins[i].alias = i;
+        }
+        for (const int i : small) {
+            m_bins[i].q = 1;
+            m_bins[i].alias = i;
+        }
+    }
+
+    /// @brief Reports whether the table contains no index with non-zero probability.
+    bool empty() const { return m_bins.empty(); }
+    /// @brief Returns the number of indices the table was built for (or zero if all weights were zero).
+    int size() const { return int(m_bins.size()); }
+    /// @brief Returns the sum of the weights the table was built from.
+    float total() const { return float(m_total); }
+
+    /**
+     * @brief Picks an index proportional to its weight using a single random number.
+     * @note The bits of @c u that remain after picking the bin decide between the bin and its alias, so this is only
+     * accurate for small tables. Use @ref sample(float, float) const for tables with many entries.
+     * @param u A random number in [0,1).
+     * @param remapped If given, receives a fresh random number in [0,1) derived from the unused bits of @c u .
+     */
+    int sample(float u, float *remapped = nullptr) const {
+        assert(!empty());
+        const float scaled = u * m_bins.size();
+        const int index = std::min(int(scaled), int(m_bins.size()) - 1);
+        const float v = std::min(scaled - index, 0x1.fffffep-1f);
+
+        const Bin &bin = m_bins[index];
+        if (v < bin.q) {
+            if (remapped) *remapped = std::min(v / bin.q, 0x1.fffffep-1f);
+            return index;
+        }
+        if (remapped) *remapped = std::min((v - bin.q) / (1 - bin.q), 0x1.fffffep-1f);
+        return bin.alias;
+    }
+
+    /**
+     * @brief Picks an index proportional to its weight, using separate random numbers for picking a bin and for
+     * deciding between the bin and its alias.
+     * @param u A random number in [0,1) that picks the bin.
+     * @param v A random number in [0,1) that decides between the bin and its alias.
+     */
+    int sample(float u, float v) const {
+        assert(!empty());
+        const int index = std::min(int(u * m_bins.size()), int(m_bins.size()) - 1);
+        const Bin &bin = m_bins[index];
+        return v < bin.q ? index : bin.alias;
+    }
+
+    /// @brief Returns the probability of @ref sample returning the given index.
+    float pmf(int index) const { return m_bins[index].pmf; }
+};
+
+}
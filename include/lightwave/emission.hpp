@@ -34,7 +34,7 @@ public:
      * @param uv The texture coordinates of the surface.
      * @param wo The outgoing direction light is emitted in, pointing away from the surface, in local coordinates.
      */
-    virtual EmissionEval evaluate(const Point2 &uv, const Vector &wo) const = 0;
+    virtual EmissionEval evaluate(const TexCoord &uv, const Vector &wo) const = 0;
 };
 
 }
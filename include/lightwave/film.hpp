@@ -0,0 +1,170 @@
+/**
+ * @file film.hpp
+ * @brief Contains the Film class, which accumulates camera samples into images, and the Filter interface used to
+ * reconstruct pixels from those samples.
+ */
+
+#pragma once
+
+#include <lightwave/color.hpp>
+#include <lightwave/core.hpp>
+#include <lightwave/image.hpp>
+#include <lightwave/math.hpp>
+#include <lightwave/properties.hpp>
+
+#include <mutex>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief A separable reconstruction filter, which decides how much a sample contributes to each pixel around it.
+ * Pixels are reconstructed as the weighted average of all samples within the radius of the filter.
+ */
+class Filter : public Object {
+protected:
+    /// @brief The distance (in pixels) beyond which samples no longer contribute to a pixel.
+    float m_radius;
+
+public:
+    Filter(const Properties &properties, float defaultRadius) {
+        m_radius = properties.get<float>("radius", defaultRadius);
+    }
+
+    /// @brief The distance (in pixels) beyond which samples no longer contribute to a pixel.
+    float radius() const { return m_radius; }
+
+    /**
+     * @brief Evaluates the filter along one axis, for a sample at the given signed distance (in pixels) from the
+     * center of a pixel. The distance always lies within [-radius, +radius].
+     */
+    virtual float evaluate(float distance) const = 0;
+};
+
+/**
+ * @brief Accumulates the samples of a sampling integrator into its output image and any number of additional channels
+ * (arbitrary output variables, or AOVs, such as the albedo of the first surface hit).
+ * Each block of the image is rendered into its own tile, which covers the block plus the footprint of the filter and
+ * is only ever touched by the thread rendering the block, which avoids atomics (and their contention) when samples
+ * contribute to pixels of neighboring blocks. Without a filter, tiles do not overlap and are written straight into the
+ * output images. Otherwise, tiles are added to an accumulation buffer of the whole image as they finish, locking only
+ * the bands of rows they cover, and the pixels are reconstructed from that buffer once rendering has finished.
+ * With @c multilayer enabled, the AOVs are saved as layers of the output image (e.g., "albedo.R") instead of separate
+ * files.
+ */
+class Film : public Object {
+public:
+    /// @brief The largest filter radius (in pixels) supported.
+    static constexpr int MaxFilterRadius = 8;
+
+    /// @brief The quantities that can be recorded in additional channels.
+    enum AovType {
+        /// @brief The reflectance of the first surface hit, estimated by sampling its Bsdf.
+        EAlbedo,
+        /// @brief The shading normal of the first surface hit, in world space.
+        ENormal,
+        /// @brief The position of the first surface hit, in world space.
+        EPosition,
+        /// @brief The distance to the first surface hit.
+        EDepth,
+        /// @brief A channel that is not known to the film, and needs to be provided by the integrator.
+        ECustom,
+    };
+
+    /// @brief An additional channel recorded by the film.
+    struct Aov {
+        /// @brief The name of the channel (e.g., "albedo").
+        std::string name;
+        AovType type;
+        /// @brief The image the channel is developed into.
+        ref<Image> image;
+    };
+
+    /// @brief Accumulates the weighted samples of a single block, see @ref Film::createTile .
+    class Tile {
+        friend class Film;
+
+        const Filter *m_filter;
+        /// @brief The pixels covered by this tile, i.e., the block grown by the footprint of the filter.
+        Bounds2i m_bounds;
+        /// @brief The number of channels, i.e., the output image and all AOVs.
+        int m_channels;
+        /// @brief The sum of filter weights of each pixel.
+        std::vector<float> m_weights;
+        /// @brief The weighted sums of each channel, stored pixel by pixel.
+        std::vector<Color> m_values;
+
+        Tile(const Filter *filter, const Bounds2i &bounds, int channels);
+
+    public:
+        /**
+         * @brief Adds a sample to all pixels within the footprint of the filter.
+         * @param position The position of the sample in pixel coordinates, e.g., [0.5,0.5] is the center of the
+         * top-left pixel of the image.
+         * @param values The value of the sample for each channel, starting with the output image.
+         */
+        void addSample(const Point2 &position, const Color *values);
+
+        /**
+         * @brief Writes the reconstructed pixels of a block to an image, using only the samples of this tile.
+         * This is exact for the box filter, and otherwise gives a preview for streaming.
+         */
+        void develop(const Bounds2i &block, Image &image) const;
+    };
+
+private:
+    /// @brief The reconstruction filter, or null to average the samples within each pixel (i.e., a box filter).
+    ref<Filter> m_filter;
+    std::vector<Aov> m_aovs;
+    Vector2i m_resolution;
+    /// @brief Whether the AOVs are stored as layers of the output image instead of separate files.
+    bool m_multilayer = false;
+
+    /// @brief The number of rows of the accumulation buffer that are guarded by the same lock.
+    static constexpr int BandHeight = 16;
+
+    /// @brief The sum of filter weights of each pixel over all merged tiles (only used with a filter).
+    std::vector<float> m_weights;
+    /// @brief The weighted sums of each channel over all merged tiles, stored pixel by pixel (only used with a filter).
+    std::vector<Color> m_values;
+    /// @brief One lock per band of @ref BandHeight rows of the accumulation buffer.
+    std::vector<std::mutex> m_bandLocks;
+
+public:
+    /// @brief Creates a film without AOVs, that averages the samples within each pixel.
+    Film() {}
+    Film(const Properties &properties);
+
+    /**
+     * @brief Prepares the film for rendering an image with the given resolution.
+     * AOV images that were not specified explicitly are stored next to the output image, with the name of the AOV
+     * appended to its id, and use the same file format options.
+     */
+    void initialize(const Vector2i &resolution, const Image &output);
+    /// @brief Discards all merged samples, e.g., before starting a new rendering pass.
+    void clear();
+
+    /// @brief Returns the reconstruction filter, or null if the samples within each pixel are averaged.
+    const Filter *filter() const { return m_filter.get(); }
+    /// @brief Returns the additional channels recorded by this film.
+    const std::vector<Aov> &aovs() const { return m_aovs; }
+    /// @brief Returns the number of channels recorded by this film, i.e., the output image and all AOVs.
+    int channelCount() const { return 1 + int(m_aovs.size()); }
+
+    /// @brief Creates a tile to accumulate all samples taken for pixels within the given block.
+    Tile createTile(const Bounds2i &block) const;
+    /**
+     * @brief Hands a tile back to the film once all samples of its block have been added. Without a filter, the pixels
+     * of the block are final and written to the output image and all AOV images right away.
+     */
+    void mergeTile(const Tile &tile, Image &output);
+
+    /// @brief Reconstructs all pixels from the merged tiles, writing the output image and all AOV images.
+    void develop(Image &output);
+    /// @brief Saves the output image and all AOV images, either as separate files or as layers of a single file.
+    void save(const Image &output) const;
+
+    std::string toString() const override;
+};
+
+} // namespace lightwave
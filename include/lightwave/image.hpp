@@ -12,10 +12,47 @@
 #include <lightwave/math.hpp>
 #include <lightwave/properties.hpp>
 
+#include <span>
+
 namespace lightwave {
 
-/// @brief An image.
+/**
+ * @brief An image.
+ * Images are saved as EXR files with 16-bit half floats and ZIP compression by default, which can be changed with the
+ * @c precision ( @c half or @c float ) and @c compression ( @c none , @c rle , @c zip or @c piz ) properties.
+ * Saving happens in the background, see @ref waitForPendingSaves .
+ */
 class Image final : public Object {
+public:
+    /// @brief The type used to store pixel values when saving.
+    enum Precision {
+        EHalf,
+        EFloat,
+    };
+
+    /// @brief The compression used when saving.
+    enum Compression {
+        ENoCompression,
+        ERle,
+        EZip,
+        EPiz,
+    };
+
+    /// @brief An image that is stored as an additional layer of an EXR file, e.g., an AOV next to the beauty pass.
+    struct Layer {
+        /// @brief The name of the layer, which prefixes its channel names (e.g., "albedo.R").
+        std::string name;
+        const Image *image;
+    };
+
+    /// @brief Identifies the pixels decoded from an image file, see @ref loadImage .
+    struct Source {
+        std::filesystem::path path;
+        bool isLinearSpace = false;
+        std::string layer;
+    };
+
+private:
     /// @brief The resolution of this image in pixels.
     Point2i m_resolution;
 
@@ -25,6 +62,9 @@ class Image final : public Object {
     /// @brief The folder the image was loaded from or should be stored to.
     std::filesystem::path m_basePath;
 
+    Precision m_precision = EHalf;
+    Compression m_compression = EZip;
+
     /**
      * @brief Converts a normalized position from [0,0]..[+1,+1] to a pixel
      * index [0,0]..[resolution.x-1, resolution.y-1]. Input positions outside
@@ -52,11 +92,23 @@ public:
     Image(const Properties &properties) {
         if (properties.has("filename")) {
             auto path = properties.get<std::filesystem::path>("filename");
-            loadImage(path, properties.get<bool>("linear", false));
+            // layers of multi-layer EXR files (e.g., AOVs) can be loaded by name
+            loadImage(path, properties.get<bool>("linear", false), properties.get<std::string>("layer", ""));
             m_basePath = path.parent_path();
         } else {
             m_basePath = properties.basePath();
         }
+
+        m_precision = properties.getEnum<Precision>("precision", EHalf, {
+            { "half", EHalf },
+            { "float", EFloat },
+        });
+        m_compression = properties.getEnum<Compression>("compression", EZip, {
+            { "none", ENoCompression },
+            { "rle", ERle },
+            { "zip", EZip },
+            { "piz", EPiz },
+        });
     }
 
     /// @brief Sets the folder the image will be stored in if no explicit path
@@ -64,6 +116,9 @@ public:
     void setBasePath(const std::filesystem::path &basePath) {
         m_basePath = basePath;
     }
+    /// @brief Returns the folder the image will be stored in if no explicit
+    /// path is given.
+    const std::filesystem::path &basePath() const { return m_basePath; }
 
     /// @brief Copies the data and resolution from another image, but leaves all
     /// other attributes the same.
@@ -72,13 +127,34 @@ public:
         m_data       = image.m_data;
     }
 
+    /// @brief Returns the type used to store pixel values when saving.
+    Precision precision() const { return m_precision; }
+    /// @brief Sets the type used to store pixel values when saving.
+    void setPrecision(Precision precision) { m_precision = precision; }
+    /// @brief Returns the compression used when saving.
+    Compression compression() const { return m_compression; }
+    /// @brief Sets the compression used when saving.
+    void setCompression(Compression compression) { m_compression = compression; }
+
     /**
      * @brief Loads the data and resolution from a file with a given path,
      * optionally performing an inverse sRGB transform when @c isLinearSpace is
-     * set to false.
+     * set to false. For EXR files, a @c layer other than the default one can be
+     * selected by name.
      */
     void loadImage(const std::filesystem::path &path,
-                   bool isLinearSpace = false);
+                   bool isLinearSpace = false,
+                   const std::string &layer = "");
+
+    /**
+     * @brief Decodes the given image files in parallel, so that later calls
+     * to @ref loadImage for them only need to take the decoded pixels.
+     * Files that cannot be decoded are skipped, and report their error once
+     * they are actually loaded.
+     */
+    static void preload(std::span<const Source> sources);
+    /// @brief Frees all preloaded images that have not been loaded.
+    static void discardPreloaded();
 
     /// @brief Changes the resolution and sets all pixels to black.
     void initialize(const Point2i &resolution) {
@@ -87,12 +163,23 @@ public:
         std::fill(m_data.begin(), m_data.end(), Color());
     }
 
-    /// @brief Saves the image as an EXR file at a given path.
-    void saveAt(const std::filesystem::path &path) const;
+    /**
+     * @brief Saves the image as an EXR file at a given path, optionally with
+     * additional layers (which need to have the same resolution).
+     * The pixels are copied right away, and the file is compressed and written
+     * in the background.
+     */
+    void saveAt(const std::filesystem::path &path,
+                std::span<const Layer> layers = {}) const;
 
     /// @brief Saves the image at its default path, given by the @ref basePath
     /// of this image and its @ref id .
-    void save() const { saveAt(m_basePath / (id() + ".exr")); }
+    void save(std::span<const Layer> layers = {}) const {
+        saveAt(m_basePath / (id() + ".exr"), layers);
+    }
+
+    /// @brief Blocks until all images that are being saved have been written.
+    static void waitForPendingSaves();
 
     /// @brief Multiplies the color of all pixels component-wise by a given
     /// scalar.
@@ -107,6 +107,7 @@ public:
 
     /**
      * @brief Samples a point in world coordinates on the surface of this instance.
+     * The density of the sample matches the @c pdf that intersections with this instance report for the same point.
      * @param rng A random number generator used to steer sampling decisions.
      */
     AreaSample sampleArea(Sampler& rng) const override;
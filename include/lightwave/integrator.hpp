@@ -6,14 +6,19 @@
 #pragma once
 
 #include <lightwave/core.hpp>
+#include <lightwave/bsdf.hpp>
 #include <lightwave/color.hpp>
+#include <lightwave/film.hpp>
 #include <lightwave/math.hpp>
 #include <lightwave/sampler.hpp>
 #include <lightwave/image.hpp>
+#include <lightwave/light.hpp>
 #include <lightwave/scene.hpp>
 
 namespace lightwave {
 
+class Streaming;
+
 /**
  * @brief Integrators are rendering algorithms that take a scene and produce an image from them (e.g., using path tracing).
  * The term integrator refers to the key challenge of simulating light transport, namely solving the reflected radiance integral.
@@ -37,6 +42,103 @@ protected:
     ref<Image> m_image;
     /// @brief The scene that should be rendered.
     ref<Scene> m_scene;
+    /// @brief Accumulates the samples into the output image (and any AOV images), using a reconstruction filter.
+    ref<Film> m_film;
+    /**
+     * @brief An optional image that records the cost of each pixel, summed over all samples: the wall-clock time in
+     * microseconds (red), the number of rays traced (green) and the number of BVH nodes visited (blue).
+     * It is saved next to the output image, with @c _cost appended to its id.
+     */
+    ref<Image> m_costImage;
+
+    /// @brief Initializes the output image (and the cost and AOV images, if enabled) to the resolution of the camera.
+    void initializeImages();
+    /// @brief Saves the output image (and the cost and AOV images, if enabled).
+    void saveImages();
+
+    /**
+     * @brief Computes all pixels of the (already initialized) output image with the given number of samples per pixel.
+     * Integrators that render in multiple passes (e.g., to learn about the scene first) can pass the number of samples
+     * taken in previous passes as @c firstSampleIndex , so that every pass uses fresh random numbers.
+     * @param stream If given, finished blocks are streamed to the image viewer.
+     */
+    void render(int samplesPerPixel, int firstSampleIndex = 0, Streaming *stream = nullptr);
+
+    /**
+     * @brief Hands the intersection of the camera ray passed to @ref Li over to @ref evaluateAovs , which otherwise has
+     * to trace the camera ray a second time. Integrators should call this with the result of intersecting the camera
+     * ray (whether or not a surface was hit); this is cheap if no AOVs are recorded.
+     */
+    static void recordPrimaryHit(const Intersection &its);
+
+    /**
+     * @brief Returns the density with which multiple importance sampling weights a direction @c wi produced by Bsdf
+     * sampling with density @c pdf (already multiplied by the number of Bsdf samples taken at the vertex).
+     * Directions for which the Bsdf evaluates to zero cannot be found by next-event estimation, hence Bsdf sampling
+     * keeps the full weight for them (denoted by an infinite density).
+     */
+    static float misBsdfPdf(const Intersection &its, const Vector &wi, float pdf) {
+        return std::isinf(pdf) || its.pdfBsdf(wi) > 0 ? pdf : Infinity;
+    }
+
+    /**
+     * @brief Returns the weight of emission that has been hit by a ray leaving @c origin , which next-event estimation
+     * at @c origin might also have sampled.
+     * @param bsdfPdf The density of the ray as given by @ref misBsdfPdf (infinite for camera rays).
+     * @param lightSamples The number of light samples taken at @c origin .
+     * @param intersectableLights Whether next-event estimation also samples lights that can be intersected (see
+     * @ref Scene::hasLights ).
+     */
+    float misWeightEmission(const Point &origin, const Intersection &its, float bsdfPdf, int lightSamples,
+                            bool intersectableLights = false) const {
+        return powerHeuristic(bsdfPdf, lightSamples * m_scene->lightPdf(origin, its, intersectableLights));
+    }
+
+    /// @brief Returns the weight of the background seen by a ray leaving @c origin (see @ref misWeightEmission ).
+    float misWeightBackground(const Point &origin, const Vector &direction, float bsdfPdf, int lightSamples,
+                              bool intersectableLights = false) const {
+        if (!m_scene->hasBackground()) return 1;
+        return powerHeuristic(bsdfPdf, lightSamples * m_scene->lightPdf(
+                origin, m_scene->background(), direction, intersectableLights));
+    }
+
+    /**
+     * @brief Takes a single sample of next-event estimation at a surface: picks a light, samples a point on it and
+     * traces a shadow ray towards it. Lights that can also be hit by Bsdf sampling are weighted with multiple
+     * importance sampling.
+     * @param lightSamples The number of light samples taken at the vertex (the estimate is not divided by it).
+     * @param intersectableLights Whether lights that can be intersected are also sampled (see @ref Scene::hasLights ).
+     * @param bsdfPdf Returns the density of Bsdf sampling at the vertex producing a given direction, already multiplied
+     * by the number of Bsdf samples taken at the vertex.
+     * @returns The radiance reflected towards the ray that hit the surface, without the throughput of the path.
+     */
+    template <typename BsdfPdf>
+    Color estimateDirectLight(const Intersection &its, Sampler &rng, int lightSamples, bool intersectableLights,
+                              BsdfPdf &&bsdfPdf) const {
+        if (!m_scene->hasLights(intersectableLights)) {
+            return Color::black();
+        }
+
+        const LightSample sampledLight = m_scene->sampleLight(its.position, rng, intersectableLights);
+        if (sampledLight.isInvalid()) {
+            return Color::black();
+        }
+        const DirectLightSample sampledLightPoint = sampledLight.light->sampleDirect(its.position, rng);
+        if (sampledLightPoint.isInvalid()) {
+            return Color::black();
+        }
+
+        if (m_scene->intersect(Ray(its.position, sampledLightPoint.wi), sampledLightPoint.distance, rng)) {
+            return Color::black();
+        }
+
+        const BsdfEval bsdfEval = its.evaluateBsdf(sampledLightPoint.wi);
+        const float misWeight = sampledLight.light->canBeIntersected()
+            ? powerHeuristic(lightSamples * sampledLight.probability * sampledLightPoint.pdf,
+                             bsdfPdf(sampledLightPoint.wi))
+            : 1.0f;
+        return sampledLightPoint.weight * bsdfEval.value * misWeight / sampledLight.probability;
+    }
 
 public:
     SamplingIntegrator(const Properties &properties)
@@ -44,6 +146,13 @@ public:
         m_sampler = properties.getChild<Sampler>();
         m_image = properties.getOptionalChild<Image>();
         m_scene = properties.getChild<Scene>();
+        m_film = properties.getOptionalChild<Film>();
+        if (!m_film) {
+            m_film = std::make_shared<Film>();
+        }
+        if (properties.get<bool>("costImage", false)) {
+            m_costImage = std::make_shared<Image>();
+        }
     }
 
     /// @brief Sets the output image that should be populated by rendering.
@@ -55,17 +164,28 @@ public:
     Scene *scene() { return m_scene.get(); }
     /// @brief Gets the random number generator that steers the sampling decisions. 
     Sampler *sampler() { return m_sampler.get(); }
+    /// @brief Gets the film that accumulates the samples into the output image and the AOV images.
+    Film *film() { return m_film.get(); }
 
     /// @brief Computes all pixels of the image by constructing camera rays for them and invoking the @ref Li method.
     void execute() override;
     
     /**
-     * @brief Returns (an estimate of) the incident radiance for a given ray.
+     * @brief Returns (an estimate of) the incident radiance for a given ray (with differentials for camera rays).
      * By default, the integrator will take care of looping over all pixels, constructing camera rays for each of them,
      * and then invoking this method to determine the pixel values. If you need to customize this process, override the
      * @ref execute function of the integrator.
      */
-    virtual Color Li(const Ray &ray, Sampler &rng) = 0;
+    virtual Color Li(const RayDifferential &ray, Sampler &rng) = 0;
+
+    /**
+     * @brief Computes the AOVs recorded by the film for a camera ray, in the order given by @ref Film::aovs .
+     * The default implementation provides the quantities of @ref Film::AovType from the first surface hit by the ray
+     * (leaving black for rays that escape the scene), integrators can override this method to provide custom channels.
+     * @param primary The intersection of the camera ray, if @ref Li has recorded it via @ref recordPrimaryHit .
+     * @param aovs The values of the AOVs, initialized to black.
+     */
+    virtual void evaluateAovs(const RayDifferential &ray, const Intersection *primary, Sampler &rng, Color *aovs);
 };
 
 }
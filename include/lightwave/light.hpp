@@ -9,6 +9,8 @@
 #include <lightwave/color.hpp>
 #include <lightwave/math.hpp>
 
+#include <optional>
+
 namespace lightwave {
 
 /// @brief The result of sampling a light from a given query point using @ref Light::sampleDirect .
@@ -19,6 +21,9 @@ struct DirectLightSample {
     Color weight;
     /// @brief The distance from the query point to the sampled point on the light source.
     float distance;
+    /// @brief The probability density of sampling @c wi (in solid angle), which is infinite for lights that can only be
+    /// reached from a single direction (e.g., point lights).
+    float pdf;
 
     /// @brief Return an invalid sample, used to denote that sampling has failed.
     static DirectLightSample invalid() {
@@ -26,6 +31,7 @@ struct DirectLightSample {
             .wi = Vector(),
             .weight = Color(),
             .distance = 0,
+            .pdf = 0,
         };
     }
 
@@ -35,6 +41,36 @@ struct DirectLightSample {
     }
 };
 
+/**
+ * @brief Conservatively bounds the emission of one or multiple light sources in space and direction, which allows
+ * estimating their contribution to a point without looking at the individual lights.
+ * The directions into which light is emitted are given by the normal directions, which lie within a cone around
+ * @c w with spread @c cosThetaO , plus the angle @c cosThetaE that emission can deviate from the normals.
+ * @see "Importance Sampling of Many Lights with Adaptive Tree Splitting" (Conty Estevez and Kulla, 2018)
+ */
+struct LightBounds {
+    /// @brief The region of space containing all emitting points.
+    Bounds bounds;
+    /// @brief The (estimated) total power emitted.
+    float phi = 0;
+    /// @brief The central direction of the cone bounding the surface normals.
+    Vector w = Vector(0, 0, 1);
+    /// @brief The cosine of the spread of the normal cone (-1 if normals can point anywhere).
+    float cosThetaO = -1;
+    /// @brief The cosine of the maximum angle between a surface normal and a direction light is emitted in.
+    float cosThetaE = 0;
+    /// @brief Whether light is emitted on both sides of the surfaces.
+    bool twoSided = false;
+
+    /// @brief Bounds the emission of two sets of lights.
+    static LightBounds merge(const LightBounds &a, const LightBounds &b);
+    /**
+     * @brief Estimates how much the bounded lights contribute to a given point, which is an upper bound that
+     * accounts for distance and orientation of the lights.
+     */
+    float importance(const Point &origin) const;
+};
+
 /**
  * @brief A light source that can be sampled for direct connections.
  * Some light sources can also be intersected by rays (e.g., area lights or the background light),
@@ -51,6 +87,41 @@ public:
 
     /// @brief Returns whether this light source can be hit by rays (i.e., has an area that has been placed within the scene).
     virtual bool canBeIntersected() const { return false; }
+
+    /**
+     * @brief Returns whether this light source should be sampled by next-event estimation.
+     * Lights that cannot be intersected must always be sampled. Lights that can also be hit by rays only support
+     * sampling if they can report the density of their samples via @ref pdf , so that integrators can combine both
+     * strategies using multiple importance sampling.
+     */
+    virtual bool canBeSampled() const { return !canBeIntersected(); }
+
+    /**
+     * @brief Returns the probability density (in solid angle) of @ref sampleDirect producing the direction @c wi
+     * when sampling from @c origin . Lights that can only be reached from a single direction report zero.
+     */
+    virtual float pdf(const Point &origin, const Vector &wi) const { return 0; }
+
+    /**
+     * @brief Returns the probability density (in solid angle) of @ref sampleDirect producing the point @c its that
+     * a ray from @c origin has found on the surface of this light. Only lights that can be intersected report
+     * non-zero densities.
+     */
+    virtual float pdf(const Point &origin, const Intersection &its) const { return 0; }
+
+    /**
+     * @brief Estimates the total power emitted by the light source (as luminance), which is used to pick lights
+     * proportional to their contribution. The estimate only steers sampling, so it does not need to be exact.
+     * @param sceneBounds The bounding box of the scene, needed for lights that are infinitely far away.
+     * @param rng A random number generator for lights that estimate their power stochastically.
+     */
+    virtual float estimatePower(const Bounds &sceneBounds, Sampler &rng) const { return 1; }
+
+    /**
+     * @brief Returns the spatial and directional bounds of the emission, or nothing if the light is infinitely far away.
+     * The power @c phi of the returned bounds does not need to be set, it will be filled in using @ref estimatePower .
+     */
+    virtual std::optional<LightBounds> getLightBounds() const { return std::nullopt; }
 };
 
 /// @brief The result of evaluating a @ref BackgroundLight for a incident direction.
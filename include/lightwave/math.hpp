@@ -11,6 +11,8 @@
 #include <cmath>
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstdint>
 #include <optional>
 #include <utility>
 
@@ -32,6 +34,8 @@ static constexpr float Pi2    = 1.57079632679489661923f;
 static constexpr float Pi4    = 0.78539816339744830961f;
 /// @brief sqrt(2)
 static constexpr float Sqrt2  = 1.41421356237309504880f;
+/// @brief ln(2), converts base-2 logarithms into natural logarithms
+static constexpr float Ln2    = 0.69314718055994530942f;
 
 /// @brief Multiply by this constant to convert degrees into radians.
 static constexpr float Deg2Rad = Pi / 180.0f;
@@ -84,6 +88,53 @@ inline float safe_sqrt(float v) { return v <= 0 ? 0 : std::sqrt(v); }
  */
 inline float safe_acos(float v) { return std::acos(clamp(v, -1, +1)); }
 
+/**
+ * @brief The power heuristic (with an exponent of two) for multiple importance sampling, i.e., the weight of a sample
+ * drawn with density @c pdfA when the same integrand is also estimated with a strategy of density @c pdfB .
+ * @note Infinite densities denote delta distributions, which cannot be produced by any other strategy.
+ */
+inline float powerHeuristic(float pdfA, float pdfB) {
+    if (std::isinf(pdfA)) return 1;
+    if (std::isinf(pdfB) || !(pdfA > 0)) return 0;
+    return 1 / (1 + sqr(pdfB / pdfA));
+}
+
+/**
+ * @brief Approximates @code log2(v) @endcode for positive finite @c v , within 4 ulps of the exact result (and with
+ * an absolute error below 2e-7 for @c v within [0.5, 2]).
+ * Unlike @c std::log2 , this compiles to straight-line code, which allows compilers to vectorize loops calling it.
+ */
+inline float fast_log2(float v) {
+    // split v into 2^exponent * mantissa, with the mantissa in [sqrt(1/2), sqrt(2))
+    const int32_t bits = std::bit_cast<int32_t>(v);
+    const int32_t exponent = (bits - 0x3f3504f3) >> 23;
+    const float mantissa = std::bit_cast<float>(bits - (exponent << 23));
+    // log2(m) = 2 / ln(2) * atanh(u) with u = (m - 1) / (m + 1), where |u| < 0.172 lets the series converge quickly
+    const float u = (mantissa - 1) / (mantissa + 1);
+    const float u2 = u * u;
+    return float(exponent) + u * (2.88539008f + u2 * (0.96179669f + u2 * (0.57707802f + u2 * 0.41219858f)));
+}
+
+/**
+ * @brief Approximates @code 2^v @endcode with a relative error below 3e-7, where @c v is clamped to [-126, 127] (the
+ * range of normal floats). Like @ref fast_log2 , this can be vectorized by compilers.
+ */
+inline float fast_exp2(float v) {
+    v = clamp(v, -126, 127);
+    // split v into an integer part (which goes into the exponent bits) and a fraction in [0, 1)
+    const int32_t integer = int32_t(v) - (v < float(int32_t(v)));
+    const float fraction = v - float(integer);
+    const float power = 1 + fraction * (0.69314758f + fraction * (0.24020687f + fraction * (0.05565866f +
+                            fraction * (0.00919680f + fraction * 0.00178967f))));
+    return power * std::bit_cast<float>((integer + 127) << 23);
+}
+
+/**
+ * @brief Approximates @code pow(base, exponent) @endcode for positive @c base using @ref fast_log2 and @ref fast_exp2 .
+ * The relative error is below @code 3e-7 * (1 + |exponent * log2(base)|) @endcode .
+ */
+inline float fast_pow(float base, float exponent) { return fast_exp2(exponent * fast_log2(base)); }
+
 // MARK: - points and vectors
 
 #define BUILD1(expr) \
@@ -632,6 +683,41 @@ struct Ray {
     }
 };
 
+/**
+ * @brief A ray along with rays that are offset by one pixel in x and y direction on the image plane, which describe
+ * the footprint of a pixel (see "Tracing Ray Differentials" [Igehy 1999]). Integrators that take many samples per pixel
+ * shrink the footprint (see @ref scaleDifferentials ).
+ * Rays that did not originate from the camera or only underwent specular bounces carry no differentials.
+ */
+struct RayDifferential : public Ray {
+    /// @brief The origin of the ray offset by one pixel in x direction.
+    Point originX;
+    /// @brief The origin of the ray offset by one pixel in y direction.
+    Point originY;
+    /// @brief The (normalized) direction of the ray offset by one pixel in x direction.
+    Vector directionX;
+    /// @brief The (normalized) direction of the ray offset by one pixel in y direction.
+    Vector directionY;
+    /// @brief Whether the offset rays are known.
+    bool hasDifferentials = false;
+
+    RayDifferential() = default;
+    RayDifferential(const Ray &ray) : Ray(ray) {}
+
+    /**
+     * @brief Moves the offset rays towards the ray, such that they describe a footprint that is @c scale times the
+     * size of a pixel.
+     */
+    void scaleDifferentials(float scale) {
+        if (!hasDifferentials)
+            return;
+        originX = origin + scale * (originX - origin);
+        originY = origin + scale * (originY - origin);
+        directionX = (direction + scale * (directionX - direction)).normalized();
+        directionY = (direction + scale * (directionY - direction)).normalized();
+    }
+};
+
 /**
  * @brief Defines shading frames and common trigonometrical functions used within them.
  * In lightwave, we follow the convention that material functions (sampling and evaluation of Bsdfs and Emissions) happen
@@ -730,15 +816,38 @@ struct Vertex {
     }
 };
 
+/**
+ * @brief Texture coordinates along with their footprint, i.e., how much they change towards neighboring pixels, which
+ * allows textures to filter out details that are too small to be resolved.
+ */
+struct TexCoord : public Point2 {
+    /// @brief The change of the texture coordinates towards the next pixel in x direction (zero if unknown).
+    Vector2 dx;
+    /// @brief The change of the texture coordinates towards the next pixel in y direction (zero if unknown).
+    Vector2 dy;
+
+    TexCoord() = default;
+    TexCoord(const Point2 &uv) : Point2(uv) {}
+    TexCoord(float u, float v) : Point2(u, v) {}
+};
+
 /// @brief A point on a surface along with context about the orientation of the surface.
 struct SurfaceEvent {
     /// @brief The position of the surface point.
     Point position;
     /// @brief The texture coordinates of the surface for the given position.
-    Point2 uv;
+    TexCoord uv;
     /// @brief The shading frame of the surface at the given position.
     Frame frame;
-    /// @brief The probability of sampling the point when doing area sampling, in area units.
+    /**
+     * @brief The partial derivatives of the position with respect to the texture coordinates, which relate distances on
+     * the surface to distances in texture space (zero if the shape does not provide them).
+     */
+    Vector dpdu, dpdv;
+    /**
+     * @brief The probability of sampling the point when doing area sampling, in area units.
+     * Shapes also report this for intersections, which allows weighting rays that hit area lights by chance.
+     */
     float pdf;
     /// @brief The instance object associated with the surface.
     const Instance *instance = nullptr;
@@ -759,6 +868,8 @@ struct Intersection : public SurfaceEvent {
         int bvhCounter = 0;
         /// @brief The number of shapes that have been tested for intersection.
         int primCounter = 0;
+        /// @brief The number of times an alpha mask has been evaluated.
+        int alphaCounter = 0;
     } stats;
 
     explicit Intersection(const Vector& wo = Vector(), float t = Infinity, ref<Texture> alphaMask = nullptr)
@@ -778,6 +889,21 @@ struct Intersection : public SurfaceEvent {
     BsdfSample sampleBsdf(Sampler &rng) const;
     /// @brief Evaluates the Bsdf of the underlying surface.
     BsdfEval evaluateBsdf(const Vector &wi) const;
+    /// @brief Returns the probability density of @ref sampleBsdf producing the given direction (in world coordinates).
+    float pdfBsdf(const Vector &wi) const;
+
+    /**
+     * @brief Computes the footprint of the texture coordinates ( @c uv.dx and @c uv.dy ) from the differentials of the
+     * ray that found this intersection, by intersecting its offset rays with the tangent plane of the surface.
+     */
+    void computeDifferentials(const RayDifferential &ray);
+    /**
+     * @brief Returns a ray that continues from this intersection in direction @c wi , which keeps the differentials of
+     * the incoming @c ray (that found this intersection) if @c wi was sampled by a specular (delta) reflection or
+     * refraction. The offset rays follow the same reflection or refraction at the tangent plane, i.e., the curvature
+     * of the surface is ignored.
+     */
+    RayDifferential spawnRay(const RayDifferential &ray, const Vector &wi, bool specular) const;
 };
 
 /// @brief Print a given point to an output stream.
@@ -5,8 +5,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <lightwave/color.hpp>
 #include <lightwave/logger.hpp>
@@ -19,6 +22,19 @@
 
 namespace lightwave {
 
+/// @brief The number of threads requested via @ref setThreadCount , or zero to use all available cores.
+inline std::atomic<int> requestedThreadCount = 0;
+
+/// @brief The number of threads used by @ref for_each_parallel , which defaults to the number of available cores.
+inline int threadCount() {
+    const int count = requestedThreadCount;
+    return count > 0 ? count : std::max(int(std::thread::hardware_concurrency()), 1);
+}
+
+/// @brief Limits the number of threads used by @ref for_each_parallel (e.g., when several renders share a machine),
+/// or restores the default when given zero.
+inline void setThreadCount(int count) { requestedThreadCount = count; }
+
 /// @brief Invokes @c f for each element of the iterator, parallelized across
 /// all available cores.
 template <class ForwardIt, class UnaryFunction>
@@ -30,7 +46,7 @@ void for_each_parallel(ForwardIt first, ForwardIt last, UnaryFunction f) {
 
     std::mutex m_lock;
 
-    const int numThreads = std::thread::hardware_concurrency();
+    const int numThreads = threadCount();
     std::vector<std::thread> m_threads;
     m_threads.reserve(numThreads);
 
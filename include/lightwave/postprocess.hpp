@@ -10,10 +10,34 @@
 #include <lightwave/math.hpp>
 #include <lightwave/image.hpp>
 
+#include <functional>
+#include <span>
+
 namespace lightwave {
 
+/// @brief Global statistics of an image, used by postprocesses that adapt to their input (e.g., tone mapping).
+struct ImageStatistics {
+    /// @brief The luminance of the brightest pixel.
+    float maxLuminance = 0;
+    /// @brief The geometric mean of the luminance of all pixels, often used as the "key" of an image.
+    float logAverageLuminance = 0;
+
+    /**
+     * @brief Gathers the statistics of an image in parallel.
+     * @param transform If given, is applied to each row of pixels before it is measured, which allows measuring the
+     * result of pointwise postprocesses without storing it.
+     */
+    static ImageStatistics gather(const Image &image, const std::function<void(Color *, int)> &transform = nullptr);
+};
+
 /**
  * @brief Post processes alter an input image to produce an improved output image (e.g., tonemapping or denoising).
+ * Images are passed between postprocesses by reference, so chains of postprocesses work in memory, and only outputs
+ * that are not marked with @c save="false" are written to disk.
+ *
+ * Postprocesses that transform each pixel independently of all others (e.g., exposure or tone mapping) are called
+ * pointwise, and only need to implement @ref apply . The @c pipeline postprocess fuses consecutive pointwise
+ * postprocesses into a single pass over the image.
  */
 class Postprocess : public Executable {
 protected:
@@ -21,12 +45,46 @@ protected:
     ref<Image> m_input;
     /// @brief The output image that will be produced.
     ref<Image> m_output;
+    /// @brief Whether the output image is saved, as opposed to only being passed on to other postprocesses.
+    bool m_save;
 
 public:
     Postprocess(const Properties &properties) {
-        m_input = properties.get<Image>("input");
-        m_output = properties.getChild<Image>();
+        // stages of a pipeline receive their images from the pipeline instead
+        m_input = properties.get<Image>("input", ref<Image>());
+        m_output = properties.getOptionalChild<Image>();
+        m_save = properties.get<bool>("save", true);
     }
+
+    /// @brief Sets the output image that will be produced.
+    void setOutput(const ref<Image> &output) { m_output = output; }
+    /// @brief Gets the output image that will be produced.
+    Image *output() { return m_output.get(); }
+
+    /// @brief Processes the input image into the output image, and saves the output unless disabled.
+    void execute() override;
+
+    /**
+     * @brief Processes an image, where @c output has already been initialized to the resolution of @c input .
+     * The default implementation applies pointwise postprocesses row by row in parallel.
+     */
+    virtual void process(const Image &input, Image &output);
+
+    /// @brief Whether this postprocess transforms each pixel independently of all others, see @ref apply .
+    virtual bool isPointwise() const { return false; }
+    /// @brief Whether this (pointwise) postprocess needs to be prepared with the statistics of its input.
+    virtual bool needsStatistics() const { return false; }
+    /// @brief Adapts this (pointwise) postprocess to the statistics of the image it is about to be applied to.
+    virtual void prepare(const ImageStatistics &statistics) {}
+    /// @brief Transforms a row of pixels in place (only for pointwise postprocesses).
+    virtual void apply(Color *pixels, int count) const {}
+
+    /**
+     * @brief Applies a sequence of pointwise postprocesses in a single parallel pass, without storing intermediate
+     * images. Postprocesses that need statistics are prepared with the statistics of their input, which is measured
+     * by applying the preceding postprocesses on the fly. @c input and @c output may refer to the same image.
+     */
+    static void applyPointwise(const Image &input, Image &output, std::span<Postprocess *const> stages);
 };
 
 }
@@ -63,4 +63,6 @@ private:
 #define REGISTER_GROUP(Class, Name) REGISTER_CLASS(Class, "group", Name)
 #define REGISTER_LIGHT(Class, Name) REGISTER_CLASS(Class, "light", Name)
 #define REGISTER_POSTPROCESS(Class, Name) REGISTER_CLASS(Class, "postprocess", Name)
+#define REGISTER_FILTER(Class, Name) REGISTER_CLASS(Class, "filter", Name)
 #define REGISTER_TEST(Class, Name) REGISTER_CLASS(Class, "test", Name)
+#define REGISTER_BENCHMARK(Class, Name) REGISTER_CLASS(Class, "benchmark", Name)
@@ -17,11 +17,56 @@ namespace lightwave {
  * While all samplers are expected to produce uniformly distributed random numbers, they can still differ
  * in how they correlate samples, e.g., some samplers try to cover the space of random numbers more evenly by
  * by avoiding placing samples close to previous samples.
+ *
+ * Random numbers are drawn in blocks of consecutive dimensions by @ref generate , which lets samplers produce them in
+ * bulk (e.g., vectorized across multiple lanes). @ref next and @ref next2D only read from the current block, hence the
+ * calls made throughout rendering are inlined and only every block costs a virtual call.
  */
 class Sampler : public Object {
+public:
+    /// @brief The largest number of dimensions that a block can hold.
+    static constexpr int MaxBlockSize = 16;
+
 protected:
     /// @brief The number of samples that should be taken per pixel.
     int m_samplesPerPixel;
+    /**
+     * @brief Whether the sampler stratifies pairs of dimensions jointly, in which case @ref next2D always uses a pair
+     * that starts at an even dimension (skipping a dimension if necessary).
+     */
+    bool m_stratifiesPairs = false;
+
+    /**
+     * @brief Fills @c values with the random numbers of the next dimensions of the current sample, at most
+     * @ref MaxBlockSize of them, and returns how many have been generated. Samplers for which random numbers are
+     * expensive should only generate a single pair, since numbers of the block that are not consumed before the next
+     * call to @ref seed are discarded.
+     * @note The number of generated dimensions must be even, such that every pair of dimensions that starts at an even
+     * dimension lies within a single block (see @ref m_stratifiesPairs ).
+     */
+    virtual int generate(float *values) = 0;
+
+    /**
+     * @brief Starts the random number sequence of @ref seed(int) , after the block of the previous sequence has
+     * already been discarded.
+     */
+    virtual void reseed(int index) = 0;
+    /// @brief Starts the random number sequence of @ref seed(const Point2i &, int) (see @ref reseed(int) ).
+    virtual void reseed(const Point2i &pixel, int sampleIndex) = 0;
+
+private:
+    /// @brief The random numbers of the current block.
+    float m_block[MaxBlockSize];
+    /// @brief The index of the next dimension of the current block that will be consumed.
+    int m_blockPosition = 0;
+    /// @brief The number of dimensions in the current block.
+    int m_blockSize = 0;
+
+    /// @brief Discards the current block and starts the next one.
+    void nextBlock() {
+        m_blockSize = generate(m_block);
+        m_blockPosition = 0;
+    }
 
 public:
     Sampler() : m_samplesPerPixel(0) {}
@@ -30,10 +75,25 @@ public:
     }
 
     /// @brief Generates a single random number in the interval [0,1). 
-    virtual float next() = 0;
-    /// @brief Generates a random point in the unit square [0,1)^2. 
-    virtual Point2 next2D() {
-        return { next(), next() };
+    float next() {
+        if (m_blockPosition >= m_blockSize) {
+            nextBlock();
+        }
+        return m_block[m_blockPosition++];
+    }
+    /// @brief Generates a random point in the unit square [0,1)^2.
+    Point2 next2D() {
+        if (m_stratifiesPairs) {
+            m_blockPosition += m_blockPosition & 1;
+        }
+        if (m_blockPosition + 1 >= m_blockSize) {
+            // the point spans two blocks (or starts a new one)
+            const float x = next();
+            return { x, next() };
+        }
+        const Point2 result = { m_block[m_blockPosition], m_block[m_blockPosition + 1] };
+        m_blockPosition += 2;
+        return result;
     }
 
     /**
@@ -41,18 +101,26 @@ public:
      * @note When identical samplers are given the same seed, they are expected to produce the same sequence
      * of random numbers. For different seeds, they are expected to give different random sequences.
      */
-    virtual void seed(int index) = 0;
+    void seed(int index) {
+        m_blockPosition = m_blockSize = 0;
+        reseed(index);
+    }
     /**
      * @brief Initiates a random number sequence characterized for the given pixel and sample per pixel index.
      * @note When identical samplers are given the same seed, they are expected to produce the same sequence
      * of random numbers. For different seeds, they are expected to give different random sequences.
      */
-    virtual void seed(const Point2i &pixel, int sampleIndex) = 0;
+    void seed(const Point2i &pixel, int sampleIndex) {
+        m_blockPosition = m_blockSize = 0;
+        reseed(pixel, sampleIndex);
+    }
     /// @brief Returns an identical copy of the sampler, e.g., for use in different threads. 
     virtual ref<Sampler> clone() const = 0;
 
     /// @brief Returns the number of samples that should be taken per pixel. 
     int samplesPerPixel() const { return m_samplesPerPixel; }
+    /// @brief Overrides the number of samples that should be taken per pixel, e.g., for interactive previews.
+    void setSamplesPerPixel(int samplesPerPixel) { m_samplesPerPixel = samplesPerPixel; }
 };
 
 }
@@ -6,6 +6,8 @@
 #pragma once
 
 #include <lightwave/core.hpp>
+#include <lightwave/distribution.hpp>
+#include <unordered_map>
 #include <vector>
 
 namespace lightwave {
@@ -16,10 +18,37 @@ struct LightSample {
     const Light *light;
     /// @brief The probability of this light source having been picked.
     float probability;
+
+    /// @brief Returns an invalid sample, used when no light can contribute to the query point.
+    static LightSample invalid() {
+        return {
+            .light = nullptr,
+            .probability = 0,
+        };
+    }
+
+    /// @brief Tests whether the sample is invalid (i.e., no light has been picked).
+    bool isInvalid() const {
+        return light == nullptr;
+    }
 };
 
+class LightBVH;
+
 /// @brief Scenes are the input to rendering algorithms: They contain all geometry, materials, lights and the camera.
 class Scene : public Object {
+public:
+    /// @brief The strategies for picking a light source for next-event estimation.
+    enum class LightSelection {
+        /// @brief Every light is picked with the same probability.
+        Uniform,
+        /// @brief Lights are picked proportional to their estimated power.
+        Power,
+        /// @brief Lights are picked proportional to their estimated contribution to the shading point using a light BVH.
+        BVH,
+    };
+
+private:
     /// @brief The camera from which the image is to be rendered.
     ref<Camera> m_camera;
     /// @brief The geometry of the scene that should be rendered (typically an acceleration structure with instances in it).
@@ -32,6 +61,35 @@ class Scene : public Object {
      */
     std::vector<ref<Light>> m_lights;
 
+    /// @brief A set of lights that next-event estimation picks from, together with the structures used to pick them.
+    struct LightSet {
+        /// @brief The lights that can be picked.
+        std::vector<const Light *> lights;
+        /// @brief Picks one of @ref lights , proportional to its estimated power (or uniformly, if requested).
+        AliasTable selection;
+        /// @brief The probability of @ref selection picking a given light, used to look up probabilities by light.
+        std::unordered_map<const Light *, float> probabilities;
+        /// @brief Organizes the lights with spatial bounds for @ref LightSelection::BVH (nullptr otherwise).
+        ref<LightBVH> bvh;
+        /// @brief The lights without spatial bounds (e.g., directional lights), which the light BVH cannot hold.
+        std::vector<const Light *> infiniteLights;
+    };
+    /**
+     * @brief The lights sampled by next-event estimation, without (index 0) and with (index 1) the lights that can
+     * also be intersected (see @ref Light::canBeSampled and @ref Light::canBeIntersected ).
+     */
+    LightSet m_lightSets[2];
+
+    /// @brief The strategy used to pick lights for next-event estimation.
+    LightSelection m_lightSelectionStrategy;
+
+    /// @brief Builds a light set over all lights that can be sampled (and those that can be intersected, if requested).
+    void buildLightSet(LightSet &set, bool intersectableLights);
+    /// @brief Returns the lights that are picked from with or without the lights that can be intersected.
+    const LightSet &lightSet(bool intersectableLights) const { return m_lightSets[intersectableLights]; }
+    /// @brief Returns the probability of picking one of the infinite lights instead of descending the light BVH.
+    static float infiniteLightProbability(const LightSet &set);
+
 public:
     Scene(const Properties &properties);
     std::string toString() const override;
@@ -46,14 +104,46 @@ public:
     /// @brief Evaluates the background illumination for a given direction pointing away from the scene.
     BackgroundLightEval evaluateBackground(const Vector &direction) const;
 
-    /// @brief Reports whether at least one light exists that could be sampled.
-    bool hasLights() const { return !m_lights.empty(); }
+    /**
+     * @brief Reports whether at least one light exists that could be sampled.
+     * @param intersectableLights Whether lights that can also be intersected (such as area lights around visible
+     * instances) are sampled as well. This holds for all methods concerned with light selection: integrators that
+     * pass @c true must weight emission found by Bsdf sampling using multiple importance sampling (see
+     * @ref lightPdf(const Point &, const Intersection &, bool) const ), since both strategies estimate the same light
+     * otherwise.
+     */
+    bool hasLights(bool intersectableLights = false) const { return !lightSet(intersectableLights).selection.empty(); }
     /// @brief Reports whether a background light exists. 
     bool hasBackground() const { return m_background != nullptr; }
-    /// @brief Randomly picks a light from the list of sampleable light sources. 
-    LightSample sampleLight(Sampler &rng) const;
-    /// @brief Returns the probability of randomly picking a light source via @ref sampleLight .
-    float lightSelectionProbability(const Light *light) const;
+    /// @brief Returns the background light of the scene (or nullptr if none exists).
+    const BackgroundLight *background() const { return m_background.get(); }
+    /**
+     * @brief Randomly picks a light from the list of sampleable light sources (see @ref Light::canBeSampled ),
+     * with a probability proportional to its estimated power.
+     */
+    LightSample sampleLight(Sampler &rng, bool intersectableLights = false) const;
+    /// @brief Returns the probability of randomly picking a light source via @ref sampleLight (zero for lights that cannot be sampled).
+    float lightSelectionProbability(const Light *light, bool intersectableLights = false) const;
+    /**
+     * @brief Randomly picks a light from the list of sampleable light sources to illuminate a given point.
+     * When the scene uses a light BVH, lights are picked proportional to their estimated contribution to that point,
+     * otherwise this behaves like @ref sampleLight(Sampler &, bool) const . The returned sample might be invalid if no
+     * light can contribute to the point.
+     */
+    LightSample sampleLight(const Point &origin, Sampler &rng, bool intersectableLights = false) const;
+    /// @brief Returns the probability of randomly picking a light source via @ref sampleLight(const Point &, Sampler &, bool) const .
+    float lightSelectionProbability(const Point &origin, const Light *light, bool intersectableLights = false) const;
+    /**
+     * @brief Returns the probability density (in solid angle) of next-event estimation from @c origin producing the
+     * direction @c wi towards the given light, i.e., the probability of picking the light times the density of the
+     * light sampling that direction. Used to weight rays that hit lights by chance using multiple importance sampling.
+     */
+    float lightPdf(const Point &origin, const Light *light, const Vector &wi, bool intersectableLights = false) const;
+    /**
+     * @brief Returns the probability density (in solid angle) of next-event estimation from @c origin producing the
+     * intersected point on an emissive surface, or zero if its instance is not part of a sampled area light.
+     */
+    float lightPdf(const Point &origin, const Intersection &its, bool intersectableLights = false) const;
     /// @brief Returns the bounding box of the scene geometry.
     Bounds getBoundingBox() const;
 };
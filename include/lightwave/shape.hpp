@@ -55,6 +55,11 @@ public:
      * using a reference.
      */
     virtual void markAsVisible() {}
+    /**
+     * @brief Marks that the shape is the root of the scene geometry, which is not wrapped by an area light itself (only
+     * the instances within it are). Called once by the @ref Scene .
+     */
+    virtual void markAsSceneRoot() {}
 };
 
 }
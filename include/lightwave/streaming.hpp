@@ -8,30 +8,45 @@
 #include <lightwave/core.hpp>
 #include <lightwave/math.hpp>
 
+#include <atomic>
 #include <vector>
 #include <string>
 
 namespace lightwave {
 
-/// @brief A connection to the "tev" image viewer than can be used to send updates to images in real-time.
+/**
+ * @brief A connection to the "tev" image viewer than can be used to send updates to images in real-time.
+ *
+ * Updates are sent by a dedicated sender thread, so that a slow viewer never stalls rendering: @ref updateBlock only
+ * marks a block as dirty in a bounded lock-free queue. The sender periodically collects all dirty blocks, merges
+ * duplicates and sends all channels of each block in a single packet, reading the pixels only at that point (so that
+ * updates that became stale while waiting are never sent). If the queue overflows because the viewer cannot keep up,
+ * individual updates are dropped in favor of sending the entire image once the sender catches up.
+ */
 class Streaming {
     class Stream;
-    struct UpdateThread;
+    class Sender;
 
     const std::vector<std::string> m_channels = { "r", "g", "b" };
     const Image &m_image;
-    std::mutex m_mutex;
-    float m_normalization = 1;
+    std::atomic<float> m_normalization = 1;
 
     std::unique_ptr<Stream> m_stream;
-    std::unique_ptr<UpdateThread> m_updater;
+    /// @brief The sender thread, or null if no viewer is connected.
+    std::unique_ptr<Sender> m_sender;
+
+    /// @brief Appends an update of all channels of a block to a stream (without sending it yet).
+    void writeBlock(Stream &stream, const Bounds2i &block) const;
 
 public:
+    /// @brief The port that tev listens on.
+    static constexpr uint16_t Port = 14158;
+
     Streaming(const Image &image);
 
-    /// @brief Sends a given block of image data (e.g., when a tile has finished rendering).
+    /// @brief Marks a given block of image data for sending (e.g., when a tile has finished rendering), never blocks.
     void updateBlock(const Bounds2i &block);
-    /// @brief Sends the entire image at once.
+    /// @brief Marks the entire image for sending.
     void update();
 
     /// @brief Starts regular updating of the image as background task (e.g., when using a progressive rendering algorithm).
@@ -41,6 +56,12 @@ public:
     /// @brief Requests that the image should be multiplied by a given scalar value before being sent.
     void normalize(float v) { m_normalization = v; }
 
+    /// @brief The number of block updates that were dropped because the sender could not keep up.
+    uint64_t droppedUpdates() const;
+    /// @brief The number of block updates that have been sent so far.
+    uint64_t sentUpdates() const;
+
+    /// @brief Sends all pending updates and disconnects.
     ~Streaming();
 };
 
@@ -0,0 +1,108 @@
+/**
+ * @file telemetry.hpp
+ * @brief Collects performance counters and wall-clock timings of the phases of a render job.
+ */
+
+#pragma once
+
+#include <lightwave/core.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+namespace lightwave {
+
+/**
+ * @brief Collects counters of events that happen during rendering (e.g., rays traced) as well as the wall-clock time
+ * spent in each phase of a render job, which can be exported as JSON (see @ref writeJSON ).
+ * Each thread increments its own set of counters, which avoids contention between threads. Sets of threads that
+ * have exited are handed to new threads, so that counts are never lost and memory does not grow with every render.
+ */
+class Telemetry {
+public:
+    /// @brief The events that are counted.
+    enum Counter {
+        /// @brief Rays generated by the camera.
+        EPrimaryRays,
+        /// @brief Rays for which the closest intersection was found (camera rays and bounces).
+        EClosestHitRays,
+        /// @brief Rays that only test visibility (e.g., towards lights).
+        EShadowRays,
+        /// @brief BVH nodes tested for intersection.
+        EBvhNodes,
+        /// @brief Primitives tested for intersection.
+        EPrimitives,
+        /// @brief Alpha mask evaluations during intersection.
+        EAlphaLookups,
+        /// @brief Image texture evaluations.
+        ETextureFetches,
+        ECounterCount,
+    };
+
+    /// @brief The phases whose wall-clock time is measured. Phases can be nested (e.g., loading meshes while parsing).
+    enum Phase {
+        EParse,
+        EPlyLoad,
+        EImageLoad,
+        EBvhBuild,
+        ERender,
+        ESave,
+        EPhaseCount,
+    };
+
+    /// @brief Measures the time from its construction until its destruction, and adds it to the given phase.
+    class ScopedTimer {
+        Phase m_phase;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        explicit ScopedTimer(Phase phase)
+            : m_phase(phase), m_start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            addTime(m_phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+        }
+    };
+
+    /// @brief Adds to a counter of the calling thread.
+    static void count(Counter counter, uint64_t amount = 1) {
+        if (!s_local)
+            s_local = acquireCounters();
+        // only this thread writes to its counters, hence no atomic read-modify-write is needed
+        auto &value = (*s_local)[counter];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    /// @brief Returns the value of a counter of the calling thread, e.g., to measure the cost of a piece of work.
+    static uint64_t local(Counter counter) {
+        if (!s_local)
+            s_local = acquireCounters();
+        return (*s_local)[counter].load(std::memory_order_relaxed);
+    }
+
+    /// @brief Adds the given number of seconds to the time spent in a phase.
+    static void addTime(Phase phase, double seconds);
+
+    /// @brief Returns the sum of a counter over all threads.
+    static uint64_t total(Counter counter);
+    /// @brief Returns the total number of seconds spent in a phase.
+    static double time(Phase phase);
+
+    /// @brief Resets all counters and timings to zero. Must not be called while rendering.
+    static void reset();
+
+    /// @brief Writes all counters and timings (and derived statistics, such as rays per second) to a JSON file.
+    static void writeJSON(const std::filesystem::path &path, const std::filesystem::path &scenePath);
+
+private:
+    using Counters = std::array<std::atomic<uint64_t>, ECounterCount>;
+
+    /// @brief The counters of the calling thread (or null if the thread has not counted anything yet).
+    static inline thread_local Counters *s_local = nullptr;
+
+    /// @brief Hands a set of counters to the calling thread, which is returned once the thread exits.
+    static Counters *acquireCounters();
+};
+
+} // namespace lightwave
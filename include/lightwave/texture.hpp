@@ -17,19 +17,40 @@ public:
     /**
      * @brief Returns the color at a given texture coordinate.
      * For most applications, the input point will lie in the unit square [0,1)^2, but points outside this
-     * domain are also allowed.
+     * domain are also allowed. Textures may use the footprint of the coordinate (see @ref TexCoord ) to filter out
+     * details that are smaller than a pixel.
      */
-    virtual Color evaluate(const Point2 &uv) const = 0;
+    virtual Color evaluate(const TexCoord &uv) const = 0;
     /**
      * @brief Returns a scalar value at a given texture coordinate.
      * For most applications, the input point will lie in the unit square [0,1)^2, but points outside this
      * domain are also allowed.
      */
-    virtual float scalar(const Point2 &uv) const {
+    virtual float scalar(const TexCoord &uv) const {
         // arbitrary mapping from RGB images to scalar values (typically those will be grayscale anyway and
         // we would ideally have a separate texture interface for scalar values)
         return evaluate(uv).r();
     }
+    /**
+     * @brief Returns the resolution at which the texture stores its data (e.g., the size of an image), which allows
+     * building sampling distributions that resolve all details. Textures without inherent resolution return zero.
+     */
+    virtual Point2i resolution() const {
+        return Point2i(0);
+    }
+
+    /**
+     * @brief Returns whether any texture that has been created filters over the footprint of texture coordinates.
+     * Otherwise, ray differentials (and the derivatives of surfaces needed for them) are of no use and not computed.
+     */
+    static bool anyUsesFootprint() { return s_anyUsesFootprint; }
+
+protected:
+    /// @brief Reports that a texture filters over the footprint of texture coordinates, see @ref anyUsesFootprint .
+    static void markUsesFootprint() { s_anyUsesFootprint = true; }
+
+private:
+    static inline bool s_anyUsesFootprint = false;
 };
 
 }
@@ -48,6 +48,15 @@ inline Vector squareToUniformSphere(const Point2 &sample) {
     return { r * cosPhi, r * sinPhi, z };
 }
 
+/**
+ * @brief Warps a given point from the unit square ([0,0] to [1,1]) to barycentric coordinates that are uniformly
+ * distributed over a triangle (to be used with @ref interpolateBarycentric ).
+ */
+inline Point2 squareToUniformTriangle(const Point2 &sample) {
+    const float su = std::sqrt(sample.x());
+    return { 1 - su, sample.y() * su };
+}
+
 /**
  * @brief Warps a given point from the unit square ([0,0] to [1,1]) to a unit hemisphere (centered around [0,0,0] with radius 1,
  * pointing in z direction), with respect to solid angle.
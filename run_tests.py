@@ -9,6 +9,9 @@ import urllib.parse
 import urllib.request
 import re
 import argparse
+import json
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
 
 parser = argparse.ArgumentParser(description='Test runner for lightwave')
 parser.add_argument('filenames', metavar='tests', type=str, nargs='*', default=["*/*.xml"],
@@ -17,10 +20,22 @@ parser.add_argument('--unsafe', dest='unsafe_tests', action='store_true',
                     help='include unsafe tests')
 parser.add_argument('--disable-build', dest='disable_build', action='store_true',
                     help='do not build lightwave before running the tests')
+parser.add_argument('--build-dir', dest='build_dir', type=str, default=None,
+                    help='the CMake build directory containing lightwave (default: build)')
+parser.add_argument('-j', '--jobs', dest='jobs', type=int, default=1,
+                    help='number of tests to run in parallel, each using an equal share of the cores')
+parser.add_argument('--baseline', dest='baseline', type=str, default=None,
+                    help='performance baseline to compare render times against (default: tests/performance_baseline.json)')
+parser.add_argument('--update-baseline', dest='update_baseline', action='store_true',
+                    help='store the render times of this run as the new performance baseline')
+parser.add_argument('--tolerance', dest='tolerance', type=float, default=0.25,
+                    help='relative slowdown beyond which a test is reported as a performance regression')
+parser.add_argument('--fail-on-regression', dest='fail_on_regression', action='store_true',
+                    help='fail (instead of warn) when a test slows down beyond the tolerance')
 
 args = parser.parse_args()
 root_path = os.path.relpath(os.path.dirname(__file__), os.path.curdir)
-build_path = os.path.join(root_path, "build")
+build_path = args.build_dir or os.path.join(root_path, "build")
 
 try:
     with open(os.path.join(root_path, "CMakeLists.txt")) as f:
@@ -71,37 +86,84 @@ if len(tests) == 0:
     print("No tests match your input")
     exit(0)
 
+baseline_path = args.baseline or os.path.join(root_path, "tests", "performance_baseline.json")
+baseline = {}
+if os.path.isfile(baseline_path):
+    with open(baseline_path) as f:
+        baseline = json.load(f)
+
+jobs = max(1, min(args.jobs, len(tests)))
+threads_per_job = max(1, (os.cpu_count() or 1) // jobs)
+
 start_time = time.time()
 passed_count = 0
 total_count = 0
+timings = {}
+regressions = []
+
+def run_test(test):
+    """Renders a test with its share of the cores and returns the process result, wall time and telemetry."""
+    with tempfile.TemporaryDirectory() as temp_dir:
+        telemetry_path = os.path.join(temp_dir, "telemetry.json")
+        test_start = time.time()
+        r = subprocess.run([ lightwave_path, test, "--threads", str(threads_per_job), "--telemetry", telemetry_path ],
+                           capture_output=True)
+        elapsed_seconds = time.time() - test_start
+        telemetry = None
+        if os.path.isfile(telemetry_path):
+            with open(telemetry_path) as f:
+                telemetry = json.load(f)
+        return r, elapsed_seconds, telemetry
+
+def check_performance(test_name, telemetry):
+    """Compares the render time of a test (in core-seconds, which makes it independent of the thread partition)
+    against the baseline and returns a description of the change."""
+    render_time = telemetry["phases"]["render"]
+    core_seconds = render_time * telemetry["build"]["threads"]
+    timings[test_name] = {
+        "coreSeconds": core_seconds,
+        "renderSeconds": render_time,
+        "mraysPerSecond": telemetry["mraysPerSecond"],
+    }
+
+    reference = baseline.get("tests", {}).get(test_name)
+    if reference is None or reference["coreSeconds"] <= 0:
+        return f"{render_time:.2f}s render, {telemetry['mraysPerSecond']:.2f} Mrays/s"
+    change = core_seconds / reference["coreSeconds"] - 1
+    if change > args.tolerance:
+        regressions.append(test_name)
+        return f"\033[93m{render_time:.2f}s render, {100 * change:+.0f}% vs. baseline\033[0m"
+    return f"{render_time:.2f}s render, {100 * change:+.0f}% vs. baseline"
 
 print()
-for test in sorted(tests):
-    test_name = test.replace("\\", "/").split("/")[-2:]
-    test_name = "/".join(test_name).split(".")[0]
-    total_count += 1
-    
-    print(f"\033[90m› {test_name}\033[0m", end="", flush=True)
-    test_start = time.time()
-    r = subprocess.run([ lightwave_path, test ], capture_output=True)
-    elapsed_seconds = time.time() - test_start
-
-    print("\33[02K\r", end="", flush=True)
-    if r.returncode == 0:
-        print(f"\033[92m✓ {test_name} passed\033[0m ({elapsed_seconds:.2f}s)")
-        passed_count += 1
-        continue
-
-    try:
-        error = r.stderr.decode()
-    except:
-        # Windows still hasn't gotten Unicode right
-        error = r.stderr.decode("utf-16")
-    
-    print(f"\033[91m⨯ {test_name} failed\033[0m")
-    print("\n".join(error.split("\n")[-6:-1]))
-    print()
-    all_passed = False
+if jobs > 1:
+    print(f"\033[90mRunning {jobs} tests in parallel with {threads_per_job} threads each\033[0m")
+with ThreadPoolExecutor(max_workers=jobs) as executor:
+    futures = [ (test, executor.submit(run_test, test)) for test in sorted(tests) ]
+    for test, future in futures:
+        test_name = test.replace("\\", "/").split("/")[-2:]
+        test_name = "/".join(test_name).split(".")[0]
+        total_count += 1
+
+        print(f"\033[90m› {test_name}\033[0m", end="", flush=True)
+        r, elapsed_seconds, telemetry = future.result()
+
+        print("\33[02K\r", end="", flush=True)
+        if r.returncode == 0:
+            performance = f", {check_performance(test_name, telemetry)}" if telemetry else ""
+            print(f"\033[92m✓ {test_name} passed\033[0m ({elapsed_seconds:.2f}s{performance})")
+            passed_count += 1
+            continue
+
+        try:
+            error = r.stderr.decode()
+        except:
+            # Windows still hasn't gotten Unicode right
+            error = r.stderr.decode("utf-16")
+
+        print(f"\033[91m⨯ {test_name} failed\033[0m")
+        print("\n".join(error.split("\n")[-6:-1]))
+        print()
 
 all_passed = passed_count == total_count
 elapsed_seconds = time.time() - start_time
@@ -111,6 +173,25 @@ print(f"{message} ({passed_count}/{total_count} passed, {elapsed_seconds:.2f}s)"
 print(f"\033[90mTest coverage: {100 * (passed_count / total_count):.1f}%\033[0m")
 print()
 
+if regressions:
+    severity = "\033[91mError" if args.fail_on_regression else "\033[93mWarning"
+    print(f"{severity}: {len(regressions)} tests slowed down by more than {100 * args.tolerance:.0f}%\033[0m")
+    for test_name in regressions:
+        print(f"\033[90m  {test_name}\033[0m")
+    print()
+    if args.fail_on_regression:
+        all_passed = False
+
+if args.update_baseline:
+    # tests that were not run keep their previous baseline
+    updated = baseline.get("tests", {})
+    updated.update(timings)
+    with open(baseline_path, "w") as f:
+        json.dump({ "tests": dict(sorted(updated.items())) }, f, indent=2)
+        f.write("\n")
+    print(f"\033[90mStored performance baseline for {len(timings)} tests in {baseline_path}\033[0m")
+    print()
+
 print("Note:\033[90m")
 print("  Our tests are based on simple error metrics and only meant to guide you.")
 print("  Passing all tests is not a guarantee that you will receive full points!")
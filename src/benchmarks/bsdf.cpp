@@ -0,0 +1,82 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Measures the cost of sampling and evaluating the given Bsdfs.
+ * Outgoing directions are distributed over the upper hemisphere with a cosine density (as for light arriving at
+ * surfaces from all directions), and evaluation uses incident directions from the upper hemisphere as well (as for
+ * next-event estimation).
+ */
+class BsdfBenchmark : public Benchmark {
+    /// @brief The Bsdfs to measure.
+    std::vector<ref<Bsdf>> m_bsdfs;
+    /// @brief Generates the directions and steers sampling.
+    ref<Sampler> m_sampler;
+    /// @brief The number of calls per repetition.
+    int m_calls;
+
+public:
+    BsdfBenchmark(const Properties &properties)
+    : Benchmark(properties) {
+        m_bsdfs = properties.getChildren<Bsdf>();
+        m_sampler = properties.getChild<Sampler>();
+        m_calls = properties.get<int>("calls", 1 << 20);
+    }
+
+    void execute() override {
+        struct Query {
+            Point2 uv;
+            Vector wo;
+            Vector wi;
+        };
+
+        auto rng = m_sampler->clone();
+        rng->seed(0);
+        std::vector<Query> queries(m_calls);
+        for (auto &query : queries) {
+            query.uv = rng->next2D();
+            query.wo = squareToCosineHemisphere(rng->next2D());
+            query.wi = squareToCosineHemisphere(rng->next2D());
+        }
+
+        for (size_t index = 0; index < m_bsdfs.size(); index++) {
+            const Bsdf &bsdf = *m_bsdfs[index];
+
+            const double sample = fastestOf([&](int repetition) {
+                rng->seed(repetition);
+                Color sum;
+                for (const auto &query : queries)
+                    sum += bsdf.sample(query.uv, query.wo, *rng).weight;
+                doNotOptimize(sum);
+            });
+            const double evaluate = fastestOf([&](int) {
+                Color sum;
+                for (const auto &query : queries)
+                    sum += bsdf.evaluate(query.uv, query.wo, query.wi).value;
+                doNotOptimize(sum);
+            });
+
+            const std::string name = subjectName(*m_bsdfs[index], index, "bsdf");
+            report(name, "sample", sample * 1e9 / m_calls, "ns/call");
+            report(name, "evaluate", evaluate * 1e9 / m_calls, "ns/call");
+        }
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "BsdfBenchmark[\n"
+            "  bsdfs = %d,\n"
+            "  calls = %d,\n"
+            "  sampler = %s\n"
+            "]",
+            m_bsdfs.size(),
+            m_calls,
+            indent(m_sampler)
+        );
+    }
+};
+
+}
+
+REGISTER_BENCHMARK(BsdfBenchmark, "bsdf")
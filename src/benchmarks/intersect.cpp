@@ -0,0 +1,102 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Measures the cost of intersecting rays with the given shapes (e.g., triangle meshes, whose cost is dominated
+ * by traversing their acceleration structure).
+ * Rays start on a sphere around the bounding box of each shape and point towards random points inside of it, which
+ * mimics incoherent secondary rays. Both closest hit queries and visibility queries (which stop at the target point)
+ * are measured, and the average number of BVH nodes and primitives visited per ray is reported.
+ */
+class IntersectBenchmark : public Benchmark {
+    /// @brief The shapes to intersect.
+    std::vector<ref<Shape>> m_shapes;
+    /// @brief Generates the rays.
+    ref<Sampler> m_sampler;
+    /// @brief The number of rays traced per repetition.
+    int m_rays;
+
+    struct Query {
+        Ray ray;
+        /// @brief The distance to the point inside the bounding box the ray points towards.
+        float distance;
+    };
+
+    std::vector<Query> generateQueries(const Bounds &bounds) const {
+        const Point center = bounds.center();
+        const float radius = bounds.diagonal().length();
+        auto rng = m_sampler->clone();
+        rng->seed(0);
+
+        std::vector<Query> queries(m_rays);
+        for (auto &query : queries) {
+            const Point origin = center + radius * squareToUniformSphere(rng->next2D());
+            Point target;
+            for (int dim = 0; dim < 3; dim++)
+                target[dim] = bounds.min()[dim] + rng->next() * (bounds.max()[dim] - bounds.min()[dim]);
+            const Vector direction = target - origin;
+            query = { .ray = Ray(origin, direction.normalized()), .distance = direction.length() };
+        }
+        return queries;
+    }
+
+public:
+    IntersectBenchmark(const Properties &properties)
+    : Benchmark(properties) {
+        m_shapes = properties.getChildren<Shape>();
+        m_sampler = properties.getChild<Sampler>();
+        m_rays = properties.get<int>("rays", 1 << 18);
+    }
+
+    void execute() override {
+        for (size_t index = 0; index < m_shapes.size(); index++) {
+            const Shape &shape = *m_shapes[index];
+            const std::vector<Query> queries = generateQueries(shape.getBoundingBox());
+            auto rng = m_sampler->clone();
+
+            uint64_t nodes = 0;
+            uint64_t primitives = 0;
+            const double closest = fastestOf([&](int repetition) {
+                nodes = primitives = 0;
+                rng->seed(repetition);
+                for (const auto &query : queries) {
+                    Intersection its(-query.ray.direction);
+                    doNotOptimize(shape.intersect(query.ray, its, *rng));
+                    nodes += its.stats.bvhCounter;
+                    primitives += its.stats.primCounter;
+                }
+            });
+            const double visibility = fastestOf([&](int repetition) {
+                rng->seed(repetition);
+                for (const auto &query : queries) {
+                    Intersection its(-query.ray.direction, query.distance);
+                    doNotOptimize(shape.intersect(query.ray, its, *rng));
+                }
+            });
+
+            const std::string name = subjectName(*m_shapes[index], index, "shape");
+            report(name, "closest hit", closest * 1e9 / m_rays, "ns/ray");
+            report(name, "visibility", visibility * 1e9 / m_rays, "ns/ray");
+            report(name, "bvh nodes", double(nodes) / m_rays, "nodes/ray");
+            report(name, "primitives", double(primitives) / m_rays, "primitives/ray");
+        }
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "IntersectBenchmark[\n"
+            "  shapes = %d,\n"
+            "  rays = %d,\n"
+            "  sampler = %s\n"
+            "]",
+            m_shapes.size(),
+            m_rays,
+            indent(m_sampler)
+        );
+    }
+};
+
+}
+
+REGISTER_BENCHMARK(IntersectBenchmark, "intersect")
@@ -0,0 +1,66 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Measures the throughput of the given postprocesses on a synthetic high dynamic range image, whose luminances
+ * are spread log-uniformly over several orders of magnitude (as for a rendering with bright light sources).
+ */
+class PostprocessBenchmark : public Benchmark {
+    /// @brief The postprocesses to run.
+    std::vector<ref<Postprocess>> m_postprocesses;
+    /// @brief The resolution of the synthetic image.
+    Point2i m_resolution;
+
+public:
+    PostprocessBenchmark(const Properties &properties)
+    : Benchmark(properties) {
+        m_postprocesses = properties.getChildren<Postprocess>();
+        m_resolution = Point2i(properties.get<int>("width", 1920), properties.get<int>("height", 1080));
+    }
+
+    void execute() override {
+        // the same input is used for all postprocesses
+        Image input{ m_resolution };
+        uint32_t state = 1;
+        const auto next = [&]() {
+            // xorshift, which is good enough to scatter luminances
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return float(state >> 8) * 0x1p-24f;
+        };
+        for (auto pixel : input.bounds()) {
+            const float luminance = std::exp2(24 * next() - 12);
+            input(pixel) = luminance * Color(0.5f + next(), 0.5f + next(), 0.5f + next());
+        }
+
+        Image output{ m_resolution };
+        const double pixelCount = double(m_resolution.x()) * m_resolution.y();
+        for (size_t index = 0; index < m_postprocesses.size(); index++) {
+            Postprocess &postprocess = *m_postprocesses[index];
+            const double time = fastestOf([&](int) {
+                postprocess.process(input, output);
+                doNotOptimize(output.data()[0]);
+            });
+
+            const std::string name = subjectName(postprocess, index, "postprocess");
+            report(name, "time", time * 1e9 / pixelCount, "ns/pixel");
+        }
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "PostprocessBenchmark[\n"
+            "  postprocesses = %d,\n"
+            "  resolution = %s\n"
+            "]",
+            m_postprocesses.size(),
+            m_resolution
+        );
+    }
+};
+
+}
+
+REGISTER_BENCHMARK(PostprocessBenchmark, "postprocess")
@@ -0,0 +1,80 @@
+#include <lightwave.hpp>
+
+#include <filesystem>
+#include <numeric>
+
+namespace lightwave {
+
+/**
+ * @brief Renders the given integrators (e.g., scene files pulled in with an @c include ) repeatedly and reports the
+ * fastest and median render time, as well as the number of rays traced per second at the median time.
+ * Parsing the scene (including loading meshes and building BVHs) happens only once and is not part of the measurement.
+ * The number of samples per pixel can be overridden with @c spp to keep benchmarks short, and images are written to
+ * the temporary directory, so that benchmarks never overwrite renders next to the scene files.
+ */
+class RenderBenchmark : public Benchmark {
+    /// @brief The integrators to render with.
+    std::vector<ref<SamplingIntegrator>> m_integrators;
+    /// @brief The number of samples per pixel to render with, or zero to keep the setting of each integrator.
+    int m_spp;
+
+public:
+    RenderBenchmark(const Properties &properties)
+    : Benchmark(properties) {
+        m_integrators = properties.getChildren<SamplingIntegrator>();
+        m_spp = properties.get<int>("spp", 0);
+    }
+
+    void execute() override {
+        for (size_t index = 0; index < m_integrators.size(); index++) {
+            SamplingIntegrator &integrator = *m_integrators[index];
+            if (m_spp > 0) {
+                integrator.sampler()->setSamplesPerPixel(m_spp);
+            }
+
+            // scene files usually name their output image rather than their integrator
+            const std::string name = integrator.id().empty() && integrator.image() && !integrator.image()->id().empty()
+                ? integrator.image()->id()
+                : subjectName(integrator, index, "integrator");
+            ref<Image> image = std::make_shared<Image>();
+            image->setBasePath(std::filesystem::temp_directory_path());
+            image->setId(tfm::format("lightwave_bench_%s", name));
+            integrator.setImage(image);
+
+            std::vector<double> times;
+            std::vector<uint64_t> rays;
+            for (int repetition = 0; repetition < m_repetitions; repetition++) {
+                const double startTime = Telemetry::time(Telemetry::ERender);
+                const uint64_t startRays = Telemetry::total(Telemetry::EClosestHitRays) + Telemetry::total(Telemetry::EShadowRays);
+                integrator.execute();
+                times.push_back(Telemetry::time(Telemetry::ERender) - startTime);
+                rays.push_back(Telemetry::total(Telemetry::EClosestHitRays) + Telemetry::total(Telemetry::EShadowRays) - startRays);
+            }
+
+            // the median repetition (the upper one for even counts) decides the ray throughput
+            std::vector<size_t> order(times.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return times[a] < times[b]; });
+            const size_t median = order[order.size() / 2];
+
+            report(name, "min time", times[order.front()], "s");
+            report(name, "median time", times[median], "s");
+            report(name, "throughput", rays[median] / times[median] * 1e-6, "Mrays/s", false);
+        }
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "RenderBenchmark[\n"
+            "  integrators = %d,\n"
+            "  spp = %d\n"
+            "]",
+            m_integrators.size(),
+            m_spp
+        );
+    }
+};
+
+}
+
+REGISTER_BENCHMARK(RenderBenchmark, "render")
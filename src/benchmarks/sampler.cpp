@@ -0,0 +1,79 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Measures the cost of random number generation per path vertex for the given samplers.
+ * Each simulated vertex consumes the dimensions a path tracer with next-event estimation draws at a bounce:
+ * lobe selection and direction for the BSDF sample, light selection and a position on the light.
+ * The numbers are generated through the same @c next / @c next2D calls that rendering uses.
+ */
+class SamplerBenchmark : public Benchmark {
+    /// @brief The samplers to compare.
+    std::vector<ref<Sampler>> m_samplers;
+    /// @brief The number of paths generated per repetition.
+    int m_paths;
+    /// @brief The number of vertices per path.
+    int m_depth;
+
+    /// @brief Runs the given per-path workload @c m_repetitions times and returns the fastest time in nanoseconds per vertex.
+    template <typename F> double measure(Sampler &sampler, F &&path) const {
+        const double best = fastestOf([&](int repetition) {
+            float sum = 0;
+            for (int index = 0; index < m_paths; index++) {
+                sampler.seed(Point2i(index & 1023, index >> 10), repetition);
+                sum += path(sampler);
+            }
+            // make sure the compiler cannot discard the generated numbers
+            doNotOptimize(sum);
+        });
+        return best * 1e9 / (double(m_paths) * m_depth);
+    }
+
+public:
+    SamplerBenchmark(const Properties &properties)
+    : Benchmark(properties) {
+        m_samplers = properties.getChildren<Sampler>();
+        m_paths = properties.get<int>("paths", 1 << 20);
+        m_depth = properties.get<int>("depth", 5);
+    }
+
+    void execute() override {
+        for (size_t index = 0; index < m_samplers.size(); index++) {
+            const ref<Sampler> &prototype = m_samplers[index];
+            const ref<Sampler> sampler = prototype->clone();
+
+            const double scalar = measure(*sampler, [&](Sampler &rng) {
+                float sum = 0;
+                for (int depth = 0; depth < m_depth; depth++) {
+                    const float lobe = rng.next();
+                    const Point2 direction = rng.next2D();
+                    const float light = rng.next();
+                    const Point2 position = rng.next2D();
+                    sum += lobe + direction.x() + direction.y() + light + position.x() + position.y();
+                }
+                return sum;
+            });
+
+            const std::string name = subjectName(*prototype, index, "sampler");
+            report(name, "next/next2D", scalar, "ns/vertex");
+        }
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "SamplerBenchmark[\n"
+            "  samplers = %d,\n"
+            "  paths = %d,\n"
+            "  depth = %d\n"
+            "]",
+            m_samplers.size(),
+            m_paths,
+            m_depth
+        );
+    }
+};
+
+}
+
+REGISTER_BENCHMARK(SamplerBenchmark, "sampler")
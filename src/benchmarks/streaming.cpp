@@ -0,0 +1,225 @@
+#include <lightwave.hpp>
+
+#include "../core/socket.hpp"
+
+#include <mutex>
+#include <thread>
+
+namespace lightwave {
+
+/**
+ * @brief Measures how long render threads are held up by streaming to tev, by connecting to a fake tev listener that
+ * takes a configurable time to process each packet (as a slow or remote viewer would).
+ * The listener decodes the image updates it receives, and the benchmark fails if its copy of the image does not match
+ * the streamed image once streaming has finished. Nothing is measured if tev itself is running, since the fake
+ * listener needs its port.
+ */
+class StreamingBenchmark : public Benchmark {
+    /// @brief The resolution of the streamed image.
+    Point2i m_resolution;
+    /// @brief The size of the blocks that are updated.
+    int m_blockSize;
+    /// @brief How often each block is updated (as in a progressive renderer).
+    int m_passes;
+    /// @brief How long the listener takes to process each packet, in milliseconds.
+    int m_delay;
+
+    /// @brief Receives packets in the tev protocol and applies image updates to a copy of the image.
+    class FakeTev {
+        std::unique_ptr<SocketInternal> m_client;
+        int m_delay;
+        std::thread m_thread;
+
+        std::mutex m_mutex;
+        Image m_image;
+        uint64_t m_packets = 0;
+        uint64_t m_bytes = 0;
+
+        /// @brief Reads a value of the given type from a packet.
+        template <typename T> static T read(const std::vector<char> &packet, size_t &offset) {
+            if (offset + sizeof(T) > packet.size())
+                lightwave_throw("truncated tev packet");
+            T value;
+            memcpy(&value, packet.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return value;
+        }
+
+        static std::string readString(const std::vector<char> &packet, size_t &offset) {
+            const size_t length = strnlen(packet.data() + offset, packet.size() - offset);
+            std::string value(packet.data() + offset, length);
+            offset += length + 1;
+            return value;
+        }
+
+        void apply(const std::vector<char> &packet) {
+            size_t offset = 0;
+            const char type = read<char>(packet, offset);
+            if (type != 5) {
+                // closing and creating images does not affect the pixels
+                return;
+            }
+
+            read<bool>(packet, offset); // grab focus
+            readString(packet, offset); // image name
+            const int channels = read<int32_t>(packet, offset);
+            for (int channel = 0; channel < channels; channel++)
+                readString(packet, offset);
+            const Point2i min{ read<int32_t>(packet, offset), read<int32_t>(packet, offset) };
+            const Vector2i size{ read<int32_t>(packet, offset), read<int32_t>(packet, offset) };
+
+            std::lock_guard lock{ m_mutex };
+            const size_t pixelCount = size.product();
+            for (int channel = 0; channel < std::min(channels, Color::NumComponents); channel++) {
+                size_t channelOffset = offset + channel * pixelCount * sizeof(float);
+                for (int y = 0; y < size.y(); y++) {
+                    for (int x = 0; x < size.x(); x++)
+                        m_image(min + Vector2i(x, y))[channel] = read<float>(packet, channelOffset);
+                }
+            }
+        }
+
+        void run() {
+            std::vector<char> packet;
+            uint32_t size;
+            while (m_client->receiveAll((char *) &size, sizeof(size))) {
+                packet.resize(size - sizeof(size));
+                if (!m_client->receiveAll(packet.data(), packet.size()))
+                    break;
+
+                try {
+                    apply(packet);
+                } catch (const std::exception &e) {
+                    // the benchmark notices that the image does not match
+                    logger(EError, "fake tev received an invalid packet: %s", e.what());
+                    break;
+                }
+                {
+                    std::lock_guard lock{ m_mutex };
+                    m_packets++;
+                    m_bytes += size;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_delay));
+            }
+        }
+
+    public:
+        FakeTev(std::unique_ptr<SocketInternal> &&client, const Point2i &resolution, int delay)
+        : m_client(std::move(client)), m_delay(delay), m_image(resolution) {
+            m_thread = std::thread([this]() { run(); });
+        }
+
+        ~FakeTev() {
+            m_client->shutdown();
+            m_thread.join();
+        }
+
+        /// @brief Waits until the received image matches the given image, returns false if this times out.
+        bool waitFor(const Image &expected, float timeout) {
+            Timer timer;
+            while (timer.getElapsedTime() < timeout) {
+                {
+                    std::lock_guard lock{ m_mutex };
+                    const size_t pixelCount = expected.resolution().x() * expected.resolution().y();
+                    if (std::equal(expected.data(), expected.data() + pixelCount, m_image.data()))
+                        return true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return false;
+        }
+
+        uint64_t packets() {
+            std::lock_guard lock{ m_mutex };
+            return m_packets;
+        }
+
+        uint64_t bytes() {
+            std::lock_guard lock{ m_mutex };
+            return m_bytes;
+        }
+    };
+
+public:
+    StreamingBenchmark(const Properties &properties)
+    : Benchmark(properties) {
+        m_resolution = Point2i(properties.get<int>("width", 512), properties.get<int>("height", 512));
+        m_blockSize = properties.get<int>("blockSize", 32);
+        m_passes = properties.get<int>("passes", 4);
+        m_delay = properties.get<int>("delay", 2);
+    }
+
+    void execute() override {
+        SocketInternal server;
+        if (!server.listen(Streaming::Port, "127.0.0.1")) {
+            logger(EWarn, "cannot listen on port %d (is tev running?), skipping streaming benchmark", Streaming::Port);
+            return;
+        }
+
+        Image image{ m_resolution };
+        image.setId("lightwave_bench_streaming");
+
+        std::unique_ptr<FakeTev> tev;
+        std::mutex mutex;
+        double maxLatency = 0;
+        double totalLatency = 0;
+        uint64_t updates = 0;
+        uint64_t dropped;
+        Timer flushTimer;
+        {
+            Streaming stream{ image };
+            tev = std::make_unique<FakeTev>(server.accept(), m_resolution, m_delay);
+
+            for (int pass = 0; pass < m_passes; pass++) {
+                for_each_parallel(BlockSpiral(Vector2i(m_resolution), Vector2i(m_blockSize)), [&](auto block) {
+                    for (auto pixel : block)
+                        image(pixel) = Color(float(pass + 1), float(pixel.x()), float(pixel.y()));
+
+                    const auto start = std::chrono::steady_clock::now();
+                    stream.updateBlock(block);
+                    const std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+
+                    std::lock_guard lock{ mutex };
+                    maxLatency = std::max(maxLatency, latency.count());
+                    totalLatency += latency.count();
+                    updates++;
+                });
+            }
+
+            dropped = stream.droppedUpdates();
+            flushTimer = Timer();
+        }
+        const float flushTime = flushTimer.getElapsedTime();
+
+        if (!tev->waitFor(image, 10)) {
+            lightwave_throw("the image received by the fake tev listener does not match the streamed image");
+        }
+
+        const std::string name = "fake tev";
+        report(name, "mean updateBlock", totalLatency * 1e9 / updates, "ns/call");
+        report(name, "max updateBlock", maxLatency * 1e6, "us");
+        report(name, "final flush", flushTime, "s");
+        report(name, "dropped updates", double(dropped), "updates");
+        report(name, "packets", double(tev->packets()), "packets");
+        report(name, "traffic", tev->bytes() / double(1 << 20), "MiB");
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "StreamingBenchmark[\n"
+            "  resolution = %s,\n"
+            "  blockSize = %d,\n"
+            "  passes = %d,\n"
+            "  delay = %d\n"
+            "]",
+            m_resolution,
+            m_blockSize,
+            m_passes,
+            m_delay
+        );
+    }
+};
+
+}
+
+REGISTER_BENCHMARK(StreamingBenchmark, "streaming")
@@ -0,0 +1,82 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Measures the cost of evaluating the given textures.
+ * Lookups either walk the texture in scanline order (coherent, as for a camera looking at a textured plane) or jump to
+ * random texture coordinates (incoherent, as for secondary bounces).
+ * Lookups can be given a @c footprint (the extent of a pixel in texture space), which exercises filters that adapt to it.
+ */
+class TextureBenchmark : public Benchmark {
+    /// @brief The textures to evaluate.
+    std::vector<ref<Texture>> m_textures;
+    /// @brief The number of lookups per repetition.
+    int m_lookups;
+    /// @brief The change of the texture coordinates between neighboring pixels, given to all lookups.
+    float m_footprint;
+
+public:
+    TextureBenchmark(const Properties &properties)
+    : Benchmark(properties) {
+        m_textures = properties.getChildren<Texture>();
+        m_lookups = properties.get<int>("lookups", 1 << 20);
+        m_footprint = properties.get<float>("footprint", 0.0f);
+    }
+
+    void execute() override {
+        // the same coordinates are used for all textures
+        const int width = 1024;
+        std::vector<TexCoord> coherent(m_lookups);
+        std::vector<TexCoord> incoherent(m_lookups);
+        uint32_t state = 1;
+        const auto next = [&]() {
+            // xorshift, which is good enough to scatter lookups
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return float(state >> 8) * 0x1p-24f;
+        };
+        for (int i = 0; i < m_lookups; i++) {
+            coherent[i] = Point2((float(i % width) + 0.5f) / width, (float(i / width % width) + 0.5f) / width);
+            incoherent[i] = Point2(next(), next());
+            for (auto *uv : { &coherent[i], &incoherent[i] }) {
+                uv->dx = Vector2(m_footprint, 0);
+                uv->dy = Vector2(0, m_footprint);
+            }
+        }
+
+        for (size_t index = 0; index < m_textures.size(); index++) {
+            const Texture &texture = *m_textures[index];
+            const auto lookups = [&](const std::vector<TexCoord> &uvs) {
+                return fastestOf([&](int) {
+                    Color sum;
+                    for (const auto &uv : uvs)
+                        sum += texture.evaluate(uv);
+                    doNotOptimize(sum);
+                });
+            };
+
+            const std::string name = subjectName(*m_textures[index], index, "texture");
+            report(name, "coherent", lookups(coherent) * 1e9 / m_lookups, "ns/lookup");
+            report(name, "incoherent", lookups(incoherent) * 1e9 / m_lookups, "ns/lookup");
+        }
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "TextureBenchmark[\n"
+            "  textures = %d,\n"
+            "  lookups = %d,\n"
+            "  footprint = %f\n"
+            "]",
+            m_textures.size(),
+            m_lookups,
+            m_footprint
+        );
+    }
+};
+
+}
+
+REGISTER_BENCHMARK(TextureBenchmark, "texture")
@@ -19,7 +19,7 @@ public:
      * The probability of a light sample picking exactly the direction `wi` that results from reflecting `wo` is zero,
      * hence we can just ignore that case and always return black.
      */
-    BsdfEval evaluate(const Point2& uv, const Vector& wo, const Vector& wi) const override {
+    BsdfEval evaluate(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
         return BsdfEval::invalid();
     }
 
@@ -27,11 +27,11 @@ public:
      * Since conductor reflections are fully deterministic, rng isn't needed. Also note that this BSDF doesn't use the
      * cosTheta term, since all light is always fully reflected (depending only on the reflectance map).
      */
-    BsdfSample sample(const Point2& uv, const Vector& wo, Sampler& rng) const override {
+    BsdfSample sample(const TexCoord& uv, const Vector& wo, Sampler& rng) const override {
         const Vector wi = reflect(wo, m_normal).normalized();
         const Color reflectance = m_reflectance->evaluate(uv);
 
-        return {wi, reflectance};
+        return {wi, reflectance, Infinity};
     }
 
     std::string toString() const override {
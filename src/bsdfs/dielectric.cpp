@@ -29,7 +29,7 @@ public:
      * The probability of a light sample picking exactly the direction `wi` that results from reflecting or refracting
      * `wo` is zero, hence we can just ignore that case and always return black.
      */
-    BsdfEval evaluate(const Point2& uv, const Vector& wo, const Vector& wi) const override {
+    BsdfEval evaluate(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
         return BsdfEval::invalid();
     }
 
@@ -42,7 +42,7 @@ public:
      * The reason why we don't need to divide by the Fresnel probability is because the Fresnel term is already part
      * of the weight, and is thus cancelled out by the division.
      */
-    BsdfSample sample(const Point2& uv, const Vector& wo, Sampler& rng) const override {
+    BsdfSample sample(const TexCoord& uv, const Vector& wo, Sampler& rng) const override {
         float eta;
         Vector normal;
         if (wo.z() >= 0.0f) {
@@ -70,7 +70,7 @@ public:
             weight = m_transmittance->evaluate(uv) / sqr(eta);
         }
 
-        return {wi, weight};
+        return {wi, weight, Infinity};
     }
 
     std::string toString() const override {
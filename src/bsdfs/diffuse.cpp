@@ -18,7 +18,7 @@ public:
      * matter (although it shouldn't be outside the shading hemisphere). The only important parameter is the angle of
      * wi: the closer to 90° it is, the less light gets reflected. This is achieved with the cosTheta term.
      */
-    BsdfEval evaluate(const Point2& uv, const Vector& wo, const Vector& wi) const override {
+    BsdfEval evaluate(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
         if (wo.z() <= 0.0f || wi.z() <= 0.0f) {
             return BsdfEval::invalid();
         }
@@ -35,11 +35,19 @@ public:
      * @code albedo * InvPi * Frame::cosTheta(wi) / cosineHemispherePdf(wi) @endcode
      * Since the terms cancel out, the weight equals just the albedo.
      */
-    BsdfSample sample(const Point2& uv, const Vector& wo, Sampler& rng) const override {
+    BsdfSample sample(const TexCoord& uv, const Vector& wo, Sampler& rng) const override {
         const Vector wi = squareToCosineHemisphere(rng.next2D()).normalized();
         const Color albedo = m_albedo->evaluate(uv);
 
-        return {wi, albedo};
+        return {wi, albedo, cosineHemispherePdf(wi)};
+    }
+
+    float pdf(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
+        if (wo.z() <= 0.0f || wi.z() <= 0.0f) {
+            return 0.0f;
+        }
+
+        return cosineHemispherePdf(wi);
     }
 
     std::string toString() const override {
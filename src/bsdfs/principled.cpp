@@ -18,7 +18,15 @@ struct DiffuseLobe {
 
     BsdfSample sample(const Vector& wo, Sampler& rng) const {
         const Vector wi = squareToCosineHemisphere(rng.next2D()).normalized();
-        return {wi, color};
+        return {wi, color, cosineHemispherePdf(wi)};
+    }
+
+    float pdf(const Vector& wo, const Vector& wi) const {
+        if (wo.z() <= 0.0f || wi.z() <= 0.0f) {
+            return 0.0f;
+        }
+
+        return cosineHemispherePdf(wi);
     }
 };
 
@@ -48,7 +56,16 @@ struct MetallicLobe {
         const float G_wi = microfacet::smithG1(alpha, normal, wi);
         const Color weight = color * G_wi;
 
-        return {wi, weight};
+        return {wi, weight, pdf(wo, wi)};
+    }
+
+    float pdf(const Vector& wo, const Vector& wi) const {
+        if (Frame::cosTheta(wi) == 0.0f || Frame::cosTheta(wo) == 0.0f) {
+            return 0.0f;
+        }
+
+        const Vector normal = (wi + wo).normalized();
+        return microfacet::pdfGGXVNDF(alpha, normal, wo) * microfacet::detReflection(normal, wo);
     }
 };
 
@@ -64,7 +81,7 @@ class Principled : public Bsdf {
         MetallicLobe metallic;
     };
 
-    Combination combine(const Point2& uv, const Vector& wo) const {
+    Combination combine(const TexCoord& uv, const Vector& wo) const {
         const Color baseColor = m_baseColor->evaluate(uv);
         const float alpha = std::max(1e-3f, sqr(m_roughness->scalar(uv)));
         const float specular = m_specular->scalar(uv);
@@ -88,6 +105,12 @@ class Principled : public Bsdf {
         };
     }
 
+    /// The density of the one-sample model over both lobes, since either lobe could have produced the direction.
+    static float pdf(const Combination& combination, const Vector& wo, const Vector& wi) {
+        return combination.diffuseSelectionProb * combination.diffuse.pdf(wo, wi) +
+               (1.0f - combination.diffuseSelectionProb) * combination.metallic.pdf(wo, wi);
+    }
+
 public:
     explicit Principled(const Properties& properties) {
         m_baseColor = properties.get<Texture>("baseColor");
@@ -96,7 +119,7 @@ public:
         m_specular = properties.get<Texture>("specular");
     }
 
-    BsdfEval evaluate(const Point2& uv, const Vector& wo, const Vector& wi) const override {
+    BsdfEval evaluate(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
         const Combination combination = combine(uv, wo);
         const BsdfEval diffuse = combination.diffuse.evaluate(wo, wi);
         const BsdfEval mettalic = combination.metallic.evaluate(wo, wi);
@@ -104,18 +127,23 @@ public:
         return {diffuse.value + mettalic.value};
     }
 
-    BsdfSample sample(const Point2& uv, const Vector& wo, Sampler& rng) const override {
+    BsdfSample sample(const TexCoord& uv, const Vector& wo, Sampler& rng) const override {
         const Combination combination = combine(uv, wo);
 
         if (rng.next() < combination.diffuseSelectionProb) {
             const BsdfSample sample = combination.diffuse.sample(wo, rng);
-            return {sample.wi, sample.weight / combination.diffuseSelectionProb};
+            return {sample.wi, sample.weight / combination.diffuseSelectionProb, pdf(combination, wo, sample.wi)};
         } else {
             const BsdfSample sample = combination.metallic.sample(wo, rng);
-            return {sample.wi, sample.weight / (1.0f - combination.diffuseSelectionProb)};
+            return {sample.wi, sample.weight / (1.0f - combination.diffuseSelectionProb),
+                    pdf(combination, wo, sample.wi)};
         }
     }
 
+    float pdf(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
+        return pdf(combine(uv, wo), wo, wi);
+    }
+
     std::string toString() const override {
         return tfm::format(
                 "Principled[\n"
@@ -17,7 +17,7 @@ public:
         m_roughness = properties.get<Texture>("roughness");
     }
 
-    BsdfEval evaluate(const Point2& uv, const Vector& wo, const Vector& wi) const override {
+    BsdfEval evaluate(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
         if (Frame::cosTheta(wi) == 0.0f || Frame::cosTheta(wo) == 0.0f) {
             return BsdfEval::invalid();
         }
@@ -38,7 +38,7 @@ public:
         return {weight};
     }
 
-    BsdfSample sample(const Point2& uv, const Vector& wo, Sampler& rng) const override {
+    BsdfSample sample(const TexCoord& uv, const Vector& wo, Sampler& rng) const override {
         const float alpha = std::max(1e-3f, sqr(m_roughness->scalar(uv)));
 
         const Vector normal = microfacet::sampleGGXVNDF(alpha, wo, rng.next2D()).normalized();
@@ -46,7 +46,19 @@ public:
         const Color Fr = m_reflectance->evaluate(uv);
         const float G_wi = microfacet::smithG1(alpha, normal, wi);
 
-        return {wi, Fr * G_wi};
+        const float pdf = microfacet::pdfGGXVNDF(alpha, normal, wo) * microfacet::detReflection(normal, wo);
+
+        return {wi, Fr * G_wi, pdf};
+    }
+
+    float pdf(const TexCoord& uv, const Vector& wo, const Vector& wi) const override {
+        if (Frame::cosTheta(wi) == 0.0f || Frame::cosTheta(wo) == 0.0f) {
+            return 0.0f;
+        }
+
+        const float alpha = std::max(1e-3f, sqr(m_roughness->scalar(uv)));
+        const Vector normal = (wi + wo).normalized();
+        return microfacet::pdfGGXVNDF(alpha, normal, wo) * microfacet::detReflection(normal, wo);
     }
 
     std::string toString() const override {
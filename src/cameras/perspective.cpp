@@ -44,17 +44,31 @@ public:
      * To get the proper ray direction, we simply scale the normalized image coordinate by the extent given by the fov.
      */
     CameraSample sample(const Point2& normalized, Sampler& rng) const override {
-        // Compute ray direction
-        const Vector directionInCameraSystem = {
-                normalized.x() * m_xScalar,
-                normalized.y() * m_yScalar,
-                1.0f
+        // Compute ray direction, and transform from camera to world coordinates
+        const auto direction = [&](const Point2& position) {
+            const Vector directionInCameraSystem = {
+                    position.x() * m_xScalar,
+                    position.y() * m_yScalar,
+                    1.0f
+            };
+            return m_transform->apply(directionInCameraSystem).normalized();
         };
 
-        // Transform from camera to world coordinates
+        const Point origin = m_transform->apply(Point(0.0f));
+        RayDifferential ray = Ray(origin, direction(normalized));
+
+        if (m_differentials) {
+            // The rays through the neighboring pixels start at the same pinhole
+            const Vector2 pixelSize = normalizedPixelSize();
+            ray.originX = origin;
+            ray.originY = origin;
+            ray.directionX = direction({ normalized.x() + pixelSize.x(), normalized.y() });
+            ray.directionY = direction({ normalized.x(), normalized.y() + pixelSize.y() });
+            ray.hasDifferentials = true;
+        }
+
         return {
-                .ray = Ray(m_transform->apply(Point(0.0f)),
-                           m_transform->apply(directionInCameraSystem).normalized()),
+                .ray = ray,
                 .weight = Color(1.0f)
         };
     }
@@ -59,19 +59,33 @@ public:
         const Point2 lensSample = m_lensRadius * static_cast<Vector2>(squareToUniformDiskConcentric(rng.next2D()));
         const Point rayOrigin = {lensSample.x(), lensSample.y(), 0.0f};
 
-        // Compute thinlens ray direction
-        const Vector pinholeRayDirection = {
-                normalized.x() * m_xScalar,
-                normalized.y() * m_yScalar,
-                1.0f
+        // Compute thinlens ray direction, and transform from camera to world coordinates
+        const auto direction = [&](const Point2& position) {
+            const Vector pinholeRayDirection = {
+                    position.x() * m_xScalar,
+                    position.y() * m_yScalar,
+                    1.0f
+            };
+            const Point intersection = pinholeRayDirection * m_focalDistance;
+            const Vector thinlensRayDirection = intersection - rayOrigin;
+            return m_transform->apply(thinlensRayDirection).normalized();
         };
-        const Point intersection = pinholeRayDirection * m_focalDistance;
-        const Vector thinlensRayDirection = intersection - rayOrigin;
 
-        // Transform from camera to world coordinates
+        const Point origin = m_transform->apply(rayOrigin);
+        RayDifferential ray = Ray(origin, direction(normalized));
+
+        if (m_differentials) {
+            // The rays through the neighboring pixels pass through the same point on the lens
+            const Vector2 pixelSize = normalizedPixelSize();
+            ray.originX = origin;
+            ray.originY = origin;
+            ray.directionX = direction({ normalized.x() + pixelSize.x(), normalized.y() });
+            ray.directionY = direction({ normalized.x(), normalized.y() + pixelSize.y() });
+            ray.hasDifferentials = true;
+        }
+
         return {
-                .ray = Ray(m_transform->apply(rayOrigin),
-                           m_transform->apply(thinlensRayDirection).normalized()),
+                .ray = ray,
                 .weight = Color(1.0f)
         };
     }
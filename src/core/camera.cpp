@@ -6,8 +6,12 @@ namespace lightwave {
 CameraSample Camera::sample(const Point2i &pixel, Sampler &rng) const {
     // begin by sampling a random position within the pixel
     const auto pixelPlusRandomOffset = Vector2(pixel.cast<float>()) + Vector2(rng.next2D());
+    return sampleAt(Point2(pixelPlusRandomOffset), rng);
+}
+
+CameraSample Camera::sampleAt(const Point2 &position, Sampler &rng) const {
     // normalize by image resolution to end up with value in range [-1,-1] to [+1,+1]
-    const auto normalized = 2 * pixelPlusRandomOffset / m_resolution.cast<float>() - Vector2(1);
+    const auto normalized = 2 * Vector2(position) / m_resolution.cast<float>() - Vector2(1);
     // generate the sample using the normalized sample function
     const auto s = sample(normalized, rng);
     assert_normalized(s.ray.direction, {
@@ -0,0 +1,223 @@
+#include <lightwave/film.hpp>
+#include <lightwave/iterators.hpp>
+#include <lightwave/parallel.hpp>
+#include <lightwave/registry.hpp>
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+namespace lightwave {
+
+/// @brief Normalizes an accumulated value by its weight, yielding black for pixels that no sample contributed to.
+static Color normalize(const Color &value, float weight) {
+    return weight != 0 ? value / weight : Color::black();
+}
+
+/// @brief Clamps negative values (caused by filters with negative lobes, e.g., Mitchell) to zero.
+static Color clampNegative(Color color) {
+    for (int channel = 0; channel < color.NumComponents; channel++)
+        color[channel] = std::max(color[channel], 0.0f);
+    return color;
+}
+
+Film::Tile::Tile(const Filter *filter, const Bounds2i &bounds, int channels)
+: m_filter(filter), m_bounds(bounds), m_channels(channels) {
+    const int pixelCount = bounds.diagonal().product();
+    m_weights.resize(pixelCount, 0);
+    m_values.resize(pixelCount * channels);
+}
+
+void Film::Tile::addSample(const Point2 &position, const Color *values) {
+    const int width = m_bounds.diagonal().x();
+    if (!m_filter) {
+        // samples only contribute to the pixel they were taken in, clamping guards against rounding at its edge
+        Point2i pixel;
+        for (int dim = 0; dim < 2; dim++)
+            pixel[dim] = std::clamp(int(std::floor(position[dim])), m_bounds.min()[dim], m_bounds.max()[dim] - 1);
+        const int index = (pixel.y() - m_bounds.min().y()) * width + (pixel.x() - m_bounds.min().x());
+        m_weights[index] += 1;
+        for (int channel = 0; channel < m_channels; channel++)
+            m_values[index * m_channels + channel] += values[channel];
+        return;
+    }
+
+    // the filter is separable, so it suffices to evaluate it once per row and column of its footprint
+    const float radius = m_filter->radius();
+    Point2i begin, end;
+    std::array<std::array<float, 2 * MaxFilterRadius + 2>, 2> weights;
+    for (int dim = 0; dim < 2; dim++) {
+        begin[dim] = std::max(int(std::floor(position[dim] - 0.5f - radius)) + 1, m_bounds.min()[dim]);
+        end[dim] = std::min(int(std::floor(position[dim] - 0.5f + radius)) + 1, m_bounds.max()[dim]);
+        for (int pixel = begin[dim]; pixel < end[dim]; pixel++)
+            weights[dim][pixel - begin[dim]] = m_filter->evaluate(pixel + 0.5f - position[dim]);
+    }
+
+    for (int y = begin.y(); y < end.y(); y++) {
+        for (int x = begin.x(); x < end.x(); x++) {
+            const float weight = weights[0][x - begin.x()] * weights[1][y - begin.y()];
+            if (weight == 0)
+                continue;
+
+            const int index = (y - m_bounds.min().y()) * width + (x - m_bounds.min().x());
+            m_weights[index] += weight;
+            for (int channel = 0; channel < m_channels; channel++)
+                m_values[index * m_channels + channel] += weight * values[channel];
+        }
+    }
+}
+
+void Film::Tile::develop(const Bounds2i &block, Image &image) const {
+    const int width = m_bounds.diagonal().x();
+    for (auto pixel : block) {
+        const int index = (pixel.y() - m_bounds.min().y()) * width + (pixel.x() - m_bounds.min().x());
+        image(pixel) = clampNegative(normalize(m_values[index * m_channels], m_weights[index]));
+    }
+}
+
+Film::Film(const Properties &properties) {
+    m_filter = properties.getOptionalChild<Filter>();
+    if (m_filter && m_filter->radius() > MaxFilterRadius) {
+        lightwave_throw("the filter radius must not exceed %d pixels", MaxFilterRadius);
+    }
+
+    m_multilayer = properties.get<bool>("multilayer", false);
+
+    std::stringstream names{ properties.get<std::string>("aovs", "") };
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        name.erase(0, name.find_first_not_of(' '));
+        name.erase(name.find_last_not_of(' ') + 1);
+        if (name.empty())
+            continue;
+
+        AovType type = ECustom;
+        if (name == "albedo") type = EAlbedo;
+        else if (name == "normal") type = ENormal;
+        else if (name == "position") type = EPosition;
+        else if (name == "depth") type = EDepth;
+
+        // the image of an AOV can be given as named child, e.g., to refer to it from a postprocess
+        m_aovs.push_back({ .name = name, .type = type, .image = properties.get<Image>(name, ref<Image>()) });
+    }
+}
+
+void Film::initialize(const Vector2i &resolution, const Image &output) {
+    m_resolution = resolution;
+    for (auto &aov : m_aovs) {
+        if (!aov.image) {
+            aov.image = std::make_shared<Image>();
+            aov.image->setBasePath(output.basePath());
+            aov.image->setPrecision(output.precision());
+            aov.image->setCompression(output.compression());
+        }
+        if (aov.image->id().empty()) {
+            aov.image->setId(output.id() + "_" + aov.name);
+        }
+        aov.image->initialize(resolution);
+    }
+    clear();
+}
+
+void Film::clear() {
+    if (!m_filter)
+        return;
+
+    const int pixelCount = m_resolution.product();
+    m_weights.assign(pixelCount, 0);
+    m_values.assign(pixelCount * channelCount(), Color::black());
+    m_bandLocks = std::vector<std::mutex>((m_resolution.y() + BandHeight - 1) / BandHeight);
+}
+
+Film::Tile Film::createTile(const Bounds2i &block) const {
+    // samples taken in the block reach up to this many pixels beyond it
+    const int margin = m_filter ? std::max(int(std::ceil(m_filter->radius() - 0.5f)), 0) : 0;
+    const Bounds2i bounds = Bounds2i(Point2i(0), Point2i(m_resolution)).clip(
+        Bounds2i(block.min() - Vector2i(margin), block.max() + Vector2i(margin)));
+    return Tile(m_filter.get(), bounds, channelCount());
+}
+
+void Film::mergeTile(const Tile &tile, Image &output) {
+    const int channels = channelCount();
+    const int width = tile.m_bounds.diagonal().x();
+    if (!m_filter) {
+        // the tile covers exactly its block, whose pixels no other tile contributes to
+        for (auto pixel : tile.m_bounds) {
+            const int index = (pixel.y() - tile.m_bounds.min().y()) * width + (pixel.x() - tile.m_bounds.min().x());
+            const float weight = tile.m_weights[index];
+            output(pixel) = normalize(tile.m_values[index * channels], weight);
+            for (int aov = 0; aov < int(m_aovs.size()); aov++)
+                m_aovs[aov].image->get(pixel) = normalize(tile.m_values[index * channels + 1 + aov], weight);
+        }
+        return;
+    }
+
+    // tiles finish in arbitrary order, hence the sums of pixels shared by several tiles may differ in rounding
+    for (int band = tile.m_bounds.min().y() / BandHeight; band * BandHeight < tile.m_bounds.max().y(); band++) {
+        std::lock_guard lock{ m_bandLocks[band] };
+        const int yBegin = std::max(band * BandHeight, tile.m_bounds.min().y());
+        const int yEnd = std::min((band + 1) * BandHeight, tile.m_bounds.max().y());
+        for (int y = yBegin; y < yEnd; y++) {
+            const int source = (y - tile.m_bounds.min().y()) * width;
+            const int target = y * m_resolution.x() + tile.m_bounds.min().x();
+            for (int x = 0; x < width; x++) {
+                m_weights[target + x] += tile.m_weights[source + x];
+                for (int channel = 0; channel < channels; channel++)
+                    m_values[(target + x) * channels + channel] += tile.m_values[(source + x) * channels + channel];
+            }
+        }
+    }
+}
+
+void Film::develop(Image &output) {
+    if (!m_filter) {
+        // all pixels have already been written when their tiles were merged
+        return;
+    }
+
+    const int channels = channelCount();
+    for_each_parallel(Range(0, m_resolution.y()), [&](int y) {
+        for (int x = 0; x < m_resolution.x(); x++) {
+            const Point2i pixel{ x, y };
+            const int index = y * m_resolution.x() + x;
+            output(pixel) = clampNegative(normalize(m_values[index * channels], m_weights[index]));
+            for (int aov = 0; aov < int(m_aovs.size()); aov++)
+                m_aovs[aov].image->get(pixel) = normalize(m_values[index * channels + 1 + aov], m_weights[index]);
+        }
+    });
+}
+
+void Film::save(const Image &output) const {
+    if (m_multilayer) {
+        std::vector<Image::Layer> layers;
+        for (const auto &aov : m_aovs)
+            layers.push_back({ .name = aov.name, .image = aov.image.get() });
+        output.save(layers);
+        return;
+    }
+
+    output.save();
+    for (const auto &aov : m_aovs) {
+        aov.image->save();
+    }
+}
+
+std::string Film::toString() const {
+    std::string aovs;
+    for (const auto &aov : m_aovs)
+        aovs += (aovs.empty() ? "" : ", ") + aov.name;
+    return tfm::format(
+        "Film[\n"
+        "  filter = %s,\n"
+        "  aovs = \"%s\",\n"
+        "  multilayer = %s\n"
+        "]",
+        indent(m_filter),
+        aovs,
+        m_multilayer
+    );
+}
+
+} // namespace lightwave
+
+REGISTER_CLASS(Film, "film", "default")
@@ -1,70 +1,270 @@
 #include <lightwave/core.hpp>
 #include <lightwave/image.hpp>
+#include <lightwave/parallel.hpp>
 #include <lightwave/registry.hpp>
+#include <lightwave/telemetry.hpp>
 
 #include <stb_image.h>
 #include <tinyexr.h>
 
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
+#include <tuple>
+
 namespace lightwave {
 
-void Image::loadImage(const std::filesystem::path &path, bool isLinearSpace) {
-    const auto extension = path.extension();
+/// @brief The images that are currently being written in the background.
+static std::mutex s_pendingSavesMutex;
+static std::vector<std::future<void>> s_pendingSaves;
+
+/// @brief A single channel of an EXR file, e.g., "albedo.R".
+struct ExrChannel {
+    std::string name;
+    std::vector<float> values;
+};
+
+/// @brief Writes the given channels to an EXR file using the full TinyEXR API, which (unlike @c SaveEXR ) supports
+/// any number of channels and choosing the compression.
+static void writeEXR(const std::filesystem::path &path, const Point2i &resolution, std::vector<ExrChannel> &channels,
+                     Image::Precision precision, Image::Compression compression) {
+    // readers expect the channels sorted by name (e.g., B, G, R)
+    std::sort(channels.begin(), channels.end(), [](const ExrChannel &a, const ExrChannel &b) {
+        return a.name < b.name;
+    });
+
+    EXRHeader header;
+    InitEXRHeader(&header);
+    EXRImage image;
+    InitEXRImage(&image);
+
+    std::vector<EXRChannelInfo> infos(channels.size());
+    std::vector<int> pixelTypes(channels.size(), TINYEXR_PIXELTYPE_FLOAT);
+    std::vector<int> requestedPixelTypes(
+        channels.size(), precision == Image::EHalf ? TINYEXR_PIXELTYPE_HALF : TINYEXR_PIXELTYPE_FLOAT);
+    std::vector<unsigned char *> planes(channels.size());
+    for (size_t index = 0; index < channels.size(); index++) {
+        infos[index] = {};
+        strncpy(infos[index].name, channels[index].name.c_str(), sizeof(infos[index].name) - 1);
+        planes[index] = reinterpret_cast<unsigned char *>(channels[index].values.data());
+    }
+
+    switch (compression) {
+    case Image::ENoCompression: header.compression_type = TINYEXR_COMPRESSIONTYPE_NONE; break;
+    case Image::ERle: header.compression_type = TINYEXR_COMPRESSIONTYPE_RLE; break;
+    case Image::EZip: header.compression_type = TINYEXR_COMPRESSIONTYPE_ZIP; break;
+    case Image::EPiz: header.compression_type = TINYEXR_COMPRESSIONTYPE_PIZ; break;
+    }
+    header.num_channels = int(channels.size());
+    header.channels = infos.data();
+    header.pixel_types = pixelTypes.data();
+    header.requested_pixel_types = requestedPixelTypes.data();
+
+    image.num_channels = int(channels.size());
+    image.images = planes.data();
+    image.width = resolution.x();
+    image.height = resolution.y();
+
+    const char *error;
+    if (SaveEXRImageToFile(&image, &header, path.generic_string().c_str(), &error) != TINYEXR_SUCCESS) {
+        logger(EError, "  error saving image %s: %s", path, error);
+        FreeEXRErrorMessage(error);
+    }
+}
+
+/// @brief The pixels of an image file.
+struct DecodedImage {
+    Point2i resolution;
+    std::vector<Color> data;
+};
+
+/// @brief Images decoded by @ref Image::preload , along with how many more times they will be loaded.
+struct PreloadedImage {
+    DecodedImage image;
+    int remainingLoads;
+};
+
+static std::mutex s_preloadedMutex;
+static std::map<std::tuple<std::string, bool, std::string>, PreloadedImage> s_preloaded;
+
+static auto preloadKey(const Image::Source &source) {
+    return std::make_tuple(source.path.lexically_normal().generic_string(), source.isLinearSpace, source.layer);
+}
+
+static DecodedImage decodeImage(const Image::Source &source) {
+    Telemetry::ScopedTimer timer{ Telemetry::EImageLoad };
+    const auto &path = source.path;
     logger(EInfo, "loading image %s", path);
-    if (extension == ".exr") {
+
+    DecodedImage result;
+    if (path.extension() == ".exr") {
         // loading of EXR files is handled by TinyEXR
         float *data;
         const char *err;
-        if (LoadEXR(&data, &m_resolution.x(), &m_resolution.y(),
-                    path.generic_string().c_str(), &err)) {
+        if (LoadEXRWithLayer(&data, &result.resolution.x(), &result.resolution.y(),
+                             path.generic_string().c_str(),
+                             source.layer.empty() ? nullptr : source.layer.c_str(), &err)) {
             lightwave_throw("could not load image %s: %s", path, err);
         }
 
-        m_data.resize(m_resolution.x() * m_resolution.y());
+        result.data.resize(result.resolution.x() * result.resolution.y());
         auto it = data;
-        for (auto &pixel : m_data) {
-            for (int i = 0; i < pixel.NumComponents; i++)
-                pixel[i] = *it++;
-            it++; // skip alpha channel
+        for (auto &pixel : result.data) {
+            pixel = Color(it[0], it[1], it[2]);
+            it += 4; // skip alpha channel
         }
         free(data);
-    } else {
-        // anything that is not an EXR file is handled by stb
-        stbi_ldr_to_hdr_gamma(isLinearSpace ? 1.0f : 2.2f);
+    } else if (stbi_is_hdr(path.generic_string().c_str())) {
+        // Radiance HDR files are already linear
+        float *data = stbi_loadf(path.generic_string().c_str(), &result.resolution.x(), &result.resolution.y(),
+                                 nullptr, 3);
+        if (data == nullptr) {
+            lightwave_throw("could not load image %s: %s", path, stbi_failure_reason());
+        }
 
-        int numChannels;
-        float *data =
-            stbi_loadf(path.generic_string().c_str(), &m_resolution.x(),
-                       &m_resolution.y(), &numChannels, 3);
+        result.data.resize(result.resolution.x() * result.resolution.y());
+        auto it = data;
+        for (auto &pixel : result.data) {
+            pixel = Color(it[0], it[1], it[2]);
+            it += 3;
+        }
+        free(data);
+    } else {
+        // anything else is handled by stb, which decodes it to 8 bits per channel
+        unsigned char *data = stbi_load(path.generic_string().c_str(), &result.resolution.x(),
+                                        &result.resolution.y(), nullptr, 3);
         if (data == nullptr) {
-            lightwave_throw("could not load image %s: %s", path,
-                            stbi_failure_reason());
+            lightwave_throw("could not load image %s: %s", path, stbi_failure_reason());
         }
 
-        m_data.resize(m_resolution.x() * m_resolution.y());
+        // same conversion as stbi_loadf, but without its global (and hence not thread-safe) gamma setting, and
+        // without evaluating a power for every channel of every pixel
+        const float gamma = source.isLinearSpace ? 1.0f : 2.2f;
+        std::array<float, 256> toLinear;
+        for (int value = 0; value < 256; value++)
+            toLinear[value] = float(std::pow(double(value / 255.0f), double(gamma)));
+
+        result.data.resize(result.resolution.x() * result.resolution.y());
         auto it = data;
-        for (auto &pixel : m_data) {
-            for (int i = 0; i < pixel.NumComponents; i++)
-                pixel[i] = *it++;
+        for (auto &pixel : result.data) {
+            pixel = Color(toLinear[it[0]], toLinear[it[1]], toLinear[it[2]]);
+            it += 3;
         }
         free(data);
     }
+    return result;
 }
 
-void Image::saveAt(const std::filesystem::path &path) const {
-    const char *error;
+void Image::loadImage(const std::filesystem::path &path, bool isLinearSpace, const std::string &layer) {
+    const Source source{ .path = path, .isLinearSpace = isLinearSpace, .layer = layer };
+    {
+        std::lock_guard lock{ s_preloadedMutex };
+        auto it = s_preloaded.find(preloadKey(source));
+        if (it != s_preloaded.end()) {
+            // the last image to load a file can take its pixels without copying them
+            m_resolution = it->second.image.resolution;
+            if (--it->second.remainingLoads > 0) {
+                m_data = it->second.image.data;
+            } else {
+                m_data = std::move(it->second.image.data);
+                s_preloaded.erase(it);
+            }
+            return;
+        }
+    }
+
+    DecodedImage image = decodeImage(source);
+    m_resolution = image.resolution;
+    m_data = std::move(image.data);
+}
+
+void Image::preload(std::span<const Source> sources) {
+    // files referenced multiple times are only decoded once
+    std::map<std::tuple<std::string, bool, std::string>, std::pair<const Source *, int>> unique;
+    for (const auto &source : sources) {
+        auto &entry = unique[preloadKey(source)];
+        entry.first = &source;
+        entry.second++;
+    }
+
+    std::vector<std::pair<const Source *, int>> pending;
+    for (const auto &[key, entry] : unique)
+        pending.push_back(entry);
+
+    for_each_parallel(pending.begin(), pending.end(), [](const std::pair<const Source *, int> &entry) {
+        PreloadedImage preloaded;
+        try {
+            preloaded.image = decodeImage(*entry.first);
+        } catch (const std::exception &) {
+            // the error is reported with more context when the image is loaded by the scene
+            return;
+        }
+        preloaded.remainingLoads = entry.second;
+
+        std::lock_guard lock{ s_preloadedMutex };
+        s_preloaded[preloadKey(*entry.first)] = std::move(preloaded);
+    });
+}
+
+void Image::discardPreloaded() {
+    std::lock_guard lock{ s_preloadedMutex };
+    s_preloaded.clear();
+}
 
+void Image::saveAt(const std::filesystem::path &path,
+                   std::span<const Layer> layers) const {
     if (resolution().isZero()) {
         logger(EWarn, "cannot save empty image %s!", path);
         return;
     }
 
     logger(EInfo, "saving image %s", path);
-    if (SaveEXR(reinterpret_cast<const float *>(m_data.data()),
-                m_resolution.x(), m_resolution.y(), 3, true,
-                path.generic_string().c_str(), &error)) {
-        logger(EError, "  error saving image %s: %s", path, error);
+
+    // the pixels are copied now, as the image might change while it is being written
+    std::vector<ExrChannel> channels;
+    const auto addChannels = [&](const std::string &prefix, const Image &source) {
+        static const char *names[] = { "R", "G", "B" };
+        const size_t pixelCount = source.m_data.size();
+        for (int channel = 0; channel < Color::NumComponents; channel++) {
+            std::vector<float> values(pixelCount);
+            for (size_t index = 0; index < pixelCount; index++)
+                values[index] = source.m_data[index][channel];
+            channels.push_back({ .name = prefix + names[channel], .values = std::move(values) });
+        }
+    };
+    addChannels("", *this);
+    for (const auto &layer : layers) {
+        if (layer.image->resolution() != resolution()) {
+            lightwave_throw("layer \"%s\" does not match the resolution of image %s", layer.name, path);
+        }
+        addChannels(layer.name + ".", *layer.image);
     }
+
+    auto write = [path, resolution = m_resolution, channels = std::move(channels), precision = m_precision,
+                  compression = m_compression]() mutable {
+        Telemetry::ScopedTimer timer{ Telemetry::ESave };
+        writeEXR(path, resolution, channels, precision, compression);
+    };
+
+    std::lock_guard lock{ s_pendingSavesMutex };
+    // forget about saves that have already finished, so that long running processes do not accumulate them
+    std::erase_if(s_pendingSaves, [](const std::future<void> &save) {
+        return save.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    });
+    s_pendingSaves.push_back(std::async(std::launch::async, std::move(write)));
+}
+
+void Image::waitForPendingSaves() {
+    std::vector<std::future<void>> saves;
+    {
+        std::lock_guard lock{ s_pendingSavesMutex };
+        saves.swap(s_pendingSaves);
+    }
+    for (auto &save : saves)
+        save.wait();
 }
+
 } // namespace lightwave
 
 REGISTER_CLASS(Image, "image", "default")
@@ -5,7 +5,7 @@
 
 namespace lightwave {
 /**
- * Transforms the position and frame of the SurfaceEvent from object to world coordinates.
+ * Transforms the position, frame and position derivatives of the SurfaceEvent from object to world coordinates.
  * When using normal maps, we first compute the new shading normal from the mesh data and normal map, transform it
  * with the transform matrix adjoint, and recompute the tangents from it.
  * Otherwise, we transform the tangents and recompute the normal from them.
@@ -34,6 +34,10 @@ void Instance::transformFrame(SurfaceEvent& surf) const {
         // Transform the normal, set it, and recompute the tangents using the Frame constructor
         surf.frame = Frame(m_transform->applyNormal(newNormal).normalized());
         surf.position = m_transform->apply(surf.position);
+        if (Texture::anyUsesFootprint()) {
+            surf.dpdu = m_transform->apply(surf.dpdu);
+            surf.dpdv = m_transform->apply(surf.dpdv);
+        }
         const float newCrossProduct = surf.frame.tangent.cross(surf.frame.bitangent).length();
 
         // Since the probability of sampling a certain point on an object relates to its surface area, we must scale the
@@ -53,6 +57,10 @@ void Instance::transformFrame(SurfaceEvent& surf) const {
 
     const float oldCrossProduct = surf.frame.tangent.cross(surf.frame.bitangent).length();
     surf.position = m_transform->apply(surf.position);
+    if (Texture::anyUsesFootprint()) {
+        surf.dpdu = m_transform->apply(surf.dpdu);
+        surf.dpdv = m_transform->apply(surf.dpdv);
+    }
     surf.frame.tangent = m_transform->apply(surf.frame.tangent);
     surf.frame.bitangent = m_transform->apply(surf.frame.bitangent);
     const float newCrossProduct = surf.frame.tangent.cross(surf.frame.bitangent).length();
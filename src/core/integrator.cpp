@@ -1,6 +1,9 @@
 #include <lightwave/integrator.hpp>
+#include <lightwave/bsdf.hpp>
 #include <lightwave/camera.hpp>
 #include <lightwave/parallel.hpp>
+#include <lightwave/telemetry.hpp>
+#include <lightwave/texture.hpp>
 
 #include <algorithm>
 #include <chrono>
@@ -10,36 +13,151 @@
 
 namespace lightwave {
 
+namespace {
+
+/// @brief The intersection of the camera ray that is currently being traced by this thread.
+struct PrimaryHit {
+    /// @brief Whether the current sample records AOVs, which are the only consumer of the intersection.
+    bool requested = false;
+    /// @brief Whether @ref SamplingIntegrator::Li has recorded the intersection for the current sample.
+    bool recorded = false;
+    Intersection its;
+};
+
+thread_local PrimaryHit primaryHit;
+
+}
+
 void SamplingIntegrator::execute() {
     if (!m_image) {
         lightwave_throw("<integrator /> needs an <image /> child to render into!");
     }
 
-    const Vector2i resolution = m_scene->camera()->resolution();
-    m_image->initialize(resolution);
-
-    const float norm = 1.0f / m_sampler->samplesPerPixel();
+    initializeImages();
 
     Streaming stream = {*m_image};
+    render(m_sampler->samplesPerPixel(), 0, &stream);
+
+    saveImages();
+}
+
+void SamplingIntegrator::initializeImages() {
+    m_image->initialize(m_scene->camera()->resolution());
+    m_film->initialize(m_scene->camera()->resolution(), *m_image);
+    if (m_costImage) {
+        m_costImage->initialize(m_scene->camera()->resolution());
+        m_costImage->setId(m_image->id() + "_cost");
+        m_costImage->setBasePath(m_image->basePath());
+        m_costImage->setPrecision(m_image->precision());
+        m_costImage->setCompression(m_image->compression());
+    }
+}
+
+void SamplingIntegrator::saveImages() {
+    m_film->save(*m_image);
+    if (m_costImage) {
+        m_costImage->save();
+    }
+}
+
+void SamplingIntegrator::recordPrimaryHit(const Intersection &its) {
+    if (primaryHit.requested && !primaryHit.recorded) {
+        primaryHit.its = its;
+        primaryHit.recorded = true;
+    }
+}
+
+void SamplingIntegrator::evaluateAovs(const RayDifferential &ray, const Intersection *primary, Sampler &rng, Color *aovs) {
+    Intersection its = primary ? *primary : m_scene->intersect(ray, rng);
+    if (!its) {
+        return;
+    }
+    // textures are filtered like for the rendered image
+    its.computeDifferentials(ray);
+
+    const auto &filmAovs = m_film->aovs();
+    for (size_t index = 0; index < filmAovs.size(); index++) {
+        switch (filmAovs[index].type) {
+        case Film::EAlbedo: {
+            // a single Bsdf sample is an unbiased estimate of the albedo, which the film averages over all samples
+            const BsdfSample bsdfSample = its.sampleBsdf(rng);
+            aovs[index] = bsdfSample.isInvalid() ? Color::black() : bsdfSample.weight;
+            break;
+        }
+        case Film::ENormal: aovs[index] = Color(its.frame.normal); break;
+        case Film::EPosition: aovs[index] = Color(Vector(its.position)); break;
+        case Film::EDepth: aovs[index] = Color(its.t); break;
+        case Film::ECustom: break;
+        }
+    }
+}
+
+void SamplingIntegrator::render(int samplesPerPixel, int firstSampleIndex, Streaming *stream) {
+    const Vector2i resolution = m_scene->camera()->resolution();
+    const bool hasAovs = !m_film->aovs().empty();
+    // Each sample only needs to filter textures over its share of the pixel, since the samples already average over
+    // the pixel footprint. As in PBRT, the footprint shrinks with the spacing of the samples, but not below an eighth of
+    // a pixel, which avoids aliasing of textures for the low sample counts of previews
+    const float differentialScale = std::max(0.125f, 1 / std::sqrt(float(m_sampler->samplesPerPixel())));
+    Telemetry::ScopedTimer timer{ Telemetry::ERender };
+
+    m_film->clear();
     ProgressReporter progress = {resolution.product()};
     for_each_parallel(BlockSpiral(resolution, Vector2i(64)), [&](auto block) {
         auto sampler = m_sampler->clone();
+        Film::Tile tile = m_film->createTile(block);
+        std::vector<Color> values(m_film->channelCount());
         for (auto pixel: block) {
-            Color sum;
-            for (int sample = 0; sample < m_sampler->samplesPerPixel(); sample++) {
-                sampler->seed(pixel, sample);
-                auto cameraSample = m_scene->camera()->sample(pixel, *sampler);
-                sum += cameraSample.weight * Li(cameraSample.ray, *sampler);
+            // the cost is measured with the counters of this thread, which only change by work done for this pixel
+            const auto startTime = std::chrono::steady_clock::now();
+            const uint64_t startRays = Telemetry::local(Telemetry::EClosestHitRays) + Telemetry::local(Telemetry::EShadowRays);
+            const uint64_t startNodes = Telemetry::local(Telemetry::EBvhNodes);
+
+            for (int sample = 0; sample < samplesPerPixel; sample++) {
+                sampler->seed(pixel, firstSampleIndex + sample);
+                const Point2 position = Point2(Vector2(pixel.template cast<float>()) + Vector2(sampler->next2D()));
+                auto cameraSample = m_scene->camera()->sampleAt(position, *sampler);
+                cameraSample.ray.scaleDifferentials(differentialScale);
+                primaryHit.requested = hasAovs;
+                primaryHit.recorded = false;
+                values[0] = cameraSample.weight * Li(cameraSample.ray, *sampler);
+                if (hasAovs) {
+                    std::fill(values.begin() + 1, values.end(), Color::black());
+                    // integrators that do not record the intersection of the camera ray leave it to be traced again
+                    evaluateAovs(cameraSample.ray, primaryHit.recorded ? &primaryHit.its : nullptr, *sampler,
+                                 values.data() + 1);
+                }
+                tile.addSample(position, values.data());
+            }
+
+            if (m_costImage) {
+                const uint64_t rays = Telemetry::local(Telemetry::EClosestHitRays) + Telemetry::local(Telemetry::EShadowRays);
+                const std::chrono::duration<float, std::micro> time = std::chrono::steady_clock::now() - startTime;
+                // passes of multi-pass integrators add up
+                m_costImage->get(pixel) += Color(
+                        time.count(),
+                        float(rays - startRays),
+                        float(Telemetry::local(Telemetry::EBvhNodes) - startNodes));
             }
-            m_image->get(pixel) = norm * sum;
         }
 
+        Telemetry::count(Telemetry::EPrimaryRays, uint64_t(block.diagonal().product()) * samplesPerPixel);
         progress += block.diagonal().product();
-        stream.updateBlock(block);
+        m_film->mergeTile(tile, *m_image);
+        if (stream) {
+            // with a filter, the final pixels also depend on samples of neighboring blocks, which are only known after
+            // developing the film
+            if (m_film->filter())
+                tile.develop(block, *m_image);
+            stream->updateBlock(block);
+        }
     });
+    m_film->develop(*m_image);
+    if (stream) {
+        // the streamed blocks only contain their own samples, the viewer has to end up with the developed image
+        stream->update();
+    }
     progress.finish();
-
-    m_image->save();
 }
 
 } // namespace lightwave
@@ -0,0 +1,271 @@
+#include <lightwave/logger.hpp>
+
+#include "lightbvh.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace lightwave {
+
+/// @brief Rotates @c v around the (normalized) @c axis by the given angle (Rodrigues' rotation formula).
+static Vector rotate(const Vector &v, const Vector &axis, float angle) {
+    const float cosAngle = std::cos(angle);
+    const float sinAngle = std::sin(angle);
+    return v * cosAngle + axis.cross(v) * sinAngle + axis * (axis.dot(v) * (1 - cosAngle));
+}
+
+LightBounds LightBounds::merge(const LightBounds &a, const LightBounds &b) {
+    if (a.phi == 0) return b;
+    if (b.phi == 0) return a;
+
+    LightBounds result;
+    result.bounds = a.bounds;
+    result.bounds.extend(b.bounds);
+    result.phi = a.phi + b.phi;
+    result.cosThetaE = std::min(a.cosThetaE, b.cosThetaE);
+    result.twoSided = a.twoSided || b.twoSided;
+
+    // find the smallest cone that contains both normal cones
+    const float thetaA = safe_acos(a.cosThetaO);
+    const float thetaB = safe_acos(b.cosThetaO);
+    const float thetaD = safe_acos(a.w.dot(b.w));
+    if (std::min(thetaD + thetaB, Pi) <= thetaA) {
+        result.w = a.w;
+        result.cosThetaO = a.cosThetaO;
+        return result;
+    }
+    if (std::min(thetaD + thetaA, Pi) <= thetaB) {
+        result.w = b.w;
+        result.cosThetaO = b.cosThetaO;
+        return result;
+    }
+
+    const float thetaO = (thetaA + thetaD + thetaB) / 2;
+    const Vector axis = a.w.cross(b.w);
+    if (thetaO >= Pi || axis.lengthSquared() == 0) {
+        // the cone covers the entire sphere
+        result.cosThetaO = -1;
+        return result;
+    }
+
+    result.w = rotate(a.w, axis.normalized(), thetaO - thetaA).normalized();
+    result.cosThetaO = std::cos(thetaO);
+    return result;
+}
+
+float LightBounds::importance(const Point &origin) const {
+    const Point center = bounds.center();
+    const float radius = bounds.diagonal().length() / 2;
+    const float distanceSquared = std::max((origin - center).lengthSquared(), radius);
+
+    // angle between the cone axis and the direction from the bounds to the query point
+    const Vector wi = (origin - center).normalized();
+    float cosThetaW = w.dot(wi);
+    if (twoSided) cosThetaW = std::abs(cosThetaW);
+    if (!std::isfinite(cosThetaW)) cosThetaW = 1; // query point lies in the center of the bounds
+    const float sinThetaW = safe_sqrt(1 - sqr(cosThetaW));
+
+    // angle subtended by the bounding sphere of the bounds
+    float cosThetaB = -1;
+    if ((origin - center).lengthSquared() > sqr(radius)) {
+        cosThetaB = safe_sqrt(1 - sqr(radius) / (origin - center).lengthSquared());
+    }
+    const float sinThetaB = safe_sqrt(1 - sqr(cosThetaB));
+
+    // cos(max(0, a - b)), and sin of the same angle
+    const auto cosSubClamped = [](float sinA, float cosA, float sinB, float cosB) {
+        return cosA > cosB ? 1 : cosA * cosB + sinA * sinB;
+    };
+    const auto sinSubClamped = [](float sinA, float cosA, float sinB, float cosB) {
+        return cosA > cosB ? 0 : sinA * cosB - cosA * sinB;
+    };
+
+    // the smallest angle between the query point and any emission direction
+    const float sinThetaO = safe_sqrt(1 - sqr(cosThetaO));
+    const float cosThetaX = cosSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+    const float sinThetaX = sinSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+    const float cosThetaP = cosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosThetaP <= cosThetaE) return 0;
+
+    return phi * cosThetaP / distanceSquared;
+}
+
+/// @brief The surface area heuristic for lights, which also accounts for the spread of emission directions.
+static float evaluateCost(const LightBounds &b, const Bounds &centroidBounds, int dim) {
+    const float thetaO = safe_acos(b.cosThetaO);
+    const float thetaE = safe_acos(b.cosThetaE);
+    const float thetaW = std::min(thetaO + thetaE, Pi);
+    const float sinThetaO = safe_sqrt(1 - sqr(b.cosThetaO));
+    const float solidAngle = 2 * Pi * (1 - b.cosThetaO) +
+                             Pi / 2 * (2 * thetaW * sinThetaO - std::cos(thetaO - 2 * thetaW) -
+                                       2 * thetaO * sinThetaO + b.cosThetaO);
+
+    const Vector extent = centroidBounds.diagonal();
+    const float aspect = std::max({ extent.x(), extent.y(), extent.z() }) / extent[dim];
+
+    const Vector d = b.bounds.diagonal();
+    const float surfaceArea = 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+    return b.phi * solidAngle * aspect * surfaceArea;
+}
+
+LightBVH::LightBVH(const std::vector<std::pair<const Light *, LightBounds>> &lights) {
+    std::vector<Primitive> primitives;
+    for (const auto &[light, bounds] : lights) {
+        if (bounds.phi > 0) {
+            primitives.push_back({ light, bounds });
+        }
+    }
+    if (primitives.empty())
+        return;
+
+    m_nodes.reserve(2 * primitives.size() - 1);
+    build(primitives, 0, int(primitives.size()), 0, 0);
+    logger(EInfo, "built light BVH with %d nodes for %d lights", m_nodes.size(), m_lights.size());
+}
+
+int LightBVH::build(std::vector<Primitive> &primitives, int begin, int end, uint64_t bitTrail, int depth) {
+    const int nodeIndex = int(m_nodes.size());
+    m_nodes.emplace_back();
+
+    if (end - begin == 1) {
+        m_bitTrails[primitives[begin].light] = bitTrail;
+        m_nodes[nodeIndex] = {
+            .bounds = primitives[begin].bounds,
+            .index = int(m_lights.size()),
+            .isLeaf = true,
+        };
+        m_lights.push_back(primitives[begin].light);
+        return nodeIndex;
+    }
+
+    Bounds centroidBounds = Bounds::empty();
+    for (int i = begin; i < end; i++) {
+        centroidBounds.extend(primitives[i].bounds.bounds.center());
+    }
+
+    // find the best split among a fixed number of buckets along each axis
+    constexpr int BucketCount = 12;
+    float minCost = Infinity;
+    int minDim = -1, minBucket = -1;
+    for (int dim = 0; dim < 3; dim++) {
+        const float extent = centroidBounds.max()[dim] - centroidBounds.min()[dim];
+        if (!(extent > 0))
+            continue;
+
+        const auto bucketOf = [&](const Primitive &primitive) {
+            const float offset = (primitive.bounds.bounds.center()[dim] - centroidBounds.min()[dim]) / extent;
+            return std::clamp(int(offset * BucketCount), 0, BucketCount - 1);
+        };
+
+        std::array<LightBounds, BucketCount> buckets;
+        for (int i = begin; i < end; i++) {
+            LightBounds &bucket = buckets[bucketOf(primitives[i])];
+            bucket = LightBounds::merge(bucket, primitives[i].bounds);
+        }
+
+        for (int split = 0; split < BucketCount - 1; split++) {
+            LightBounds below, above;
+            for (int i = 0; i <= split; i++) below = LightBounds::merge(below, buckets[i]);
+            for (int i = split + 1; i < BucketCount; i++) above = LightBounds::merge(above, buckets[i]);
+            if (below.phi == 0 || above.phi == 0)
+                continue;
+
+            const float cost = evaluateCost(below, centroidBounds, dim) + evaluateCost(above, centroidBounds, dim);
+            if (cost < minCost) {
+                minCost = cost;
+                minDim = dim;
+                minBucket = split;
+            }
+        }
+    }
+
+    int mid = (begin + end) / 2;
+    // the bit trail only has room for 64 decisions, so very deep trees fall back to balanced splits
+    if (minDim >= 0 && depth < 48) {
+        const float extent = centroidBounds.max()[minDim] - centroidBounds.min()[minDim];
+        const auto it = std::partition(
+            primitives.begin() + begin, primitives.begin() + end, [&](const Primitive &primitive) {
+                const float offset = (primitive.bounds.bounds.center()[minDim] - centroidBounds.min()[minDim]) / extent;
+                return std::clamp(int(offset * BucketCount), 0, BucketCount - 1) <= minBucket;
+            });
+        const int partitioned = int(it - primitives.begin());
+        if (partitioned != begin && partitioned != end) {
+            mid = partitioned;
+        }
+    }
+
+    build(primitives, begin, mid, bitTrail, depth + 1);
+    const int secondChild = build(primitives, mid, end, bitTrail | (uint64_t(1) << depth), depth + 1);
+
+    m_nodes[nodeIndex] = {
+        .bounds = LightBounds::merge(m_nodes[nodeIndex + 1].bounds, m_nodes[secondChild].bounds),
+        .index = secondChild,
+        .isLeaf = false,
+    };
+    return nodeIndex;
+}
+
+LightBVH::Sample LightBVH::sample(const Point &origin, float u) const {
+    if (m_nodes.empty())
+        return { .light = nullptr, .probability = 0 };
+
+    int nodeIndex = 0;
+    float probability = 1;
+    while (true) {
+        const Node &node = m_nodes[nodeIndex];
+        if (node.isLeaf) {
+            if (nodeIndex > 0 || node.bounds.importance(origin) > 0)
+                return { .light = m_lights[node.index], .probability = probability };
+            return { .light = nullptr, .probability = 0 };
+        }
+
+        const float importance0 = m_nodes[nodeIndex + 1].bounds.importance(origin);
+        const float importance1 = m_nodes[node.index].bounds.importance(origin);
+        if (importance0 == 0 && importance1 == 0)
+            return { .light = nullptr, .probability = 0 };
+
+        // descend and reuse the random number for the next decision
+        const float p0 = importance0 / (importance0 + importance1);
+        if (u < p0) {
+            probability *= p0;
+            u = std::min(u / p0, 0x1.fffffep-1f);
+            nodeIndex = nodeIndex + 1;
+        } else {
+            probability *= 1 - p0;
+            u = std::min((u - p0) / (1 - p0), 0x1.fffffep-1f);
+            nodeIndex = node.index;
+        }
+    }
+}
+
+float LightBVH::pdf(const Point &origin, const Light *light) const {
+    const auto it = m_bitTrails.find(light);
+    if (it == m_bitTrails.end())
+        return 0;
+
+    if (m_nodes[0].isLeaf)
+        return m_nodes[0].bounds.importance(origin) > 0 ? 1 : 0;
+
+    uint64_t bitTrail = it->second;
+    int nodeIndex = 0;
+    float probability = 1;
+    while (!m_nodes[nodeIndex].isLeaf) {
+        const Node &node = m_nodes[nodeIndex];
+        const float importance0 = m_nodes[nodeIndex + 1].bounds.importance(origin);
+        const float importance1 = m_nodes[node.index].bounds.importance(origin);
+        if (importance0 == 0 && importance1 == 0)
+            return 0;
+
+        if (bitTrail & 1) {
+            probability *= importance1 / (importance0 + importance1);
+            nodeIndex = node.index;
+        } else {
+            probability *= importance0 / (importance0 + importance1);
+            nodeIndex = nodeIndex + 1;
+        }
+        bitTrail >>= 1;
+    }
+    return probability;
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/light.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief A bounding volume hierarchy over light sources, which picks lights proportional to their estimated
+ * contribution to a given point in logarithmic time.
+ * Each node stores the @ref LightBounds of all lights below it. Traversal descends into either child with a
+ * probability proportional to the importance of its bounds, which also allows computing the exact probability of
+ * picking a given light (by following the path to its leaf, which is stored as a bit trail).
+ * @see "Physically Based Rendering: From Theory to Implementation" (Pharr et al., 4th edition), Section 12.6.3
+ */
+class LightBVH {
+    struct Node {
+        LightBounds bounds;
+        /// @brief For leaves, the index of the light. For inner nodes, the index of the second child (the first child
+        /// directly follows its parent).
+        int index;
+        bool isLeaf;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<const Light *> m_lights;
+    /// @brief For each light, the decisions (0 for first child, 1 for second child) leading from the root to its
+    /// leaf, starting at the least significant bit.
+    std::unordered_map<const Light *, uint64_t> m_bitTrails;
+
+    struct Primitive {
+        const Light *light;
+        LightBounds bounds;
+    };
+
+    int build(std::vector<Primitive> &primitives, int begin, int end, uint64_t bitTrail, int depth);
+
+public:
+    struct Sample {
+        const Light *light;
+        float probability;
+    };
+
+    /// @brief Builds the hierarchy over lights with the given bounds (the power @c phi must already be set).
+    LightBVH(const std::vector<std::pair<const Light *, LightBounds>> &lights);
+
+    /// @brief Reports whether the hierarchy contains no lights.
+    bool empty() const { return m_nodes.empty(); }
+
+    /**
+     * @brief Picks a light proportional to its estimated contribution to @c origin .
+     * @returns A light with a probability of zero if no light can contribute to the given point.
+     */
+    Sample sample(const Point &origin, float u) const;
+    /// @brief Returns the probability of @ref sample picking the given light for the given point.
+    float pdf(const Point &origin, const Light *light) const;
+};
+
+}
@@ -1,9 +1,14 @@
 #include <lightwave/core.hpp>
+#include <lightwave/image.hpp>
 #include <lightwave/registry.hpp>
 #include <lightwave/logger.hpp>
+#include <lightwave/parallel.hpp>
+#include <lightwave/telemetry.hpp>
 
 #include "parser.hpp"
+#include "server.hpp"
 
+#include <cctype>
 #include <fstream>
 
 #ifdef LW_OS_WINDOWS
@@ -34,24 +39,79 @@ int main(int argc, const char *argv[]) {
     // _set_abort_behavior(0, _WRITE_ABORT_MSG | _CALL_REPORTFAULT);
 #endif
 
+    std::filesystem::path scenePath;
+    std::filesystem::path telemetryPath;
+    int result = 0;
+
     try {
-        if (argc <= 1) {
+        bool serverMode = false;
+        int serverPort = RenderServer::DefaultPort;
+
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            if (argument == "--server") {
+                serverMode = true;
+                if (i + 1 < argc && std::isdigit((unsigned char) argv[i + 1][0])) {
+                    serverPort = std::stoi(argv[++i]);
+                }
+            } else if (argument == "--threads") {
+                if (i + 1 >= argc || std::stoi(argv[i + 1]) <= 0) {
+                    logger(EError, "--threads expects a positive number of threads");
+                    return -1;
+                }
+                setThreadCount(std::stoi(argv[++i]));
+            } else if (argument == "--telemetry") {
+                if (i + 1 >= argc) {
+                    logger(EError, "--telemetry expects a path for the JSON output");
+                    return -1;
+                }
+                telemetryPath = argv[++i];
+            } else if (scenePath.empty()) {
+                scenePath = argument;
+            } else {
+                logger(EError, "unexpected argument \"%s\"", argument);
+                return -1;
+            }
+        }
+
+        if (serverMode) {
+            if (!scenePath.empty()) {
+                logger(EError, "server mode does not take a scene path, scenes are specified per job");
+                return -1;
+            }
+            if (serverPort <= 0 || serverPort > 65535) {
+                logger(EError, "invalid port %d", serverPort);
+                return -1;
+            }
+            return RenderServer(uint16_t(serverPort)).run() ? 0 : 1;
+        }
+
+        if (scenePath.empty()) {
             logger(EError, "please specify path to scene");
             return -1;
         }
-        
-        std::filesystem::path scenePath = argv[1];
 
-        SceneParser parser { scenePath };
-        for (auto &object : parser.objects()) {
+        std::unique_ptr<SceneParser> parser;
+        {
+            Telemetry::ScopedTimer timer{ Telemetry::EParse };
+            parser = std::make_unique<SceneParser>(scenePath);
+        }
+        for (auto &object : parser->objects()) {
             if (auto executable = dynamic_cast<Executable *>(object.get())) {
                 executable->execute();
             }
         }
     } catch(const std::exception &e) {
         print_exception(e);
-        return 1;
+        result = 1;
+    }
+    // images are written in the background, and must be complete before exiting
+    Image::waitForPendingSaves();
+
+    // also written for failed jobs, so that partial timings are available
+    if (!telemetryPath.empty()) {
+        Telemetry::writeJSON(telemetryPath, scenePath);
     }
 
-    return 0;
+    return result;
 }
@@ -175,4 +175,97 @@ BsdfEval Intersection::evaluateBsdf(const Vector& wi) const {
     return instance->bsdf()->evaluate(uv, frame.toLocal(wo), frame.toLocal(wi));
 }
 
+float Intersection::pdfBsdf(const Vector& wi) const {
+    if (instance->bsdf() == nullptr) {
+        return 0;
+    }
+    return instance->bsdf()->pdf(uv, frame.toLocal(wo), frame.toLocal(wi));
+}
+
+/// @brief Finds where a ray hits the tangent plane of a surface, relative to the given point on the surface.
+static bool offsetOnTangentPlane(const SurfaceEvent& surf, const Point& origin, const Vector& direction, Vector& offset) {
+    const float t = surf.frame.normal.dot(surf.position - origin) / surf.frame.normal.dot(direction);
+    offset = origin + t * direction - surf.position;
+    return std::isfinite(t);
+}
+
+void Intersection::computeDifferentials(const RayDifferential& ray) {
+    uv.dx = Vector2(0);
+    uv.dy = Vector2(0);
+    if (!ray.hasDifferentials) {
+        return;
+    }
+
+    // The offsets are expressed in terms of dpdu and dpdv, which need not be orthogonal, by solving the normal
+    // equations of the least squares problem dp = du * dpdu + dv * dpdv with the Gram matrix [[a, b], [b, c]]
+    const float a = dpdu.dot(dpdu);
+    const float b = dpdu.dot(dpdv);
+    const float c = dpdv.dot(dpdv);
+    const float determinant = a * c - b * b;
+    if (!(determinant > 0)) {
+        // without derivatives provided by the shape, the footprint remains unknown
+        return;
+    }
+
+    // The offset rays are intersected with the tangent plane, which approximates the surface around the hit point
+    Vector dpdx, dpdy;
+    if (!offsetOnTangentPlane(*this, ray.originX, ray.directionX, dpdx) ||
+        !offsetOnTangentPlane(*this, ray.originY, ray.directionY, dpdy)) {
+        return;
+    }
+    const auto solve = [&](const Vector& dp) {
+        const float pu = dpdu.dot(dp);
+        const float pv = dpdv.dot(dp);
+        return Vector2((c * pu - b * pv) / determinant, (a * pv - b * pu) / determinant);
+    };
+    uv.dx = solve(dpdx);
+    uv.dy = solve(dpdy);
+}
+
+RayDifferential Intersection::spawnRay(const RayDifferential& ray, const Vector& wi, bool specular) const {
+    RayDifferential result = Ray(position, wi);
+    if (!specular || !ray.hasDifferentials) {
+        return result;
+    }
+
+    Vector dpdx, dpdy;
+    if (!offsetOnTangentPlane(*this, ray.originX, ray.directionX, dpdx) ||
+        !offsetOnTangentPlane(*this, ray.originY, ray.directionY, dpdy)) {
+        return result;
+    }
+
+    // Specular reflection mirrors the tangential component of directions, and refraction additionally scales it by
+    // the relative index of refraction, which can be recovered from the sampled direction
+    const Vector woLocal = frame.toLocal(wo);
+    const Vector wiLocal = frame.toLocal(wi);
+    float scale = 1;
+    if (!Frame::sameHemisphere(woLocal, wiLocal)) {
+        const float sinThetaO = Frame::sinTheta(woLocal);
+        if (sinThetaO < 1e-3f) {
+            // at normal incidence, the index of refraction cannot be told
+            return result;
+        }
+        scale = Frame::sinTheta(wiLocal) / sinThetaO;
+    }
+
+    const auto bounce = [&](const Vector& direction, Vector& bounced) {
+        const Vector w = frame.toLocal(-direction);
+        const float sinTheta2 = sqr(scale) * (sqr(w.x()) + sqr(w.y()));
+        if (sinTheta2 >= 1) {
+            // total internal reflection of the offset ray
+            return false;
+        }
+        const float cosTheta = std::copysign(std::sqrt(1 - sinTheta2), wiLocal.z());
+        bounced = frame.toWorld({ -scale * w.x(), -scale * w.y(), cosTheta });
+        return true;
+    };
+    if (!bounce(ray.directionX, result.directionX) || !bounce(ray.directionY, result.directionY)) {
+        return result;
+    }
+    result.originX = position + dpdx;
+    result.originY = position + dpdy;
+    result.hasDifferentials = true;
+    return result;
+}
+
 } // namespace lightwave
@@ -1,3 +1,4 @@
+#include <lightwave/image.hpp>
 #include <lightwave/properties.hpp>
 #include <lightwave/registry.hpp>
 #include <lightwave/transform.hpp>
@@ -101,6 +102,14 @@ struct SceneParser::ObjectNode : public SceneParser::Node {
 
     void close() override {
         ref<Object> object = transform ? transform : Registry::create(tag, type, properties);
+        if (properties.has("filename")) {
+            // meshes and images are loaded from files that can change independently of the scene file
+            const auto path = properties.get<std::filesystem::path>("filename");
+            auto &files = getRoot().sceneParser.m_files;
+            if (std::filesystem::is_regular_file(path) && std::find(files.begin(), files.end(), path) == files.end()) {
+                files.push_back(path);
+            }
+        }
         if (id != "") {
             object->setId(id);
             getRoot().nameObject(id, object);
@@ -177,6 +186,7 @@ struct SceneParser::IncludeNode : public SceneParser::Node {
 
     void close() override {
         filepath = parent->getFilePath().remove_filename() / filename;
+        getRoot().sceneParser.m_files.push_back(filepath);
         XMLParser(getRoot().sceneParser, filepath);
     }
 };
@@ -269,6 +279,64 @@ struct SceneParser::TransformNode : public SceneParser::Node {
     }
 };
 
+/**
+ * @brief Collects the image files referenced by a scene (and the files it includes), without creating any objects.
+ * This allows decoding all textures in parallel before the scene is built, instead of one after another as their
+ * objects are created.
+ */
+class ImageCollector : public XMLParser::Delegate {
+    struct Node {
+        std::string tag;
+        std::map<std::string, std::string> attributes;
+
+        std::string get(const std::string &name) const {
+            auto it = attributes.find(name);
+            return it == attributes.end() ? "" : it->second;
+        }
+    };
+
+    std::vector<Node> m_stack;
+    std::vector<std::filesystem::path> m_files;
+
+public:
+    std::vector<Image::Source> sources;
+
+    ImageCollector(const std::filesystem::path &path) {
+        m_files.push_back(path);
+        XMLParser(*this, path);
+    }
+
+    void open(const std::string &tag) override { m_stack.push_back({ .tag = tag, .attributes = {} }); }
+    void enter() override {}
+    void attribute(const std::string &name, const std::string &value) override {
+        m_stack.back().attributes[name] = value;
+    }
+
+    void close() override {
+        const Node node = std::move(m_stack.back());
+        m_stack.pop_back();
+        const auto basePath = std::filesystem::path(m_files.back()).remove_filename();
+
+        if ((node.tag == "string" || node.tag == "boolean") && !m_stack.empty()) {
+            // parameters can also be given as child nodes, e.g., <string name="filename" value="..."/>
+            m_stack.back().attributes[node.get("name")] = node.get("value");
+        } else if (node.tag == "include") {
+            m_files.push_back(basePath / node.get("filename"));
+            XMLParser(*this, m_files.back());
+            m_files.pop_back();
+        } else if (node.tag == "image" || (node.tag == "texture" && node.get("type") == "image")) {
+            if (node.get("filename").empty())
+                return;
+            const std::string linear = node.get("linear");
+            sources.push_back({
+                .path = basePath / node.get("filename"),
+                .isLinearSpace = !linear.empty() && parse_string<bool>(linear),
+                .layer = node.get("layer"),
+            });
+        }
+    }
+};
+
 void SceneParser::open(const std::string &tag) {
     auto parent = m_stack.top();
     if (tag == "include") {
@@ -325,10 +393,26 @@ void SceneParser::close() {
 }
 
 SceneParser::SceneParser(const std::filesystem::path &path) {
+    try {
+        Image::preload(ImageCollector(path).sources);
+    } catch (const std::exception &) {
+        // the scene is malformed, which will be reported (with more context) when parsing it below
+    }
+
     m_stack.push(std::make_shared<RootNode>(m_objects, path, *this));
-    XMLParser(*this, path);
+    m_files.push_back(path);
+    try {
+        XMLParser(*this, path);
+    } catch (...) {
+        Image::discardPreloaded();
+        throw;
+    }
+    // images that were not loaded (e.g., because their object ignored the filename) are no longer needed
+    Image::discardPreloaded();
 }
 
 std::vector<ref<Object>> SceneParser::objects() const { return m_objects; }
 
+const std::vector<std::filesystem::path> &SceneParser::files() const { return m_files; }
+
 }
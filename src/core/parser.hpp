@@ -23,6 +23,8 @@ protected:
 
     std::stack<ref<Node>> m_stack;
     std::vector<ref<Object>> m_objects;
+    /// @brief The scene file, all files it includes and all files its objects were loaded from (e.g., meshes and images).
+    std::vector<std::filesystem::path> m_files;
 
     std::string resolveVariables(const std::string &value);
 
@@ -34,6 +36,7 @@ protected:
 public:
     SceneParser(const std::filesystem::path &path);
     std::vector<ref<Object>> objects() const;
+    const std::vector<std::filesystem::path> &files() const;
 };
 
 }
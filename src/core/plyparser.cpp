@@ -1,5 +1,6 @@
 #include "plyparser.hpp"
 #include <lightwave/logger.hpp>
+#include <lightwave/telemetry.hpp>
 
 #include <climits>
 #include <fstream>
@@ -188,6 +189,7 @@ void readPLY(
     std::vector<Vertex> &vertices
 ) {
     logger(EInfo, "loading mesh %s", path);
+    Telemetry::ScopedTimer timer{ Telemetry::EPlyLoad };
     try {
         std::fstream stream(path, std::ios::in | std::ios::binary);
         if (!stream)
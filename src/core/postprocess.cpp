@@ -0,0 +1,105 @@
+#include <lightwave/postprocess.hpp>
+#include <lightwave/iterators.hpp>
+#include <lightwave/parallel.hpp>
+
+#include <cmath>
+
+namespace lightwave {
+
+ImageStatistics ImageStatistics::gather(const Image &image, const std::function<void(Color *, int)> &transform) {
+    const Point2i resolution = image.resolution();
+    std::vector<float> rowMaxima(resolution.y(), 0);
+    std::vector<double> rowLogSums(resolution.y(), 0);
+
+    for_each_parallel(Range(0, resolution.y()), [&](int y) {
+        const Color *row = image.data() + y * resolution.x();
+        std::vector<Color> transformed;
+        if (transform) {
+            transformed.assign(row, row + resolution.x());
+            transform(transformed.data(), resolution.x());
+            row = transformed.data();
+        }
+
+        // separate loops over contiguous luminances let compilers vectorize the logarithms, which dominate the cost
+        std::vector<float> luminance(resolution.x());
+        for (int x = 0; x < resolution.x(); x++)
+            luminance[x] = std::max(row[x].luminance(), 0.0f);
+
+        float maximum = 0;
+        for (const float value : luminance)
+            maximum = std::max(maximum, value);
+
+        float logSum = 0;
+        for (const float value : luminance) {
+            // the small offset keeps black pixels from dominating the geometric mean
+            logSum += fast_log2(1e-4f + value);
+        }
+
+        rowMaxima[y] = maximum;
+        rowLogSums[y] = double(logSum) * Ln2;
+    });
+
+    // combining the rows in order keeps the statistics deterministic
+    ImageStatistics statistics;
+    double logSum = 0;
+    for (int y = 0; y < resolution.y(); y++) {
+        statistics.maxLuminance = std::max(statistics.maxLuminance, rowMaxima[y]);
+        logSum += rowLogSums[y];
+    }
+    const int pixelCount = resolution.x() * resolution.y();
+    statistics.logAverageLuminance = pixelCount > 0 ? float(std::exp(logSum / pixelCount)) : 0;
+    return statistics;
+}
+
+void Postprocess::execute() {
+    if (!m_input) {
+        lightwave_throw("<postprocess /> needs an \"input\" image to process!");
+    }
+    if (!m_output) {
+        lightwave_throw("<postprocess /> needs an <image /> child to write its output to!");
+    }
+
+    m_output->initialize(m_input->resolution());
+    process(*m_input, *m_output);
+    if (m_save) {
+        m_output->save();
+    }
+}
+
+void Postprocess::process(const Image &input, Image &output) {
+    if (!isPointwise()) {
+        lightwave_throw("%s needs to implement process()", toString());
+    }
+    Postprocess *self = this;
+    applyPointwise(input, output, std::span(&self, 1));
+}
+
+void Postprocess::applyPointwise(const Image &input, Image &output, std::span<Postprocess *const> stages) {
+    for (size_t index = 0; index < stages.size(); index++) {
+        if (!stages[index]->needsStatistics())
+            continue;
+
+        const auto preceding = stages.first(index);
+        std::function<void(Color *, int)> transform;
+        if (!preceding.empty()) {
+            transform = [preceding](Color *pixels, int count) {
+                for (const auto *stage : preceding)
+                    stage->apply(pixels, count);
+            };
+        }
+        stages[index]->prepare(ImageStatistics::gather(input, transform));
+    }
+
+    const int width = input.resolution().x();
+    for_each_parallel(Range(0, input.resolution().y()), [&](int y) {
+        Color *row = output.data() + y * width;
+        if (&input != &output) {
+            std::copy_n(input.data() + y * width, width, row);
+        }
+        // all stages work on the same row while it is still in cache
+        for (const auto *stage : stages)
+            stage->apply(row, width);
+    });
+}
+
+} // namespace lightwave
@@ -2,11 +2,38 @@
 #include <lightwave/registry.hpp>
 #include <lightwave/integrator.hpp>
 #include <lightwave/shape.hpp>
+#include <lightwave/instance.hpp>
 #include <lightwave/camera.hpp>
 #include <lightwave/light.hpp>
+#include <lightwave/sampler.hpp>
+#include <lightwave/telemetry.hpp>
+
+#include "lightbvh.hpp"
 
 namespace lightwave {
 
+/// @brief A simple deterministic random number generator, used to estimate light power reproducibly at load time.
+class PowerEstimationSampler final : public Sampler {
+    uint64_t m_state = 0;
+
+protected:
+    int generate(float *values) override {
+        for (int i = 0; i < MaxBlockSize; i++) {
+            // 64 bit linear congruential generator (Knuth's MMIX constants), using only the high quality upper bits
+            m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+            values[i] = float(m_state >> 40) * 0x1p-24f;
+        }
+        return MaxBlockSize;
+    }
+
+    void reseed(int index) override { m_state = uint64_t(index); }
+    void reseed(const Point2i &pixel, int sampleIndex) override { reseed(sampleIndex); }
+
+public:
+    ref<Sampler> clone() const override { return std::make_shared<PowerEstimationSampler>(*this); }
+    std::string toString() const override { return "PowerEstimationSampler[]"; }
+};
+
 Scene::Scene(const Properties &properties) {
     m_camera = properties.getChild<Camera>();
     m_background = properties.getOptionalChild<BackgroundLight>();
@@ -20,6 +47,70 @@ Scene::Scene(const Properties &properties) {
     }
 
     m_shape->markAsVisible();
+    m_shape->markAsSceneRoot();
+
+    m_lightSelectionStrategy = properties.getEnum<LightSelection>("lightSelection", LightSelection::Power, {
+        { "uniform", LightSelection::Uniform },
+        { "power", LightSelection::Power },
+        { "bvh", LightSelection::BVH },
+    });
+    buildLightSet(m_lightSets[false], false);
+    // the second set only differs if some lights are not sampled unless intersectable lights are requested
+    const bool hasIntersectableOnlyLights = std::any_of(m_lights.begin(), m_lights.end(), [](const ref<Light> &light) {
+        return !light->canBeSampled() && light->canBeIntersected();
+    });
+    if (hasIntersectableOnlyLights) {
+        buildLightSet(m_lightSets[true], true);
+    } else {
+        m_lightSets[true] = m_lightSets[false];
+    }
+}
+
+void Scene::buildLightSet(LightSet &set, bool intersectableLights) {
+    const LightSelection strategy = m_lightSelectionStrategy;
+    const Bounds bounds = getBoundingBox();
+    PowerEstimationSampler rng;
+
+    std::vector<float> weights;
+    std::vector<std::pair<const Light *, LightBounds>> boundedLights;
+    for (const auto &light : m_lights) {
+        if (!light->canBeSampled() && !(intersectableLights && light->canBeIntersected()))
+            continue;
+
+        rng.seed(int(set.lights.size()));
+        const float power = strategy == LightSelection::Uniform ? 1 : light->estimatePower(bounds, rng);
+        if (!(power > 0)) {
+            // lights that are sampled by both sets have already been reported
+            if (!intersectableLights || !light->canBeSampled())
+                logger(EWarn, "light does not seem to emit any power and will not be sampled: %s", light);
+            continue;
+        }
+        set.lights.push_back(light.get());
+        weights.push_back(power);
+
+        if (strategy == LightSelection::BVH) {
+            if (auto lightBounds = light->getLightBounds()) {
+                lightBounds->phi = power;
+                boundedLights.emplace_back(light.get(), *lightBounds);
+            } else {
+                set.infiniteLights.push_back(light.get());
+            }
+        }
+    }
+
+    set.selection.build(weights);
+    for (size_t i = 0; i < set.lights.size(); i++) {
+        set.probabilities[set.lights[i]] = set.selection.pmf(int(i));
+    }
+
+    if (strategy == LightSelection::BVH) {
+        set.bvh = std::make_shared<LightBVH>(boundedLights);
+    }
+}
+
+float Scene::infiniteLightProbability(const LightSet &set) {
+    const size_t count = set.infiniteLights.size();
+    return float(count) / (count + (set.bvh->empty() ? 0 : 1));
 }
 
 std::string Scene::toString() const {
@@ -33,15 +124,27 @@ std::string Scene::toString() const {
     );
 }
 
+/// @brief Adds the statistics recorded while intersecting a ray to the telemetry of the calling thread.
+static void countTraversal(const Intersection &its) {
+    Telemetry::count(Telemetry::EBvhNodes, its.stats.bvhCounter);
+    Telemetry::count(Telemetry::EPrimitives, its.stats.primCounter);
+    Telemetry::count(Telemetry::EAlphaLookups, its.stats.alphaCounter);
+}
+
 Intersection Scene::intersect(const Ray &ray, Sampler &rng) const {
     Intersection its(-ray.direction);
     m_shape->intersect(ray, its, rng);
+    Telemetry::count(Telemetry::EClosestHitRays);
+    countTraversal(its);
     return its;
 }
 
 bool Scene::intersect(const Ray &ray, float tMax, Sampler &rng) const {
     Intersection its(-ray.direction, tMax * (1 - Epsilon));
-    return m_shape->intersect(ray, its, rng);
+    const bool hit = m_shape->intersect(ray, its, rng);
+    Telemetry::count(Telemetry::EShadowRays);
+    countTraversal(its);
+    return hit;
 }
 
 BackgroundLightEval Scene::evaluateBackground(const Vector &direction) const {
@@ -51,17 +154,75 @@ BackgroundLightEval Scene::evaluateBackground(const Vector &direction) const {
     return m_background->evaluate(direction);
 }
 
-LightSample Scene::sampleLight(Sampler &rng) const {
-    int lightIndex = int(rng.next() * m_lights.size());
-    lightIndex = std::min(lightIndex, int(m_lights.size()) - 1);
+LightSample Scene::sampleLight(Sampler &rng, bool intersectableLights) const {
+    const LightSet &set = lightSet(intersectableLights);
+    if (set.lights.size() == 1) {
+        // nothing to choose, which saves the random numbers
+        return { .light = set.lights[0], .probability = 1 };
+    }
+
+    // scenes can have many lights, for which a single random number does not leave enough bits to pick the alias
+    const Point2 selection = rng.next2D();
+    const int lightIndex = set.selection.sample(selection.x(), selection.y());
+    return {
+        .light = set.lights[lightIndex],
+        .probability = set.selection.pmf(lightIndex),
+    };
+}
+
+float Scene::lightSelectionProbability(const Light *light, bool intersectableLights) const {
+    const LightSet &set = lightSet(intersectableLights);
+    const auto it = set.probabilities.find(light);
+    return it == set.probabilities.end() ? 0 : it->second;
+}
+
+float Scene::lightPdf(const Point &origin, const Light *light, const Vector &wi, bool intersectableLights) const {
+    const float selectionProbability = lightSelectionProbability(origin, light, intersectableLights);
+    if (selectionProbability == 0) return 0;
+    return selectionProbability * light->pdf(origin, wi);
+}
+
+float Scene::lightPdf(const Point &origin, const Intersection &its, bool intersectableLights) const {
+    const Light *light = its.instance->light();
+    if (!light) return 0;
+    const float selectionProbability = lightSelectionProbability(origin, light, intersectableLights);
+    if (selectionProbability == 0) return 0;
+    return selectionProbability * light->pdf(origin, its);
+}
+
+LightSample Scene::sampleLight(const Point &origin, Sampler &rng, bool intersectableLights) const {
+    const LightSet &set = lightSet(intersectableLights);
+    if (!set.bvh) return sampleLight(rng, intersectableLights);
+
+    // pick between the infinite lights (uniformly) and the light BVH, using a single random number
+    const float u = rng.next();
+    const float pInfinite = infiniteLightProbability(set);
+    if (u < pInfinite) {
+        const int count = int(set.infiniteLights.size());
+        const int index = std::min(int(u / pInfinite * count), count - 1);
+        return {
+            .light = set.infiniteLights[index],
+            .probability = pInfinite / count,
+        };
+    }
+
+    const LightBVH::Sample sample = set.bvh->sample(origin, std::min((u - pInfinite) / (1 - pInfinite), 0x1.fffffep-1f));
+    if (!sample.light) return LightSample::invalid();
     return {
-        .light = m_lights[lightIndex].get(),
-        .probability = float(1) / m_lights.size(),
+        .light = sample.light,
+        .probability = (1 - pInfinite) * sample.probability,
     };
 }
 
-float Scene::lightSelectionProbability(const Light *light) const {
-    return float(1) / m_lights.size();
+float Scene::lightSelectionProbability(const Point &origin, const Light *light, bool intersectableLights) const {
+    const LightSet &set = lightSet(intersectableLights);
+    if (!set.bvh) return lightSelectionProbability(light, intersectableLights);
+
+    const float pInfinite = infiniteLightProbability(set);
+    if (std::find(set.infiniteLights.begin(), set.infiniteLights.end(), light) != set.infiniteLights.end()) {
+        return pInfinite / set.infiniteLights.size();
+    }
+    return (1 - pInfinite) * set.bvh->pdf(origin, light);
 }
 
 Bounds Scene::getBoundingBox() const {
@@ -0,0 +1,258 @@
+#include <lightwave/camera.hpp>
+#include <lightwave/integrator.hpp>
+#include <lightwave/image.hpp>
+#include <lightwave/logger.hpp>
+#include <lightwave/postprocess.hpp>
+#include <lightwave/sampler.hpp>
+#include <lightwave/scene.hpp>
+
+#include "parser.hpp"
+#include "server.hpp"
+#include "socket.hpp"
+
+#include <cctype>
+#include <functional>
+
+namespace lightwave {
+
+/// @brief Joins the messages of an exception and all exceptions nested within it.
+static std::string describe(const std::exception &e) {
+    std::string message = e.what();
+    try {
+        std::rethrow_if_nested(e);
+    } catch (const std::exception &nested) {
+        message += ": " + describe(nested);
+    } catch (...) {}
+    return message;
+}
+
+/// @brief Splits a request into whitespace separated tokens, honoring double quotes.
+static std::vector<std::string> tokenize(const std::string &request) {
+    std::vector<std::string> tokens;
+    std::string current;
+    bool inToken  = false;
+    bool inQuotes = false;
+    for (const char chr : request) {
+        if (chr == '"') {
+            inQuotes = !inQuotes;
+            inToken  = true;
+        } else if (!inQuotes && std::isspace((unsigned char) chr)) {
+            if (inToken)
+                tokens.push_back(std::move(current));
+            current.clear();
+            inToken = false;
+        } else {
+            current += chr;
+            inToken = true;
+        }
+    }
+    if (inQuotes)
+        lightwave_throw("unterminated quote in request");
+    if (inToken)
+        tokens.push_back(std::move(current));
+    return tokens;
+}
+
+/// @brief Normalizes a scene path so that different spellings of the same file share one cache entry.
+static std::filesystem::path normalize(const std::filesystem::path &path) {
+    return std::filesystem::weakly_canonical(std::filesystem::absolute(path));
+}
+
+/// @brief Runs the registered callbacks in reverse order when going out of scope, used to undo per-job overrides.
+class OverrideGuard {
+    std::vector<std::function<void()>> m_restore;
+
+public:
+    ~OverrideGuard() {
+        for (auto it = m_restore.rbegin(); it != m_restore.rend(); it++)
+            (*it)();
+    }
+
+    void add(std::function<void()> &&restore) {
+        m_restore.push_back(std::move(restore));
+    }
+};
+
+bool RenderServer::CachedScene::isOutdated() const {
+    for (const auto &[path, time] : files) {
+        std::error_code ec;
+        if (std::filesystem::last_write_time(path, ec) != time || ec)
+            return true;
+    }
+    return false;
+}
+
+RenderServer::RenderServer(uint16_t port) : m_port(port) {}
+
+bool RenderServer::run() {
+    SocketInternal server;
+    if (!server.listen(m_port, "127.0.0.1")) {
+        logger(EError, "could not start render server on port %d", m_port);
+        return false;
+    }
+
+    logger(EInfo, "render server listening on %s:%d", server.IP, server.Port);
+    while (!m_quit) {
+        auto client = server.accept();
+        if (!client)
+            return false;
+
+        std::string request;
+        while (!m_quit && client->receiveLine(request)) {
+            if (request.empty())
+                continue;
+            const std::string response = handle(request) + "\n";
+            if (!client->sendAll(response.data(), response.size()))
+                break;
+        }
+    }
+
+    logger(EInfo, "render server shutting down");
+    return true;
+}
+
+std::string RenderServer::handle(const std::string &request) {
+    try {
+        const auto tokens = tokenize(request);
+        if (tokens.empty())
+            lightwave_throw("empty request");
+
+        Arguments arguments;
+        for (size_t i = 1; i < tokens.size(); i++) {
+            const size_t separator = tokens[i].find('=');
+            if (separator == std::string::npos)
+                lightwave_throw("expected key=value argument, got \"%s\"", tokens[i]);
+            arguments[tokens[i].substr(0, separator)] = tokens[i].substr(separator + 1);
+        }
+
+        const std::string &command = tokens.front();
+        if (command == "render") {
+            return render(arguments);
+        }
+        if (command == "evict") {
+            if (arguments.count("scene")) {
+                m_scenes.erase(normalize(arguments.at("scene")));
+            } else {
+                m_scenes.clear();
+            }
+            return "ok";
+        }
+        if (command == "quit") {
+            m_quit = true;
+            return "ok";
+        }
+        lightwave_throw("unknown command \"%s\"", command);
+    } catch (const std::exception &e) {
+        logger(EError, "%s", describe(e));
+        return "error " + describe(e);
+    }
+}
+
+const RenderServer::CachedScene &RenderServer::load(const std::filesystem::path &path) {
+    const auto key = normalize(path);
+    if (auto it = m_scenes.find(key); it != m_scenes.end()) {
+        if (!it->second.isOutdated()) {
+            logger(EInfo, "reusing resident scene %s", key.generic_string());
+            return it->second;
+        }
+        logger(EInfo, "scene %s was modified, reloading", key.generic_string());
+        m_scenes.erase(it);
+    }
+
+    if (!std::filesystem::exists(key))
+        lightwave_throw("scene file \"%s\" does not exist", key.generic_string());
+
+    CachedScene scene;
+    SceneParser parser { key };
+    for (const auto &file : parser.files()) {
+        scene.files.emplace_back(file, std::filesystem::last_write_time(file));
+    }
+    scene.objects = parser.objects();
+    return m_scenes[key] = std::move(scene);
+}
+
+std::string RenderServer::render(const Arguments &arguments) {
+    const auto find = [&](const std::string &key) -> const std::string * {
+        const auto it = arguments.find(key);
+        return it == arguments.end() ? nullptr : &it->second;
+    };
+
+    for (const auto &[key, value] : arguments) {
+        if (key != "scene" && key != "spp" && key != "output" &&
+            key != "origin" && key != "target" && key != "up") {
+            lightwave_throw("unsupported argument \"%s\" for render", key);
+        }
+    }
+
+    const std::string *scenePath = find("scene");
+    if (!scenePath)
+        lightwave_throw("render requires a scene argument");
+
+    const CachedScene &scene = load(*scenePath);
+
+    int spp = 0;
+    if (const std::string *value = find("spp")) {
+        spp = parse_string<int>(*value);
+        if (spp <= 0)
+            lightwave_throw("spp must be positive, got %d", spp);
+    }
+
+    ref<Transform> cameraTransform;
+    if (find("origin") || find("target") || find("up")) {
+        if (!find("origin") || !find("target"))
+            lightwave_throw("camera overrides require both origin and target");
+        cameraTransform = std::make_shared<Transform>();
+        cameraTransform->lookat(
+            parse_string<Vector>(*find("origin")),
+            parse_string<Vector>(*find("target")),
+            find("up") ? parse_string<Vector>(*find("up")) : Vector(0, 1, 0));
+    }
+
+    std::filesystem::path output;
+    if (const std::string *value = find("output")) {
+        output = *value;
+        std::filesystem::create_directories(output);
+    }
+
+    OverrideGuard guard;
+    const auto overrideOutput = [&](Image *image) {
+        if (!image || output.empty())
+            return;
+        guard.add([image, previous = image->basePath()]() { image->setBasePath(previous); });
+        image->setBasePath(output);
+    };
+
+    for (const auto &object : scene.objects) {
+        if (auto integrator = dynamic_cast<SamplingIntegrator *>(object.get())) {
+            if (spp) {
+                Sampler *sampler = integrator->sampler();
+                guard.add([sampler, previous = sampler->samplesPerPixel()]() {
+                    sampler->setSamplesPerPixel(previous);
+                });
+                sampler->setSamplesPerPixel(spp);
+            }
+            if (cameraTransform) {
+                Camera *camera = integrator->scene()->camera();
+                guard.add([camera, previous = camera->transform()]() {
+                    camera->setTransform(previous);
+                });
+                camera->setTransform(cameraTransform);
+            }
+            overrideOutput(integrator->image());
+        } else if (auto postprocess = dynamic_cast<Postprocess *>(object.get())) {
+            overrideOutput(postprocess->output());
+        }
+    }
+
+    Timer timer;
+    for (const auto &object : scene.objects) {
+        if (auto executable = dynamic_cast<Executable *>(object.get())) {
+            executable->execute();
+        }
+    }
+    // clients expect the images to be on disk once the render has been acknowledged
+    Image::waitForPendingSaves();
+    return tfm::format("ok %.3f", timer.getElapsedTime());
+}
+
+}
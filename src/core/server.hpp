@@ -0,0 +1,63 @@
+#pragma once
+
+#include <lightwave/core.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief Keeps parsed scenes (including their BVHs and textures) resident and renders them on request.
+ *
+ * The server listens on a local TCP socket and speaks a line-based protocol. Each request is a single line
+ * consisting of a command followed by optional @c key=value arguments (values containing spaces can be quoted):
+ * @code
+ * render scene=<path> [spp=<count>] [output=<directory>] [origin=x,y,z target=x,y,z up=x,y,z]
+ * evict [scene=<path>]
+ * quit
+ * @endcode
+ * Every request is answered with a single line, which is either @c "ok" (followed by the render time in seconds
+ * for render jobs) or @c "error <message>".
+ *
+ * Scenes are parsed on first use and reused by subsequent jobs until the scene file, one of the files it
+ * includes or one of the meshes and images it loads is modified. Overrides only apply to the job they were specified for, and affect the integrators and
+ * postprocesses at the root of the scene (tests keep rendering with the settings of the scene file).
+ */
+class RenderServer {
+public:
+    /// @brief The port the server listens on unless specified otherwise.
+    static constexpr uint16_t DefaultPort = 14159;
+
+    explicit RenderServer(uint16_t port = DefaultPort);
+
+    /// @brief Accepts connections and processes their requests until a @c quit request is received.
+    /// @returns false if the server socket could not be opened.
+    bool run();
+
+private:
+    struct CachedScene {
+        /// @brief The root level objects of the scene.
+        std::vector<ref<Object>> objects;
+        /// @brief The scene file, its includes and its assets with their modification times when they were parsed.
+        std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> files;
+
+        bool isOutdated() const;
+    };
+
+    using Arguments = std::map<std::string, std::string>;
+
+    /// @brief Processes a single request and returns the response line (without terminating newline).
+    std::string handle(const std::string &request);
+    std::string render(const Arguments &arguments);
+    const CachedScene &load(const std::filesystem::path &path);
+
+    uint16_t m_port;
+    bool m_quit = false;
+    std::map<std::filesystem::path, CachedScene> m_scenes;
+};
+
+}
@@ -0,0 +1,590 @@
+#pragma once
+
+#include <lightwave/logger.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#ifdef LW_OS_WINDOWS
+#define USE_WIN32
+#endif
+
+#ifdef USE_WIN32
+#define NOMINMAX
+#define _WINSOCK_DEPRECATED_NO_WARNINGS
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace lightwave {
+
+#ifdef USE_WIN32
+using socket_t = SOCKET;
+
+/* The error string is the same in
+ * http://msdn.microsoft.com/library/ms740668.aspx So more information about the
+ * error could you find in this very nice page :D
+ */
+static inline const char *getErrorString() {
+    switch (WSAGetLastError()) {
+        case WSA_INVALID_HANDLE:
+            return "Specified event object handle is invalid";
+        case WSA_NOT_ENOUGH_MEMORY:
+            return "Insufficient memory available";
+        case WSA_INVALID_PARAMETER:
+            return "One or more parameters are invalid";
+        case WSA_OPERATION_ABORTED:
+            return "Overlapped operation aborted";
+        case WSA_IO_INCOMPLETE:
+            return "Overlapped I/O event object not in signaled state";
+        case WSA_IO_PENDING:
+            return "Overlapped operations will complete later";
+        case WSAEINTR:
+            return "Interrupted function call";
+        case WSAEBADF:
+            return "File handle is not valid";
+        case WSAEACCES:
+            return "Permission denied";
+        case WSAEFAULT:
+            return "Bad address";
+        case WSAEINVAL:
+            return "Invalid argument";
+        case WSAEMFILE:
+            return "Too many open files";
+        case WSAEWOULDBLOCK:
+            return "Resource temporarily unavailable";
+        case WSAEINPROGRESS:
+            return "Operation now in progress";
+        case WSAEALREADY:
+            return "Operation already in progress";
+        case WSAENOTSOCK:
+            return "Socket operation on nonsocket";
+        case WSAEDESTADDRREQ:
+            return "Destination address required";
+        case WSAEMSGSIZE:
+            return "Message too long";
+        case WSAEPROTOTYPE:
+            return "Protocol wrong type for socket";
+        case WSAENOPROTOOPT:
+            return "Bad protocol option";
+        case WSAEPROTONOSUPPORT:
+            return "Protocol not supported";
+        case WSAESOCKTNOSUPPORT:
+            return "Socket type not supported";
+        case WSAEOPNOTSUPP:
+            return "Operation not supported";
+        case WSAEPFNOSUPPORT:
+            return "Protocol family not supported";
+        case WSAEAFNOSUPPORT:
+            return "Address family not supported by protocol family";
+        case WSAEADDRINUSE:
+            return "Address already in use";
+        case WSAEADDRNOTAVAIL:
+            return "Cannot assign requested address";
+        case WSAENETDOWN:
+            return "Network is down";
+        case WSAENETUNREACH:
+            return "Network is unreachable";
+        case WSAENETRESET:
+            return "Network dropped connection on reset";
+        case WSAECONNABORTED:
+            return "Software caused connection abort";
+        case WSAECONNRESET:
+            return "Connection reset by peer";
+        case WSAENOBUFS:
+            return "No buffer space available";
+        case WSAEISCONN:
+            return "Socket is already connected";
+        case WSAENOTCONN:
+            return "Socket is not connected";
+        case WSAESHUTDOWN:
+            return "Cannot send after socket shutdown";
+        case WSAETOOMANYREFS:
+            return "Too many references";
+        case WSAETIMEDOUT:
+            return "Connection timed out";
+        case WSAECONNREFUSED:
+            return "Connection refused";
+        case WSAELOOP:
+            return "Cannot translate name";
+        case WSAENAMETOOLONG:
+            return "Name too long";
+        case WSAEHOSTDOWN:
+            return "Host is down";
+        case WSAEHOSTUNREACH:
+            return "No route to host";
+        case WSAENOTEMPTY:
+            return "Directory not empty";
+        case WSAEPROCLIM:
+            return "Too many processes";
+        case WSAEUSERS:
+            return "User quota exceeded";
+        case WSAEDQUOT:
+            return "Disk quota exceeded";
+        case WSAESTALE:
+            return "Stale file handle reference";
+        case WSAEREMOTE:
+            return "Item is remote";
+        case WSASYSNOTREADY:
+            return "Network subsystem is unavailable";
+        case WSAVERNOTSUPPORTED:
+            return "Winsock.dll version out of range";
+        case WSANOTINITIALISED:
+            return "Successful WSAStartup not yet performed";
+        case WSAEDISCON:
+            return "Graceful shutdown in progress";
+        case WSAENOMORE:
+            return "No more results";
+        case WSAECANCELLED:
+            return "Call has been canceled";
+        case WSAEINVALIDPROCTABLE:
+            return "Procedure call table is invalid";
+        case WSAEINVALIDPROVIDER:
+            return "Service provider is invalid";
+        case WSAEPROVIDERFAILEDINIT:
+            return "Service provider failed to initialize";
+        case WSASYSCALLFAILURE:
+            return "System call failure";
+        case WSASERVICE_NOT_FOUND:
+            return "Service not found";
+        case WSATYPE_NOT_FOUND:
+            return "Class type not found";
+        case WSA_E_NO_MORE:
+            return "No more results";
+        case WSA_E_CANCELLED:
+            return "Call was canceled";
+        case WSAEREFUSED:
+            return "Database query was refused";
+        case WSAHOST_NOT_FOUND:
+            return "Host not found";
+        case WSATRY_AGAIN:
+            return "Nonauthoritative host not found";
+        case WSANO_RECOVERY:
+            return "This is a nonrecoverable error";
+        case WSANO_DATA:
+            return "Valid name, no data record of requested type";
+        case WSA_QOS_RECEIVERS:
+            return "QOS receivers";
+        case WSA_QOS_SENDERS:
+            return "QOS senders";
+        case WSA_QOS_NO_SENDERS:
+            return "No QOS senders";
+        case WSA_QOS_NO_RECEIVERS:
+            return "QOS no receivers";
+        case WSA_QOS_REQUEST_CONFIRMED:
+            return "QOS request confirmed";
+        case WSA_QOS_ADMISSION_FAILURE:
+            return "QOS admission error";
+        case WSA_QOS_POLICY_FAILURE:
+            return "QOS policy failure";
+        case WSA_QOS_BAD_STYLE:
+            return "QOS bad style";
+        case WSA_QOS_BAD_OBJECT:
+            return "QOS bad object";
+        case WSA_QOS_TRAFFIC_CTRL_ERROR:
+            return "QOS traffic control error";
+        case WSA_QOS_GENERIC_ERROR:
+            return "QOS generic error";
+        case WSA_QOS_ESERVICETYPE:
+            return "QOS service type error";
+        case WSA_QOS_EFLOWSPEC:
+            return "QOS flowspec error";
+        case WSA_QOS_EPROVSPECBUF:
+            return "Invalid QOS provider buffer";
+        case WSA_QOS_EFILTERSTYLE:
+            return "Invalid QOS filter style";
+        case WSA_QOS_EFILTERTYPE:
+            return "Invalid QOS filter type";
+        case WSA_QOS_EFILTERCOUNT:
+            return "Incorrect QOS filter count";
+        case WSA_QOS_EOBJLENGTH:
+            return "Invalid QOS object length";
+        case WSA_QOS_EFLOWCOUNT:
+            return "Incorrect QOS flow count";
+        case WSA_QOS_EUNKOWNPSOBJ:
+            return "Unrecognized QOS object";
+        case WSA_QOS_EPOLICYOBJ:
+            return "Invalid QOS policy object";
+        case WSA_QOS_EFLOWDESC:
+            return "Invalid QOS flow descriptor";
+        case WSA_QOS_EPSFLOWSPEC:
+            return "Invalid QOS provider-specific flowspec";
+        case WSA_QOS_EPSFILTERSPEC:
+            return "Invalid QOS provider-specific filterspec";
+        case WSA_QOS_ESDMODEOBJ:
+            return "Invalid QOS shape discard mode object";
+        case WSA_QOS_ESHAPERATEOBJ:
+            return "Invalid QOS shaping rate object";
+        case WSA_QOS_RESERVED_PETYPE:
+            return "Reserved policy QOS element type";
+        default:
+            return "Unknown error occured";
+    }
+}
+
+static inline void printError() {
+    logger(EWarn, "network error: %s", getErrorString());
+}
+
+static inline bool isSocketError(int error) {
+    if (error == SOCKET_ERROR) {
+        printError();
+        return true;
+    }
+
+    return false;
+}
+
+static inline bool getAddressFromString4(const std::string &ip,
+                                         sockaddr_in &addr) {
+    addrinfo *_addrinfo;
+    bool good   = false;
+    int errcode = ::getaddrinfo(ip.c_str(), nullptr, nullptr, &_addrinfo);
+    if (errcode != 0) {
+        logger(EWarn, "cannot resolve address %s: %s", ip, getErrorString());
+        return good;
+    } else {
+        for (auto it = _addrinfo; it; it = it->ai_next) {
+            if (it->ai_family == AF_INET) {
+                addr = *(sockaddr_in *) it->ai_addr;
+                good = true;
+                break;
+            }
+        }
+    }
+
+    freeaddrinfo(_addrinfo);
+    return good;
+}
+
+static inline void closeSocket(socket_t socket) { ::closesocket(socket); }
+
+static bool setBlocking(socket_t socket, bool is_blocking) {
+    u_long state = is_blocking ? 0 : 1;
+    int error    = ioctlsocket(socket, FIONBIO, &state);
+    return !isSocketError(error);
+}
+
+static inline bool initNetwork() {
+    WORD version;
+    WSADATA wsa;
+
+    version   = MAKEWORD(2, 2);
+    int error = WSAStartup(version, &wsa);
+
+    if (error) {
+        logger(EWarn, "could not init WinSock2: %s", getErrorString());
+        return false;
+    }
+
+    if (LOBYTE(wsa.wVersion) != 2 || HIBYTE(wsa.wVersion) != 2) {
+        logger(EWarn, "could not find a usable version of Winsock.dll");
+        WSACleanup();
+        return false;
+    }
+
+    return true;
+}
+
+static inline void closeNetwork() { WSACleanup(); }
+
+#else // Linux & macOS
+
+using socket_t               = int;
+constexpr int INVALID_SOCKET = -1;
+constexpr int SOCKET_ERROR   = -1;
+
+static inline const char *getErrorString() { return ::strerror(errno); }
+
+static inline void printError() {
+    logger(EWarn, "network error: %s", getErrorString());
+}
+
+static inline bool isSocketError(ssize_t error) {
+    if (error == SOCKET_ERROR) {
+        printError();
+        return true;
+    }
+
+    return false;
+}
+
+static inline bool getAddressFromString4(const std::string &ip,
+                                         sockaddr_in &addr) {
+    addrinfo *_addrinfo;
+    bool good   = false;
+    int errcode = ::getaddrinfo(ip.c_str(), nullptr, nullptr, &_addrinfo);
+    if (errcode != 0) {
+        logger(EWarn, "cannot resolve address %s: %s", ip, gai_strerror(errcode));
+        return good;
+    } else {
+        for (auto it = _addrinfo; it; it = it->ai_next) {
+            if (it->ai_family == AF_INET) {
+                addr = *(sockaddr_in *) it->ai_addr;
+                good = true;
+                break;
+            }
+        }
+    }
+
+    freeaddrinfo(_addrinfo);
+    return good;
+}
+
+static inline void closeSocket(socket_t socket) { ::close(socket); }
+#endif
+
+class SocketInternal {
+public:
+    socket_t Socket = INVALID_SOCKET;
+    std::string IP  = "127.0.0.1";
+    uint16_t Port   = 0;
+
+    bool IsClientConnection = false;
+    bool IsOpen             = false;
+    bool IsIp6              = false;
+
+    SocketInternal() {
+        static std::atomic_flag s_initialized = ATOMIC_FLAG_INIT;
+        if (!s_initialized.test_and_set()) {
+#ifdef USE_WIN32
+            initNetwork(); // We should close the network support but why
+                           // bother?
+#else
+            signal(SIGPIPE, SIG_IGN);
+#endif
+        }
+    }
+
+    ~SocketInternal() {
+        if (Socket != INVALID_SOCKET)
+            closeSocket(Socket);
+    }
+
+    // IPv4
+    inline bool connect(uint16_t port, const std::string &ip) {
+        assert(Socket == INVALID_SOCKET);
+
+        Socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (Socket == INVALID_SOCKET) {
+            logger(EWarn, "cannot create socket: %s", getErrorString());
+            return false;
+        }
+
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+
+        if (!getAddressFromString4(ip, addr)) {
+            logger(EWarn, "cannot convert IP address: %s", getErrorString());
+            return false;
+        }
+        addr.sin_family = AF_INET;
+        addr.sin_port   = htons(port);
+
+#ifdef LW_OS_WINDOWS
+        // Set socket non-blocking
+        if (!setBlocking(Socket, false))
+            return false;
+
+        int error = ::connect(Socket, (sockaddr *) &addr, sizeof(addr));
+
+        if (error == SOCKET_ERROR) {
+            // Handly async
+            if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                // Some weird error happened, give up
+                printError();
+                return false;
+            }
+
+            // connection pending
+            fd_set setW, setE;
+            FD_ZERO(&setW);
+            FD_SET(Socket, &setW);
+            FD_ZERO(&setE);
+            FD_SET(Socket, &setE);
+
+            TIMEVAL time_out = { 0, 0 };
+            time_out.tv_sec  = 0;
+            time_out.tv_usec = 1000; // 1 ms
+
+            error = select(0, NULL, &setW, &setE, &time_out);
+            if (isSocketError(error))
+                return false;
+
+            if (error == 0) {
+                logger(EWarn, "connection to %s:%d failed: timeout", ip, port);
+                return false;
+            }
+
+            if (FD_ISSET(Socket, &setE)) {
+                // connection failed
+                int err = 0;
+                int len = sizeof(err);
+                getsockopt(Socket, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+                WSASetLastError(err);
+                printError();
+                return false;
+            }
+        }
+        
+        // Set socket back to be blocking
+        if (!setBlocking(Socket, true))
+            return false;
+#else
+        int error = ::connect(Socket, (sockaddr *) &addr, sizeof(addr));
+
+        if (error == SOCKET_ERROR) {
+            logger(EWarn, "connection to %s:%d failed: %s", ip, port,
+                   getErrorString());
+            return false;
+        }
+#endif
+
+        IP   = ip;
+        Port = port;
+        return true;
+    }
+
+    // IPv4
+    inline bool listen(uint16_t port, const std::string &ip) {
+        assert(Socket == INVALID_SOCKET);
+
+        Socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (Socket == INVALID_SOCKET) {
+            logger(EWarn, "cannot create socket: %s", getErrorString());
+            return false;
+        }
+
+        int reuse = 1;
+        setsockopt(Socket, SOL_SOCKET, SO_REUSEADDR, (const char *) &reuse,
+                   sizeof(reuse));
+
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+
+        if (!getAddressFromString4(ip, addr)) {
+            logger(EWarn, "cannot convert IP address: %s", getErrorString());
+            return false;
+        }
+        addr.sin_family = AF_INET;
+        addr.sin_port   = htons(port);
+
+        if (isSocketError(::bind(Socket, (sockaddr *) &addr, sizeof(addr))))
+            return false;
+        if (isSocketError(::listen(Socket, SOMAXCONN)))
+            return false;
+
+        IP     = ip;
+        Port   = port;
+        IsOpen = true;
+        return true;
+    }
+
+    /// @brief Blocks until a client connects, returns nullptr on failure.
+    inline std::unique_ptr<SocketInternal> accept() {
+        assert(IsOpen);
+
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        const socket_t client = ::accept(Socket, (sockaddr *) &addr, &len);
+        if (client == INVALID_SOCKET) {
+            printError();
+            return nullptr;
+        }
+
+        auto result                = std::make_unique<SocketInternal>();
+        result->Socket             = client;
+        result->IsClientConnection = true;
+        result->IsOpen             = true;
+        return result;
+    }
+
+    /// @brief Sends the entire buffer, returns false if the connection broke.
+    inline bool sendAll(const char *data, size_t length) {
+#ifdef USE_WIN32
+        constexpr int flags = 0;
+#else
+        constexpr int flags = MSG_NOSIGNAL;
+#endif
+        size_t total = 0;
+        while (total < length) {
+            const auto ret =
+                ::send(Socket, data + total, (int) (length - total), flags);
+            if (isSocketError(ret))
+                return false;
+            total += size_t(ret);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reads the next newline-terminated line (without the terminator,
+     * and with a trailing carriage return stripped).
+     * @returns false if the peer closed the connection before a full line
+     * was received.
+     */
+    inline bool receiveLine(std::string &line) {
+        while (true) {
+            const size_t newline = Pending.find('\n');
+            if (newline != std::string::npos) {
+                line = Pending.substr(0, newline);
+                Pending.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                return true;
+            }
+
+            char buffer[4096];
+            const auto ret = ::recv(Socket, buffer, sizeof(buffer), 0);
+            if (ret == 0)
+                return false;
+            if (isSocketError(ret))
+                return false;
+            Pending.append(buffer, size_t(ret));
+        }
+    }
+
+    /// @brief Receives exactly @c length bytes, returns false if the peer closed the connection before.
+    inline bool receiveAll(char *data, size_t length) {
+        // bytes that were already received by receiveLine come first
+        size_t total = std::min(length, Pending.size());
+        memcpy(data, Pending.data(), total);
+        Pending.erase(0, total);
+
+        while (total < length) {
+            const auto ret =
+                ::recv(Socket, data + total, (int) (length - total), 0);
+            if (ret == 0)
+                return false;
+            if (isSocketError(ret))
+                return false;
+            total += size_t(ret);
+        }
+        return true;
+    }
+
+    /// @brief Ends communication in both directions, which wakes up threads that are blocked receiving.
+    inline void shutdown() {
+#ifdef USE_WIN32
+        ::shutdown(Socket, SD_BOTH);
+#else
+        ::shutdown(Socket, SHUT_RDWR);
+#endif
+    }
+
+private:
+    /// @brief Bytes received but not yet consumed by @ref receiveLine .
+    std::string Pending;
+};
+
+} // namespace lightwave
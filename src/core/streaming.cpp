@@ -1,471 +1,92 @@
 #include <lightwave/image.hpp>
 #include <lightwave/streaming.hpp>
 
+#include <array>
+#include <bit>
 #include <condition_variable>
 #include <cstring>
 #include <mutex>
 #include <thread>
 
-#ifdef LW_OS_WINDOWS
-#define USE_WIN32
-#endif
-
-#ifdef USE_WIN32
-#define NOMINMAX
-#define _WINSOCK_DEPRECATED_NO_WARNINGS
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#else
-#include <netdb.h>
-#include <netinet/in.h>
-#include <signal.h>
-#include <sys/socket.h>
-#include <unistd.h>
-#endif
+#include "socket.hpp"
 
 #include <lightwave/iterators.hpp>
 
 namespace lightwave {
 
-#ifdef USE_WIN32
-using socket_t = SOCKET;
-
-/* The error string is the same in
- * http://msdn.microsoft.com/library/ms740668.aspx So more information about the
- * error could you find in this very nice page :D
+/**
+ * @brief A bounded multi-producer queue that does not need locks (after Dmitry Vyukov's bounded MPMC queue).
+ * Each cell carries a sequence number that tells producers and consumers whether it is free or filled for their turn.
  */
-static inline const char *getErrorString() {
-    switch (WSAGetLastError()) {
-        case WSA_INVALID_HANDLE:
-            return "Specified event object handle is invalid";
-        case WSA_NOT_ENOUGH_MEMORY:
-            return "Insufficient memory available";
-        case WSA_INVALID_PARAMETER:
-            return "One or more parameters are invalid";
-        case WSA_OPERATION_ABORTED:
-            return "Overlapped operation aborted";
-        case WSA_IO_INCOMPLETE:
-            return "Overlapped I/O event object not in signaled state";
-        case WSA_IO_PENDING:
-            return "Overlapped operations will complete later";
-        case WSAEINTR:
-            return "Interrupted function call";
-        case WSAEBADF:
-            return "File handle is not valid";
-        case WSAEACCES:
-            return "Permission denied";
-        case WSAEFAULT:
-            return "Bad address";
-        case WSAEINVAL:
-            return "Invalid argument";
-        case WSAEMFILE:
-            return "Too many open files";
-        case WSAEWOULDBLOCK:
-            return "Resource temporarily unavailable";
-        case WSAEINPROGRESS:
-            return "Operation now in progress";
-        case WSAEALREADY:
-            return "Operation already in progress";
-        case WSAENOTSOCK:
-            return "Socket operation on nonsocket";
-        case WSAEDESTADDRREQ:
-            return "Destination address required";
-        case WSAEMSGSIZE:
-            return "Message too long";
-        case WSAEPROTOTYPE:
-            return "Protocol wrong type for socket";
-        case WSAENOPROTOOPT:
-            return "Bad protocol option";
-        case WSAEPROTONOSUPPORT:
-            return "Protocol not supported";
-        case WSAESOCKTNOSUPPORT:
-            return "Socket type not supported";
-        case WSAEOPNOTSUPP:
-            return "Operation not supported";
-        case WSAEPFNOSUPPORT:
-            return "Protocol family not supported";
-        case WSAEAFNOSUPPORT:
-            return "Address family not supported by protocol family";
-        case WSAEADDRINUSE:
-            return "Address already in use";
-        case WSAEADDRNOTAVAIL:
-            return "Cannot assign requested address";
-        case WSAENETDOWN:
-            return "Network is down";
-        case WSAENETUNREACH:
-            return "Network is unreachable";
-        case WSAENETRESET:
-            return "Network dropped connection on reset";
-        case WSAECONNABORTED:
-            return "Software caused connection abort";
-        case WSAECONNRESET:
-            return "Connection reset by peer";
-        case WSAENOBUFS:
-            return "No buffer space available";
-        case WSAEISCONN:
-            return "Socket is already connected";
-        case WSAENOTCONN:
-            return "Socket is not connected";
-        case WSAESHUTDOWN:
-            return "Cannot send after socket shutdown";
-        case WSAETOOMANYREFS:
-            return "Too many references";
-        case WSAETIMEDOUT:
-            return "Connection timed out";
-        case WSAECONNREFUSED:
-            return "Connection refused";
-        case WSAELOOP:
-            return "Cannot translate name";
-        case WSAENAMETOOLONG:
-            return "Name too long";
-        case WSAEHOSTDOWN:
-            return "Host is down";
-        case WSAEHOSTUNREACH:
-            return "No route to host";
-        case WSAENOTEMPTY:
-            return "Directory not empty";
-        case WSAEPROCLIM:
-            return "Too many processes";
-        case WSAEUSERS:
-            return "User quota exceeded";
-        case WSAEDQUOT:
-            return "Disk quota exceeded";
-        case WSAESTALE:
-            return "Stale file handle reference";
-        case WSAEREMOTE:
-            return "Item is remote";
-        case WSASYSNOTREADY:
-            return "Network subsystem is unavailable";
-        case WSAVERNOTSUPPORTED:
-            return "Winsock.dll version out of range";
-        case WSANOTINITIALISED:
-            return "Successful WSAStartup not yet performed";
-        case WSAEDISCON:
-            return "Graceful shutdown in progress";
-        case WSAENOMORE:
-            return "No more results";
-        case WSAECANCELLED:
-            return "Call has been canceled";
-        case WSAEINVALIDPROCTABLE:
-            return "Procedure call table is invalid";
-        case WSAEINVALIDPROVIDER:
-            return "Service provider is invalid";
-        case WSAEPROVIDERFAILEDINIT:
-            return "Service provider failed to initialize";
-        case WSASYSCALLFAILURE:
-            return "System call failure";
-        case WSASERVICE_NOT_FOUND:
-            return "Service not found";
-        case WSATYPE_NOT_FOUND:
-            return "Class type not found";
-        case WSA_E_NO_MORE:
-            return "No more results";
-        case WSA_E_CANCELLED:
-            return "Call was canceled";
-        case WSAEREFUSED:
-            return "Database query was refused";
-        case WSAHOST_NOT_FOUND:
-            return "Host not found";
-        case WSATRY_AGAIN:
-            return "Nonauthoritative host not found";
-        case WSANO_RECOVERY:
-            return "This is a nonrecoverable error";
-        case WSANO_DATA:
-            return "Valid name, no data record of requested type";
-        case WSA_QOS_RECEIVERS:
-            return "QOS receivers";
-        case WSA_QOS_SENDERS:
-            return "QOS senders";
-        case WSA_QOS_NO_SENDERS:
-            return "No QOS senders";
-        case WSA_QOS_NO_RECEIVERS:
-            return "QOS no receivers";
-        case WSA_QOS_REQUEST_CONFIRMED:
-            return "QOS request confirmed";
-        case WSA_QOS_ADMISSION_FAILURE:
-            return "QOS admission error";
-        case WSA_QOS_POLICY_FAILURE:
-            return "QOS policy failure";
-        case WSA_QOS_BAD_STYLE:
-            return "QOS bad style";
-        case WSA_QOS_BAD_OBJECT:
-            return "QOS bad object";
-        case WSA_QOS_TRAFFIC_CTRL_ERROR:
-            return "QOS traffic control error";
-        case WSA_QOS_GENERIC_ERROR:
-            return "QOS generic error";
-        case WSA_QOS_ESERVICETYPE:
-            return "QOS service type error";
-        case WSA_QOS_EFLOWSPEC:
-            return "QOS flowspec error";
-        case WSA_QOS_EPROVSPECBUF:
-            return "Invalid QOS provider buffer";
-        case WSA_QOS_EFILTERSTYLE:
-            return "Invalid QOS filter style";
-        case WSA_QOS_EFILTERTYPE:
-            return "Invalid QOS filter type";
-        case WSA_QOS_EFILTERCOUNT:
-            return "Incorrect QOS filter count";
-        case WSA_QOS_EOBJLENGTH:
-            return "Invalid QOS object length";
-        case WSA_QOS_EFLOWCOUNT:
-            return "Incorrect QOS flow count";
-        case WSA_QOS_EUNKOWNPSOBJ:
-            return "Unrecognized QOS object";
-        case WSA_QOS_EPOLICYOBJ:
-            return "Invalid QOS policy object";
-        case WSA_QOS_EFLOWDESC:
-            return "Invalid QOS flow descriptor";
-        case WSA_QOS_EPSFLOWSPEC:
-            return "Invalid QOS provider-specific flowspec";
-        case WSA_QOS_EPSFILTERSPEC:
-            return "Invalid QOS provider-specific filterspec";
-        case WSA_QOS_ESDMODEOBJ:
-            return "Invalid QOS shape discard mode object";
-        case WSA_QOS_ESHAPERATEOBJ:
-            return "Invalid QOS shaping rate object";
-        case WSA_QOS_RESERVED_PETYPE:
-            return "Reserved policy QOS element type";
-        default:
-            return "Unknown error occured";
-    }
-}
-
-static inline void printError() {
-    logger(EWarn, "connection to tev failed: %s", getErrorString());
-}
-
-static inline bool isSocketError(int error) {
-    if (error == SOCKET_ERROR) {
-        printError();
-        return true;
-    }
-
-    return false;
-}
-
-static inline bool getAddressFromString4(const std::string &ip,
-                                         sockaddr_in &addr) {
-    addrinfo *_addrinfo;
-    bool good   = false;
-    int errcode = ::getaddrinfo(ip.c_str(), nullptr, nullptr, &_addrinfo);
-    if (errcode != 0) {
-        logger(EWarn, "connection to tev failed: %s", getErrorString());
-        return good;
-    } else {
-        for (auto it = _addrinfo; it; it = it->ai_next) {
-            if (it->ai_family == AF_INET) {
-                addr = *(sockaddr_in *) it->ai_addr;
-                good = true;
-                break;
-            }
-        }
-    }
-
-    freeaddrinfo(_addrinfo);
-    return good;
-}
-
-static inline void closeSocket(socket_t socket) { ::closesocket(socket); }
-
-static bool setBlocking(socket_t socket, bool is_blocking) {
-    u_long state = is_blocking ? 0 : 1;
-    int error    = ioctlsocket(socket, FIONBIO, &state);
-    return !isSocketError(error);
-}
-
-static inline bool initNetwork() {
-    WORD version;
-    WSADATA wsa;
-
-    version   = MAKEWORD(2, 2);
-    int error = WSAStartup(version, &wsa);
-
-    if (error) {
-        logger(EWarn, "could not init WinSock2: %s", getErrorString());
-        return false;
-    }
-
-    if (LOBYTE(wsa.wVersion) != 2 || HIBYTE(wsa.wVersion) != 2) {
-        logger(EWarn, "could not find a usable version of Winsock.dll");
-        WSACleanup();
-        return false;
-    }
-
-    return true;
-}
-
-static inline void closeNetwork() { WSACleanup(); }
-
-#else // Linux & macOS
-
-using socket_t               = int;
-constexpr int INVALID_SOCKET = -1;
-constexpr int SOCKET_ERROR   = -1;
-
-static inline const char *getErrorString() { return ::strerror(errno); }
+template <typename T, size_t Capacity> class BoundedQueue {
+    static_assert(std::has_single_bit(Capacity), "the capacity must be a power of two");
 
-static inline void printError() {
-    logger(EWarn, "connection to tev failed: %s", getErrorString());
-}
-
-static inline bool isSocketError(ssize_t error) {
-    if (error == SOCKET_ERROR) {
-        printError();
-        return true;
-    }
-
-    return false;
-}
-
-static inline bool getAddressFromString4(const std::string &ip,
-                                         sockaddr_in &addr) {
-    addrinfo *_addrinfo;
-    bool good   = false;
-    int errcode = ::getaddrinfo(ip.c_str(), nullptr, nullptr, &_addrinfo);
-    if (errcode != 0) {
-        logger(EWarn, "connection to tev failed: ", gai_strerror(errcode));
-        return good;
-    } else {
-        for (auto it = _addrinfo; it; it = it->ai_next) {
-            if (it->ai_family == AF_INET) {
-                addr = *(sockaddr_in *) it->ai_addr;
-                good = true;
-                break;
-            }
-        }
-    }
-
-    freeaddrinfo(_addrinfo);
-    return good;
-}
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
 
-static inline void closeSocket(socket_t socket) { ::close(socket); }
-#endif
+    std::array<Cell, Capacity> m_cells;
+    // producers and consumers work on separate cache lines
+    alignas(64) std::atomic<size_t> m_enqueuePosition = 0;
+    alignas(64) std::atomic<size_t> m_dequeuePosition = 0;
 
-class SocketInternal {
 public:
-    socket_t Socket = INVALID_SOCKET;
-    std::string IP  = "127.0.0.1";
-    uint16_t Port   = 0;
-
-    bool IsClientConnection = false;
-    bool IsOpen             = false;
-    bool IsIp6              = false;
-
-    SocketInternal() {
-        static std::atomic_flag s_initialized = ATOMIC_FLAG_INIT;
-        if (!s_initialized.test_and_set()) {
-#ifdef USE_WIN32
-            initNetwork(); // We should close the network support but why
-                           // bother?
-#else
-            signal(SIGPIPE, SIG_IGN);
-#endif
-        }
+    BoundedQueue() {
+        for (size_t i = 0; i < Capacity; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
     }
 
-    ~SocketInternal() {
-        if (Socket != INVALID_SOCKET)
-            closeSocket(Socket);
-    }
-
-    // IPv4
-    inline bool connect(uint16_t port, const std::string &ip) {
-        assert(Socket == INVALID_SOCKET);
-
-        Socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        if (Socket == INVALID_SOCKET) {
-            logger(EWarn, "connection to tev failed: %s", getErrorString());
-            return false;
-        }
-
-        sockaddr_in addr;
-        memset(&addr, 0, sizeof(addr));
-
-        if (!getAddressFromString4(ip, addr)) {
-            logger(EWarn, "cannot convert IP address: %s", getErrorString());
-            return false;
-        }
-        addr.sin_family = AF_INET;
-        addr.sin_port   = htons(port);
-
-#ifdef LW_OS_WINDOWS
-        // Set socket non-blocking
-        if (!setBlocking(Socket, false))
-            return false;
-
-        int error = ::connect(Socket, (sockaddr *) &addr, sizeof(addr));
-
-        if (error == SOCKET_ERROR) {
-            // Handly async
-            if (WSAGetLastError() != WSAEWOULDBLOCK) {
-                // Some weird error happened, give up
-                printError();
-                return false;
-            }
-
-            // connection pending
-            fd_set setW, setE;
-            FD_ZERO(&setW);
-            FD_SET(Socket, &setW);
-            FD_ZERO(&setE);
-            FD_SET(Socket, &setE);
-
-            TIMEVAL time_out = { 0, 0 };
-            time_out.tv_sec  = 0;
-            time_out.tv_usec = 1000; // 1 ms
-
-            error = select(0, NULL, &setW, &setE, &time_out);
-            if (isSocketError(error))
-                return false;
-
-            if (error == 0) {
-                logger(EWarn, "connection to tev failed: timeout");
+    /// @brief Adds a value to the queue, or returns false if the queue is full.
+    bool tryPush(const T &value) {
+        size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = m_cells[position & (Capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = intptr_t(sequence) - intptr_t(position);
+            if (difference == 0) {
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // the cell still holds a value from the previous round
                 return false;
+            } else {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
             }
+        }
+    }
 
-            if (FD_ISSET(Socket, &setE)) {
-                // connection failed
-                int err = 0;
-                int len = sizeof(err);
-                getsockopt(Socket, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
-                WSASetLastError(err);
-                printError();
+    /// @brief Removes the oldest value from the queue, or returns false if the queue is empty.
+    bool tryPop(T &value) {
+        size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = m_cells[position & (Capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = intptr_t(sequence) - intptr_t(position + 1);
+            if (difference == 0) {
+                if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.sequence.store(position + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
                 return false;
+            } else {
+                position = m_dequeuePosition.load(std::memory_order_relaxed);
             }
         }
-        
-        // Set socket back to be blocking
-        if (!setBlocking(Socket, true))
-            return false;
-#else
-        int error = ::connect(Socket, (sockaddr *) &addr, sizeof(addr));
-
-        if (isSocketError(error))
-            return false;
-#endif
-
-        IP   = ip;
-        Port = port;
-        return true;
     }
 };
 
-struct Streaming::UpdateThread {
-    std::mutex mutex;
-    std::thread thread;
-    std::condition_variable cond;
-    int interval = 500;
-    bool stop    = false;
-
-    UpdateThread(Streaming &streaming);
-    ~UpdateThread();
-};
-
 class Streaming::Stream {
 public:
+    /// @brief Ends the current message and sends all pending messages.
     struct flush {};
+    /// @brief Ends the current message without sending it, so that several messages can be sent at once.
+    struct end {};
 
     template <typename T> struct binary {
         const T *data;
@@ -476,12 +97,17 @@ public:
 
     Stream();
 
+    /// @brief Whether a connection to tev has been established (and not been lost since).
+    bool isConnected() const;
+    /// @brief The number of bytes of pending messages.
+    size_t size() const { return size_t(m_index); }
+
     template <typename T> Stream &operator<<(const T &el) {
         if (m_buffer.size() < m_index + sizeof(T)) {
             m_buffer.resize(m_index + sizeof(T));
         }
 
-        *(T *) &m_buffer[m_index] = el;
+        memcpy(&m_buffer[m_index], &el, sizeof(T));
         m_index += sizeof(T);
 
         return *this;
@@ -511,6 +137,7 @@ public:
 
     Stream &operator<<(const std::string &el);
     Stream &operator<<(flush);
+    Stream &operator<<(end);
 
 private:
 #ifndef LW_OS_WINDOWS
@@ -519,29 +146,41 @@ private:
     using stream_size_t = int;
 #endif
 
+    void endMessage();
     void performFlush();
     void reset();
 
     std::vector<uint8_t> m_buffer;
+    /// @brief Where the size of the current message is stored.
+    stream_size_t m_start = 0;
     stream_size_t m_index = 0;
 };
 
 static std::unique_ptr<class SocketInternal> s_socket;
+/// @brief Guards the connection, since several streams might send at the same time.
+static std::mutex s_socketMutex;
+
 Streaming::Stream::Stream() {
     reset();
 
+    std::lock_guard lock{ s_socketMutex };
     if (s_socket) {
         // reuse existing socket
         return;
     }
 
     s_socket = std::make_unique<SocketInternal>();
-    if (!s_socket->connect(14158, "127.0.0.1")) {
+    if (!s_socket->connect(Port, "127.0.0.1")) {
         // connection failed
         s_socket.reset();
     }
 }
 
+bool Streaming::Stream::isConnected() const {
+    std::lock_guard lock{ s_socketMutex };
+    return bool(s_socket);
+}
+
 Streaming::Stream &Streaming::Stream::operator<<(const std::string &el) {
     const char *data = el.c_str();
     const size_t len = strlen(data) + 1;
@@ -551,50 +190,167 @@ Streaming::Stream &Streaming::Stream::operator<<(const std::string &el) {
 }
 
 Streaming::Stream &Streaming::Stream::operator<<(flush) {
+    endMessage();
     performFlush();
     return *this;
 }
 
+Streaming::Stream &Streaming::Stream::operator<<(end) {
+    endMessage();
+    return *this;
+}
+
+void Streaming::Stream::endMessage() {
+    if (m_index == m_start + 4) {
+        // the current message is empty
+        return;
+    }
+
+    const auto size = uint32_t(m_index - m_start);
+    memcpy(&m_buffer[m_start], &size, sizeof(size));
+    // reserve room for the size of the next message
+    m_start = m_index;
+    m_index += 4;
+    m_buffer.resize(m_index);
+}
+
 void Streaming::Stream::performFlush() {
-#ifdef USE_WIN32
-#define SEND_FLAGS 0
-#else
-#define SEND_FLAGS MSG_NOSIGNAL
-#endif
+    if (m_start == 0) {
+        // there are no messages to send
+        return;
+    }
 
-    *(uint32_t *) &m_buffer[0] = (uint32_t) m_index; // write size
-    stream_size_t total        = 0;
-    while (total < m_index && s_socket) {
-        stream_size_t ret =
-            ::send(s_socket->Socket, (const char *) m_buffer.data() + total,
-                   (int) (m_index - total), SEND_FLAGS);
-        if (isSocketError(ret)) {
-            logger(EWarn, "connection to tev lost");
-
-            // we were connected, now we aint
-            s_socket.reset();
-        } else if (ret == 0) {
-            // give other side time to catch up
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
-        }
-        total += ret;
+    std::lock_guard lock{ s_socketMutex };
+    // the reserved size of the next message is not sent
+    if (s_socket && !s_socket->sendAll((const char *) m_buffer.data(), size_t(m_start))) {
+        logger(EWarn, "connection to tev lost");
+
+        // we were connected, now we aint
+        s_socket.reset();
     }
 
     reset();
 }
 
 void Streaming::Stream::reset() {
-    m_buffer.clear();
+    m_buffer.resize(4);
+    m_start = 0;
     m_index = 4;
 }
 
+/// @brief The thread that sends dirty blocks to tev, so that render threads never wait for the connection.
+class Streaming::Sender {
+    /// @brief How long dirty blocks are collected before they are sent, which allows merging repeated updates.
+    static constexpr auto BatchInterval = std::chrono::milliseconds(20);
+    /// @brief The interval of regular updates, see @ref Streaming::startRegularUpdates .
+    static constexpr auto RegularInterval = std::chrono::milliseconds(500);
+    /// @brief Pending messages are sent once they exceed this size, to keep the send buffer small.
+    static constexpr size_t MaxBatchBytes = 4 << 20;
+
+    Streaming &m_streaming;
+    Stream &m_stream;
+
+    BoundedQueue<Bounds2i, 1024> m_queue;
+    /// @brief Whether the entire image needs to be sent (e.g., because the queue overflowed).
+    std::atomic<bool> m_updateAll = false;
+    std::atomic<bool> m_regularUpdates = false;
+
+    std::atomic<uint64_t> m_dropped = 0;
+    std::atomic<uint64_t> m_sent = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    /// @brief Sends all dirty blocks, returns once they have been handed to the connection.
+    void sendPending() {
+        std::vector<Bounds2i> blocks;
+        Bounds2i block;
+        while (m_queue.tryPop(block)) {
+            // blocks that were updated several times are only sent once, with their latest content
+            const bool isDuplicate = std::any_of(blocks.begin(), blocks.end(), [&](const Bounds2i &other) {
+                return other.min() == block.min() && other.max() == block.max();
+            });
+            if (!isDuplicate)
+                blocks.push_back(block);
+        }
+
+        if (m_updateAll.exchange(false)) {
+            // large packets are not supported by tev, so the image is split into smaller blocks
+            blocks.clear();
+            for (auto part : BlockSpiral{ Vector2i(m_streaming.m_image.resolution()), Vector2i(128) })
+                blocks.push_back(part);
+        }
+
+        for (const auto &dirty : blocks) {
+            m_streaming.writeBlock(m_stream, dirty);
+            if (m_stream.size() >= MaxBatchBytes)
+                m_stream << Stream::flush();
+        }
+        m_stream << Stream::flush();
+        m_sent += blocks.size();
+    }
+
+    void run() {
+        auto lastRegularUpdate = std::chrono::steady_clock::now();
+        while (true) {
+            bool stop;
+            {
+                std::unique_lock lock{ m_mutex };
+                m_wakeup.wait_for(lock, BatchInterval, [&]() { return m_stop; });
+                stop = m_stop;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (m_regularUpdates && now - lastRegularUpdate >= RegularInterval) {
+                m_updateAll = true;
+                lastRegularUpdate = now;
+            }
+
+            sendPending();
+            if (stop || !m_stream.isConnected())
+                break;
+        }
+    }
+
+public:
+    Sender(Streaming &streaming, Stream &stream)
+    : m_streaming(streaming), m_stream(stream) {
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    ~Sender() {
+        {
+            std::lock_guard lock{ m_mutex };
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_thread.join();
+    }
+
+    void push(const Bounds2i &block) {
+        if (!m_queue.tryPush(block)) {
+            // the viewer cannot keep up, so individual updates are replaced by a single update of the entire image
+            m_updateAll = true;
+            m_dropped++;
+        }
+    }
+
+    void pushAll() { m_updateAll = true; }
+    void setRegularUpdates(bool enabled) { m_regularUpdates = enabled; }
+
+    uint64_t dropped() const { return m_dropped; }
+    uint64_t sent() const { return m_sent; }
+};
+
 Streaming::Streaming(const Image &image) : m_image(image) {
     m_stream = std::make_unique<Stream>();
     *m_stream
         // close existing image
         << char(2)      // type
         << m_image.id() // filename
-        << Stream::flush()
+        << Stream::end()
 
         // create image
         << char(4)      // type
@@ -602,63 +358,64 @@ Streaming::Streaming(const Image &image) : m_image(image) {
         << m_image.id() // filename
         << m_image.resolution() << int32_t(m_channels.size()) << m_channels
         << Stream::flush();
-}
 
-void Streaming::updateBlock(const Bounds2i &block) {
-    std::unique_lock lock{ m_mutex };
-
-    std::vector<float> data;
-    for (int channel = 0; channel < Color::NumComponents; channel++) {
-        data.clear();
-        data.reserve(block.diagonal().product());
-        for (auto pixel : block)
-            data.push_back(m_image(pixel)[channel] * m_normalization);
-
-        *m_stream
-            // update channel
-            << char(3) << bool(false) << m_image.id() << m_channels[channel]
-            << block.min() << block.diagonal()
-            << Stream::binary(data.data(), data.size()) << Stream::flush();
+    // once started, the stream is only used by the sender thread
+    if (m_stream->isConnected()) {
+        m_sender = std::make_unique<Sender>(*this, *m_stream);
     }
 }
 
-void Streaming::update() {
-    // we need to split up the image into smaller packets, since large ones
-    // are not supported
-    BlockSpiral queue{ Vector2i(m_image.resolution()), Vector2i(128) };
-    for (auto block : queue) {
-        updateBlock(block);
+void Streaming::writeBlock(Stream &stream, const Bounds2i &block) const {
+    const float normalization = m_normalization;
+    const size_t pixelCount = block.diagonal().product();
+
+    // all channels of the block are sent in one packet, one channel after another
+    std::vector<float> data(m_channels.size() * pixelCount);
+    size_t index = 0;
+    for (auto pixel : block) {
+        const Color &color = m_image(pixel);
+        for (size_t channel = 0; channel < m_channels.size(); channel++)
+            data[channel * pixelCount + index] = color[channel] * normalization;
+        index++;
     }
+
+    stream
+        // update image (v2), which covers several channels
+        << char(5) << bool(false) << m_image.id() << int32_t(m_channels.size()) << m_channels
+        << block.min() << block.diagonal()
+        << Stream::binary(data.data(), data.size()) << Stream::end();
 }
 
-Streaming::UpdateThread::UpdateThread(Streaming &streaming) {
-    thread = std::thread([&]() {
-        const auto duration = std::chrono::milliseconds(interval);
-        while (!stop) {
-            {
-                std::unique_lock lock(mutex);
-                cond.wait_for(lock, duration, [&]() { return stop; });
-            }
-            streaming.update();
-        }
-    });
+void Streaming::updateBlock(const Bounds2i &block) {
+    if (m_sender) {
+        m_sender->push(block);
+    }
 }
 
-Streaming::UpdateThread::~UpdateThread() {
-    {
-        std::lock_guard lock(mutex);
-        stop = true;
+void Streaming::update() {
+    if (m_sender) {
+        m_sender->pushAll();
     }
-    cond.notify_one();
-    thread.join();
 }
 
 void Streaming::startRegularUpdates() {
-    m_updater = std::make_unique<UpdateThread>(*this);
+    if (m_sender) {
+        m_sender->setRegularUpdates(true);
+    }
 }
 
-void Streaming::stopRegularUpdates() { m_updater = nullptr; }
+void Streaming::stopRegularUpdates() {
+    if (m_sender) {
+        m_sender->setRegularUpdates(false);
+    }
+}
 
-Streaming::~Streaming() { stopRegularUpdates(); }
+uint64_t Streaming::droppedUpdates() const { return m_sender ? m_sender->dropped() : 0; }
+uint64_t Streaming::sentUpdates() const { return m_sender ? m_sender->sent() : 0; }
+
+Streaming::~Streaming() {
+    // the sender sends all pending updates before it stops
+    m_sender = nullptr;
+}
 
 } // namespace lightwave
@@ -0,0 +1,171 @@
+#include <lightwave/telemetry.hpp>
+#include <lightwave/logger.hpp>
+#include <lightwave/parallel.hpp>
+
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lightwave {
+
+namespace {
+
+std::mutex s_mutex;
+/// @brief The counters of all threads that have ever counted something (owned by this list).
+std::vector<std::unique_ptr<std::array<std::atomic<uint64_t>, Telemetry::ECounterCount>>> s_counters;
+/// @brief Counters whose threads have exited, which are handed to new threads.
+std::vector<std::array<std::atomic<uint64_t>, Telemetry::ECounterCount> *> s_freeCounters;
+/// @brief The time spent in each phase, in nanoseconds.
+std::array<std::atomic<uint64_t>, Telemetry::EPhaseCount> s_phaseTimes;
+
+/// @brief Returns the counters of a thread to the list of free counters once the thread exits.
+struct CounterRelease {
+    std::array<std::atomic<uint64_t>, Telemetry::ECounterCount> *counters = nullptr;
+
+    ~CounterRelease() {
+        std::unique_lock lock{ s_mutex };
+        s_freeCounters.push_back(counters);
+    }
+};
+
+const char *counterName(Telemetry::Counter counter) {
+    switch (counter) {
+    case Telemetry::EPrimaryRays: return "primaryRays";
+    case Telemetry::EClosestHitRays: return "closestHitRays";
+    case Telemetry::EShadowRays: return "shadowRays";
+    case Telemetry::EBvhNodes: return "bvhNodesVisited";
+    case Telemetry::EPrimitives: return "primitivesTested";
+    case Telemetry::EAlphaLookups: return "alphaMaskLookups";
+    case Telemetry::ETextureFetches: return "textureFetches";
+    default: return "unknown";
+    }
+}
+
+const char *phaseName(Telemetry::Phase phase) {
+    switch (phase) {
+    case Telemetry::EParse: return "parse";
+    case Telemetry::EPlyLoad: return "plyLoad";
+    case Telemetry::EImageLoad: return "imageLoad";
+    case Telemetry::EBvhBuild: return "bvhBuild";
+    case Telemetry::ERender: return "render";
+    case Telemetry::ESave: return "save";
+    default: return "unknown";
+    }
+}
+
+/// @brief Quotes a string for use in JSON.
+std::string jsonString(const std::string &value) {
+    std::string result = "\"";
+    for (const char chr : value) {
+        if (chr == '"' || chr == '\\') {
+            result += '\\';
+            result += chr;
+        } else if ((unsigned char) chr < 0x20) {
+            result += tfm::format("\\u%04x", int(chr));
+        } else {
+            result += chr;
+        }
+    }
+    return result + "\"";
+}
+
+} // namespace
+
+Telemetry::Counters *Telemetry::acquireCounters() {
+    static thread_local CounterRelease release;
+
+    std::unique_lock lock{ s_mutex };
+    if (s_freeCounters.empty()) {
+        s_counters.push_back(std::make_unique<Counters>());
+        release.counters = s_counters.back().get();
+    } else {
+        release.counters = s_freeCounters.back();
+        s_freeCounters.pop_back();
+    }
+    return release.counters;
+}
+
+void Telemetry::addTime(Phase phase, double seconds) {
+    s_phaseTimes[phase].fetch_add(uint64_t(seconds * 1e9), std::memory_order_relaxed);
+}
+
+uint64_t Telemetry::total(Counter counter) {
+    std::unique_lock lock{ s_mutex };
+    uint64_t sum = 0;
+    for (const auto &counters : s_counters)
+        sum += (*counters)[counter].load(std::memory_order_relaxed);
+    return sum;
+}
+
+double Telemetry::time(Phase phase) {
+    return s_phaseTimes[phase].load(std::memory_order_relaxed) * 1e-9;
+}
+
+void Telemetry::reset() {
+    std::unique_lock lock{ s_mutex };
+    for (auto &counters : s_counters) {
+        for (auto &value : *counters)
+            value = 0;
+    }
+    for (auto &time : s_phaseTimes)
+        time = 0;
+}
+
+void Telemetry::writeJSON(const std::filesystem::path &path, const std::filesystem::path &scenePath) {
+    std::array<uint64_t, ECounterCount> totals;
+    for (int counter = 0; counter < ECounterCount; counter++)
+        totals[counter] = total(Counter(counter));
+
+    // camera rays are also closest hit rays, all remaining closest hit rays continue paths
+    const uint64_t bounceRays = totals[EClosestHitRays] - std::min(totals[EPrimaryRays], totals[EClosestHitRays]);
+    const uint64_t rays = totals[EClosestHitRays] + totals[EShadowRays];
+    const double renderTime = time(ERender);
+
+    std::ofstream file{ path };
+    if (!file) {
+        logger(EError, "could not write telemetry to %s", path);
+        return;
+    }
+
+    file << "{\n";
+    file << "  \"scene\": " << jsonString(scenePath.generic_string()) << ",\n";
+    file << "  \"build\": {\n";
+#ifdef LW_DEBUG
+    file << "    \"debug\": true,\n";
+#else
+    file << "    \"debug\": false,\n";
+#endif
+#if defined(LW_CC_CLANG)
+    file << "    \"compiler\": " << jsonString("clang " __clang_version__) << ",\n";
+#elif defined(LW_CC_GNU)
+    file << "    \"compiler\": " << jsonString("gcc " __VERSION__) << ",\n";
+#elif defined(LW_CC_MSC)
+    file << "    \"compiler\": \"msvc " LW_STRINGIFY(_MSC_VER) "\",\n";
+#else
+    file << "    \"compiler\": \"unknown\",\n";
+#endif
+    file << "    \"threads\": " << threadCount() << "\n";
+    file << "  },\n";
+
+    file << "  \"phases\": {\n";
+    for (int phase = 0; phase < EPhaseCount; phase++) {
+        file << tfm::format("    \"%s\": %.6f%s\n", phaseName(Phase(phase)), time(Phase(phase)),
+                            phase + 1 < EPhaseCount ? "," : "");
+    }
+    file << "  },\n";
+
+    file << "  \"counters\": {\n";
+    for (int counter = 0; counter < ECounterCount; counter++)
+        file << tfm::format("    \"%s\": %d,\n", counterName(Counter(counter)), totals[counter]);
+    file << tfm::format("    \"bounceRays\": %d\n", bounceRays);
+    file << "  },\n";
+
+    file << tfm::format("  \"rays\": %d,\n", rays);
+    file << tfm::format("  \"mraysPerSecond\": %.6f\n", renderTime > 0 ? rays / renderTime * 1e-6 : 0.0);
+    file << "}\n";
+
+    logger(EInfo, "wrote telemetry to %s (%.2f Mrays/s)", path, renderTime > 0 ? rays / renderTime * 1e-6 : 0.0);
+}
+
+} // namespace lightwave
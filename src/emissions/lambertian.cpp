@@ -17,7 +17,7 @@ public:
      * Evaluates the emission at the given texture coordinate uv.
      * If the ray hits the backside of the object, the emission equals zero.
      */
-    EmissionEval evaluate(const Point2& uv, const Vector& wo) const override {
+    EmissionEval evaluate(const TexCoord& uv, const Vector& wo) const override {
         if (wo.z() <= 0.0f) {
             return {Color::black()};
         }
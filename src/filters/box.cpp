@@ -0,0 +1,25 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Weights all samples within its radius equally. With the default radius of half a pixel, this averages the
+ * samples taken within each pixel, which is also what films do when no filter is given.
+ */
+class BoxFilter : public Filter {
+public:
+    BoxFilter(const Properties &properties)
+    : Filter(properties, 0.5f) {}
+
+    float evaluate(float distance) const override {
+        return 1;
+    }
+
+    std::string toString() const override {
+        return tfm::format("BoxFilter[ radius = %f ]", m_radius);
+    }
+};
+
+}
+
+REGISTER_FILTER(BoxFilter, "box")
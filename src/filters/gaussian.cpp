@@ -0,0 +1,45 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Weights samples with a Gaussian of their distance to the pixel center.
+ * The Gaussian is shifted down by its value at the radius, so that it smoothly falls off to zero instead of being
+ * cut off abruptly.
+ */
+class GaussianFilter : public Filter {
+    /// @brief The standard deviation of the Gaussian in pixels.
+    float m_stddev;
+    /// @brief The value of the Gaussian at the radius, which is subtracted from all weights.
+    float m_offset;
+
+    float gaussian(float distance) const {
+        return std::exp(-sqr(distance) / (2 * sqr(m_stddev)));
+    }
+
+public:
+    GaussianFilter(const Properties &properties)
+    : Filter(properties, 1.5f) {
+        m_stddev = properties.get<float>("stddev", 0.5f);
+        m_offset = gaussian(m_radius);
+    }
+
+    float evaluate(float distance) const override {
+        return std::max(gaussian(distance) - m_offset, 0.0f);
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "GaussianFilter[\n"
+            "  radius = %f,\n"
+            "  stddev = %f\n"
+            "]",
+            m_radius,
+            m_stddev
+        );
+    }
+};
+
+}
+
+REGISTER_FILTER(GaussianFilter, "gaussian")
@@ -0,0 +1,48 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief The piecewise cubic filter by Mitchell and Netravali, which trades off blurring (controlled by @c B ) and
+ * ringing (controlled by @c C ). Its negative lobes sharpen the image, the default of B = C = 1/3 is the compromise
+ * recommended by the authors.
+ */
+class MitchellFilter : public Filter {
+    float m_b;
+    float m_c;
+
+public:
+    MitchellFilter(const Properties &properties)
+    : Filter(properties, 2.0f) {
+        m_b = properties.get<float>("B", 1.0f / 3);
+        m_c = properties.get<float>("C", 1.0f / 3);
+    }
+
+    float evaluate(float distance) const override {
+        // the cubic is defined over [-2, +2], which is stretched to cover the radius
+        const float x = std::abs(2 * distance / m_radius);
+        if (x >= 2)
+            return 0;
+        if (x >= 1)
+            return ((-m_b - 6 * m_c) * x * x * x + (6 * m_b + 30 * m_c) * x * x + (-12 * m_b - 48 * m_c) * x +
+                    (8 * m_b + 24 * m_c)) / 6;
+        return ((12 - 9 * m_b - 6 * m_c) * x * x * x + (-18 + 12 * m_b + 6 * m_c) * x * x + (6 - 2 * m_b)) / 6;
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "MitchellFilter[\n"
+            "  radius = %f,\n"
+            "  B = %f,\n"
+            "  C = %f\n"
+            "]",
+            m_radius,
+            m_b,
+            m_c
+        );
+    }
+};
+
+}
+
+REGISTER_FILTER(MitchellFilter, "mitchell")
@@ -0,0 +1,22 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/// @brief Weights samples linearly falling off with their distance to the pixel center (also known as triangle filter).
+class TentFilter : public Filter {
+public:
+    TentFilter(const Properties &properties)
+    : Filter(properties, 1.0f) {}
+
+    float evaluate(float distance) const override {
+        return std::max(1 - std::abs(distance) / m_radius, 0.0f);
+    }
+
+    std::string toString() const override {
+        return tfm::format("TentFilter[ radius = %f ]", m_radius);
+    }
+};
+
+}
+
+REGISTER_FILTER(TentFilter, "tent")
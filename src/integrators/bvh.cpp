@@ -11,8 +11,9 @@ public:
         m_scale = 1.0f / properties.get<float>("unit", 1.0f);
     }
 
-    Color Li(const Ray& ray, Sampler& rng) override {
+    Color Li(const RayDifferential& ray, Sampler& rng) override {
         const Intersection its = m_scene->intersect(ray, rng);
+        recordPrimaryHit(its);
         return {its.stats.bvhCounter * m_scale,
                 its.stats.primCounter * m_scale,
                 0.0f};
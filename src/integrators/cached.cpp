@@ -0,0 +1,295 @@
+#include <lightwave.hpp>
+
+#include "radiancecache.hpp"
+
+#include <array>
+
+namespace lightwave {
+
+/**
+ * A path tracer that terminates paths into a radiance cache (see radiancecache.hpp) once they have taken a rough bounce
+ * and hit another rough surface, which replaces the remaining (smooth, but expensive) diffuse interreflection by a
+ * lookup.
+ * The cache is filled in a prepass, whose paths record the radiance they found at every vertex that could have used the
+ * cache. Optionally, the final render keeps recording (progressive mode), such that records that were rarely visited
+ * during the prepass improve over time.
+ * The cache trades bias for speed: Regions blur the radiance of all surfaces within a cell of size @c cellSize , and
+ * only records with at least @c minSamples estimates are used. A bounce counts as rough if its sampled direction has
+ * a density of at most @c maxPdf (a diffuse bounce has at most 1/Pi).
+ */
+class CachedPathTracerIntegrator : public SamplingIntegrator {
+protected:
+    int m_maxDepth;
+    /// The number of samples per pixel used to fill the cache before rendering.
+    int m_prepassSamples;
+    /// Whether the final render also records radiance into the cache.
+    bool m_progressive;
+    /// The number of estimates a record needs before paths terminate into it.
+    int m_minSamples;
+    /// The largest density of a sampled direction for which the bounce is considered rough.
+    float m_maxPdf;
+    std::unique_ptr<RadianceCache> m_cache;
+    /// Whether paths currently record their radiance into the cache.
+    bool m_recording;
+    /// Whether paths currently terminate into the cache, which is only the case once the prepass has completed.
+    bool m_useCache;
+
+    /// Only the first vertices of a path record their radiance, which avoids allocations for each path.
+    static constexpr int MaxRecordedVertices = 32;
+
+    /// A vertex whose outgoing radiance is recorded into the cache once the path has been completed.
+    struct RecordedVertex {
+        int depth;
+        Point position;
+        Vector normal;
+        /// The throughput of the path from this vertex on.
+        Color weight;
+        /// The radiance the path has found after this vertex, as seen from this vertex.
+        Color radiance;
+    };
+
+    /// Returns whether a sampled direction has a low enough density to count as a rough bounce.
+    bool isRough(float pdf) const {
+        return pdf <= m_maxPdf;
+    }
+
+public:
+    explicit CachedPathTracerIntegrator(const Properties& properties) : SamplingIntegrator(properties) {
+        m_maxDepth = properties.get<int>("depth", 2);
+        m_prepassSamples = properties.get<int>("prepassSamples", 4);
+        m_progressive = properties.get<bool>("progressive", false);
+        m_minSamples = properties.get<int>("minSamples", 4);
+        m_maxPdf = properties.get<float>("maxPdf", 1.0f);
+        m_recording = false;
+        m_useCache = false;
+
+        // By default, cells span a 64th of the scene diagonal
+        const Bounds bounds = m_scene->getBoundingBox();
+        const float defaultCellSize = bounds.isUnbounded() || bounds.isEmpty() ? 0.01f : bounds.diagonal().length() / 64;
+        m_cache = std::make_unique<RadianceCache>(
+                properties.get<int>("capacity", 20),
+                properties.get<float>("cellSize", defaultCellSize),
+                properties.get<int>("normalResolution", 4)
+        );
+    }
+
+    void execute() override {
+        if (!m_image) {
+            lightwave_throw("<integrator /> needs an <image /> child to render into!");
+        }
+        initializeImages();
+
+        // The integrator can be executed repeatedly (e.g., by the render server), and every render has to fill the
+        // cache with its own samples
+        m_cache->clear();
+
+        if (m_prepassSamples > 0) {
+            logger(EInfo, "filling the radiance cache with %d samples per pixel", m_prepassSamples);
+            m_recording = true;
+            m_useCache = false;
+            render(m_prepassSamples);
+        }
+        // In progressive mode, paths that terminate into the cache also feed the cache, such that records gradually
+        // capture more bounces of light
+        m_recording = m_progressive;
+        m_useCache = true;
+
+        Streaming stream = {*m_image};
+        render(m_sampler->samplesPerPixel(), m_prepassSamples, &stream);
+        saveImages();
+    }
+
+    Color Li(const RayDifferential& ray, Sampler& rng) override {
+        Color result = Color::black();
+        RayDifferential currentRay = ray;
+        Color currentWeight = Color::white();
+        // The density of the Bsdf sample that produced the current ray (infinite for camera rays, which cannot be
+        // produced by next-event estimation).
+        float bsdfPdf = Infinity;
+        // Whether the previous bounce was rough, which allows terminating into the cache
+        bool previousRough = false;
+
+        std::array<RecordedVertex, MaxRecordedVertices> vertices;
+        int vertexCount = 0;
+        // Adds radiance arriving along the path, where the throughput of the path has not been applied yet. Recorded
+        // vertices track their own throughput, since dividing the result by the throughput of the path fails for
+        // color channels that the path up to the vertex has absorbed
+        const auto contribute = [&](const Color& radiance) {
+            result += radiance * currentWeight;
+            for (int i = 0; i < vertexCount; i++) {
+                vertices[i].radiance += radiance * vertices[i].weight;
+            }
+        };
+
+        for (int depth = 0; depth < m_maxDepth; depth++) {
+            Intersection its = m_scene->intersect(currentRay, rng);
+            if (depth == 0) {
+                recordPrimaryHit(its);
+            }
+            if (!its) {
+                // The background might also have been sampled by next-event estimation at the previous vertex
+                const float misWeight = misWeightBackground(currentRay.origin, currentRay.direction, bsdfPdf, 1);
+                contribute(m_scene->evaluateBackground(currentRay.direction).value * misWeight);
+                break;
+            }
+            its.computeDifferentials(currentRay);
+
+            if (its.instance->emission() != nullptr) {
+                // Emission of area lights might also have been sampled by next-event estimation at the previous vertex
+                const float misWeight = misWeightEmission(currentRay.origin, its, bsdfPdf, 1);
+                contribute(its.evaluateEmission() * misWeight);
+            }
+
+            // The Bsdf sample decides whether this vertex is rough, i.e., whether it can be represented by the cache
+            const BsdfSample bsdfSample = its.sampleBsdf(rng);
+            const bool rough = !bsdfSample.isInvalid() && isRough(bsdfSample.pdf);
+
+            if (previousRough && rough && m_useCache) {
+                const RadianceCache::Lookup cached = m_cache->lookup(its.position, its.frame.normal, depth);
+                if (cached.count >= m_minSamples) {
+                    contribute(cached.radiance);
+                    break;
+                }
+            }
+
+            // Don't evaluate NEE on last bounce
+            if (depth == m_maxDepth - 1) {
+                break;
+            }
+
+            // Only vertices that could have terminated into the cache are recorded, and the last vertex (which does not
+            // reflect any light) is not. Records are separated by depth, since paths that are already deeper can only
+            // find the radiance of fewer bounces
+            if (m_recording && previousRough && rough && vertexCount < MaxRecordedVertices) {
+                vertices[vertexCount++] = {
+                    .depth = depth,
+                    .position = its.position,
+                    .normal = its.frame.normal,
+                    .weight = Color::white(),
+                    .radiance = Color::black(),
+                };
+            }
+
+            // Next-event estimation (shadow ray towards a random sampleable light)
+            contribute(estimateDirectLight(its, rng, 1, false, [&](const Vector& wi) {
+                return its.pdfBsdf(wi);
+            }));
+
+            if (bsdfSample.isInvalid()) {
+                break;
+            }
+
+            // Preparation for next bounce
+            currentWeight *= bsdfSample.weight;
+            for (int i = 0; i < vertexCount; i++) {
+                vertices[i].weight *= bsdfSample.weight;
+            }
+            currentRay = its.spawnRay(currentRay, bsdfSample.wi, std::isinf(bsdfSample.pdf));
+            bsdfPdf = misBsdfPdf(its, bsdfSample.wi, bsdfSample.pdf);
+            previousRough = rough;
+        }
+
+        for (int i = 0; i < vertexCount; i++) {
+            m_cache->record(vertices[i].position, vertices[i].normal, vertices[i].depth, vertices[i].radiance);
+        }
+
+        return result;
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+                "CachedPathTracerIntegrator[\n"
+                "  depth = %d,\n"
+                "  prepassSamples = %d,\n"
+                "  progressive = %s,\n"
+                "  minSamples = %d,\n"
+                "  maxPdf = %f,\n"
+                "  sampler = %s,\n"
+                "  image = %s,\n"
+                "]",
+                m_maxDepth,
+                m_prepassSamples,
+                m_progressive ? "true" : "false",
+                m_minSamples,
+                m_maxPdf,
+                indent(m_sampler),
+                indent(m_image)
+        );
+    }
+};
+
+/**
+ * Visualizes the records of the radiance cache at the surfaces seen by the camera, after filling the cache in the
+ * same way as the cached path tracer. Depending on the mode, shows the cached radiance, a random color per record
+ * (which reveals the cell structure), or the number of estimates per record relative to @c minSamples .
+ * Surfaces without a usable record are shown in black.
+ */
+class RadianceCacheDebugIntegrator final : public CachedPathTracerIntegrator {
+    enum class Mode {
+        Radiance,
+        Records,
+        Samples,
+    };
+    Mode m_mode;
+    /// The path depth whose records are shown (camera rays hit surfaces at depth zero, which never use the cache).
+    int m_visualizedDepth;
+
+public:
+    explicit RadianceCacheDebugIntegrator(const Properties& properties) : CachedPathTracerIntegrator(properties) {
+        m_mode = properties.getEnum<Mode>("mode", Mode::Radiance, {
+            { "radiance", Mode::Radiance },
+            { "records", Mode::Records },
+            { "samples", Mode::Samples },
+        });
+        m_visualizedDepth = properties.get<int>("visualizedDepth", 1);
+    }
+
+    Color Li(const RayDifferential& ray, Sampler& rng) override {
+        if (!m_useCache) {
+            return CachedPathTracerIntegrator::Li(ray, rng);
+        }
+
+        const Intersection its = m_scene->intersect(ray, rng);
+        recordPrimaryHit(its);
+        if (!its) {
+            return Color::black();
+        }
+
+        const RadianceCache::Lookup cached = m_cache->lookup(its.position, its.frame.normal, m_visualizedDepth);
+        if (cached.count == 0 || (m_mode != Mode::Samples && cached.count < m_minSamples)) {
+            return Color::black();
+        }
+
+        switch (m_mode) {
+        case Mode::Radiance:
+            return cached.radiance;
+        case Mode::Records:
+            return Color(float(cached.key & 0xff), float((cached.key >> 8) & 0xff), float((cached.key >> 16) & 0xff)) / 255;
+        case Mode::Samples:
+            return Color(std::min(float(cached.count) / m_minSamples, 1.0f));
+        }
+        return Color::black();
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+                "RadianceCacheDebugIntegrator[\n"
+                "  visualizedDepth = %d,\n"
+                "  prepassSamples = %d,\n"
+                "  minSamples = %d,\n"
+                "  sampler = %s,\n"
+                "  image = %s,\n"
+                "]",
+                m_visualizedDepth,
+                m_prepassSamples,
+                m_minSamples,
+                indent(m_sampler),
+                indent(m_image)
+        );
+    }
+};
+
+} // namespace lightwave
+
+REGISTER_INTEGRATOR(CachedPathTracerIntegrator, "cached")
+REGISTER_INTEGRATOR(RadianceCacheDebugIntegrator, "cachevis")
@@ -42,7 +42,7 @@ public:
      * @brief The job of an integrator is to return a color for a ray produced by the camera model.
      * This will be run for each pixel of the image, potentially with multiple samples for each pixel.
      */
-    Color Li(const Ray &ray, Sampler &rng) override {
+    Color Li(const RayDifferential &ray, Sampler &rng) override {
         Vector d = ray.direction;
         if (m_showGrid) {
             // intersect the ray with a grid at z=+1
@@ -6,58 +6,85 @@ namespace lightwave {
  * We begin with black and add light, weighted by the material reflectance/BSDF.
  * If the scene contains lights, we also fire a shadow ray at the first intersection towards a randomly chosen light
  * in the scene. If the light isn't occuled, we collect it's lighting data at this point ("Next-Event Estimation").
- * This is only done for non-intersectable lights, since those with rigid bodies could instead be hit traditionally.
+ * This is only done for lights that can be sampled. Lights that can also be hit traditionally (e.g., an importance
+ * sampled environment map) are found by both strategies, which are then weighted using multiple importance sampling.
+ * Both strategies can take several samples per camera ray (@c neeSamples and @c bsdfSamples ), which amortizes the cost
+ * of the camera ray over more shadow and Bsdf rays.
  */
 class DirectIntegrator : public SamplingIntegrator {
+    /// The number of shadow rays traced towards lights per camera ray.
+    int m_neeSamples;
+    /// The number of Bsdf samples (and hence second rays) traced per camera ray.
+    int m_bsdfSamples;
+
 public:
-    explicit DirectIntegrator(const Properties& properties) : SamplingIntegrator(properties) {}
+    explicit DirectIntegrator(const Properties& properties) : SamplingIntegrator(properties) {
+        m_neeSamples = properties.get<int>("neeSamples", 1);
+        m_bsdfSamples = properties.get<int>("bsdfSamples", 1);
+    }
 
-    Color Li(const Ray& ray, Sampler& rng) override {
+    void execute() override {
+        // rays are counted by the telemetry of each thread, of which only the rays traced by this render are used
+        const uint64_t startCameraRays = Telemetry::total(Telemetry::EPrimaryRays);
+        const uint64_t startShadowRays = Telemetry::total(Telemetry::EShadowRays);
+        const uint64_t startClosestHitRays = Telemetry::total(Telemetry::EClosestHitRays);
+
+        SamplingIntegrator::execute();
+        const uint64_t cameraRays = Telemetry::total(Telemetry::EPrimaryRays) - startCameraRays;
+        const uint64_t shadowRays = Telemetry::total(Telemetry::EShadowRays) - startShadowRays;
+        // every closest hit ray that is not a camera ray is a Bsdf ray
+        const uint64_t closestHitRays = Telemetry::total(Telemetry::EClosestHitRays) - startClosestHitRays;
+        const uint64_t bsdfRays = closestHitRays - std::min(cameraRays, closestHitRays);
+        if (cameraRays > 0) {
+            logger(EInfo, "per camera ray: %.3f shadow rays, %.3f bsdf rays",
+                   double(shadowRays) / cameraRays, double(bsdfRays) / cameraRays);
+        }
+    }
+
+    Color Li(const RayDifferential& ray, Sampler& rng) override {
         Color result = Color::black();
 
         // First ray
-        const Intersection its1 = m_scene->intersect(ray, rng);
+        Intersection its1 = m_scene->intersect(ray, rng);
+        recordPrimaryHit(its1);
         if (!its1) {
             return m_scene->evaluateBackground(ray.direction).value;
         }
+        its1.computeDifferentials(ray);
 
         if (its1.instance->emission() != nullptr) {
             result += its1.evaluateEmission();
         }
 
-        const BsdfSample bsdfSample = its1.sampleBsdf(rng);
-        // Terminate on invalid sample
-        if (bsdfSample.isInvalid()) {
-            return result;
+        // Next-event estimation (shadow rays + lighting data collection), averaged over all light samples. The MIS
+        // weights account for the number of samples taken by each strategy
+        for (int lightSample = 0; m_scene->hasLights() && lightSample < m_neeSamples; lightSample++) {
+            result += estimateDirectLight(its1, rng, m_neeSamples, false, [&](const Vector& wi) {
+                return m_bsdfSamples * its1.pdfBsdf(wi);
+            }) / float(m_neeSamples);
         }
 
-        // Next-event estimation (shadow ray + lighting data collection)
-        if (m_scene->hasLights()) {
-            const LightSample sampledLight = m_scene->sampleLight(rng);
-            const DirectLightSample sampledLightPoint = sampledLight.light->sampleDirect(its1.position, rng);
-
-            if (!sampledLight.light->canBeIntersected() && !sampledLightPoint.isInvalid()) {
-                const Ray shadowRay = {its1.position, sampledLightPoint.wi};
-
-                if (!m_scene->intersect(shadowRay, sampledLightPoint.distance, rng)) {
-                    const BsdfEval bsdfEval = its1.evaluateBsdf(sampledLightPoint.wi);
-                    result += sampledLightPoint.weight * bsdfEval.value / sampledLight.probability;
-                }
+        // Sample the Bsdf only after next-event estimation, which must not be skipped when Bsdf sampling fails
+        for (int bsdfSampleIndex = 0; bsdfSampleIndex < m_bsdfSamples; bsdfSampleIndex++) {
+            const BsdfSample bsdfSample = its1.sampleBsdf(rng);
+            if (bsdfSample.isInvalid()) {
+                continue;
             }
-        }
-
-
-        // Second ray
-        const Ray ray2 = {its1.position, bsdfSample.wi};
 
-        const Intersection its2 = m_scene->intersect(ray2, rng);
-        if (!its2) {
-            const Color bgLight = m_scene->evaluateBackground(ray2.direction).value;
-            return result + bgLight * bsdfSample.weight;
-        }
-
-        if (its2.instance->emission() != nullptr) {
-            return result + its2.evaluateEmission() * bsdfSample.weight;
+            // Second ray
+            const Ray ray2 = {its1.position, bsdfSample.wi};
+            const float bsdfPdf = misBsdfPdf(its1, bsdfSample.wi, m_bsdfSamples * bsdfSample.pdf);
+
+            const Intersection its2 = m_scene->intersect(ray2, rng);
+            if (!its2) {
+                const Color bgLight = m_scene->evaluateBackground(ray2.direction).value;
+                const float misWeight = misWeightBackground(its1.position, ray2.direction, bsdfPdf, m_neeSamples);
+                result += bgLight * bsdfSample.weight * misWeight / float(m_bsdfSamples);
+            } else if (its2.instance->emission() != nullptr) {
+                // Emission of area lights might also have been sampled by next-event estimation
+                const float misWeight = misWeightEmission(its1.position, its2, bsdfPdf, m_neeSamples);
+                result += its2.evaluateEmission() * bsdfSample.weight * misWeight / float(m_bsdfSamples);
+            }
         }
 
         return result;
@@ -66,9 +93,13 @@ public:
     std::string toString() const override {
         return tfm::format(
                 "DirectIntegrator[\n"
+                "  neeSamples = %d,\n"
+                "  bsdfSamples = %d,\n"
                 "  sampler = %s,\n"
                 "  image = %s,\n"
                 "]",
+                m_neeSamples,
+                m_bsdfSamples,
                 indent(m_sampler),
                 indent(m_image)
         );
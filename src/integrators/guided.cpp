@@ -0,0 +1,219 @@
+#include <lightwave.hpp>
+
+#include "guiding.hpp"
+
+#include <array>
+
+namespace lightwave {
+
+/**
+ * A path tracer that learns the incident radiance of the scene during a number of training passes (see guiding.hpp),
+ * and uses it to sample directions at diffuse and glossy vertices.
+ * Every training pass uses twice as many samples per pixel as the previous one, and the distribution learned in a
+ * pass is used for sampling in the next pass (and in the final render, which uses the configured sampler).
+ * Directions are drawn from a one-sample mixture of the Bsdf and the guide, and are weighted with the density of the
+ * mixture. Since the Bsdf is always part of the mixture, no direction with non-zero contribution is missed, hence the
+ * result matches the regular path tracer in expectation.
+ */
+class GuidedPathTracerIntegrator : public SamplingIntegrator {
+private:
+    int m_maxDepth;
+    /// The number of training passes before the final render.
+    int m_trainingPasses;
+    /// The probability of sampling the Bsdf instead of the guide at vertices that have a trained guide.
+    float m_bsdfSamplingFraction;
+    GuidingField m_field;
+    /// Whether paths currently record their incident radiance into the guiding field.
+    bool m_training;
+
+    /// Only the first vertices of a path record their radiance, which avoids allocations for each path.
+    static constexpr int MaxRecordedVertices = 32;
+
+    /// A vertex whose incident radiance is recorded into the guiding field once the path has been completed.
+    struct RecordedVertex {
+        int cell;
+        Vector wi;
+        /// The density with which @c wi has been sampled.
+        float pdf;
+        /// The path throughput including the sampled direction.
+        Color weight;
+        /// The radiance the path had collected before continuing in direction @c wi .
+        Color resultBefore;
+    };
+
+    /// Returns the density of sampling @c wi at the given vertex, combining the Bsdf and the guide.
+    float samplingPdf(const Intersection& its, int cell, const Vector& wi) const {
+        const float bsdfPdf = its.pdfBsdf(wi);
+        if (!m_field.isTrained(cell)) {
+            return bsdfPdf;
+        }
+        return m_bsdfSamplingFraction * bsdfPdf + (1 - m_bsdfSamplingFraction) * m_field.pdf(cell, wi);
+    }
+
+public:
+    explicit GuidedPathTracerIntegrator(const Properties& properties)
+        : SamplingIntegrator(properties),
+          m_field(m_scene->getBoundingBox(),
+                  properties.get<int>("spatialResolution", 16),
+                  properties.get<int>("directionalResolution", 16)) {
+        m_maxDepth = properties.get<int>("depth", 2);
+        m_trainingPasses = properties.get<int>("trainingPasses", 5);
+        m_bsdfSamplingFraction = properties.get<float>("bsdfSamplingFraction", 0.5f);
+        m_training = false;
+    }
+
+    void execute() override {
+        if (!m_image) {
+            lightwave_throw("<integrator /> needs an <image /> child to render into!");
+        }
+        initializeImages();
+
+        // The integrator can be executed repeatedly (e.g., by the render server), and every render has to learn its
+        // guide from its own samples
+        m_field.clear();
+
+        // Each pass continues the sample indices of the previous passes, since the guide must not be correlated with
+        // the random numbers of the paths it is used for
+        m_training = true;
+        int sampleIndex = 0;
+        for (int pass = 0; pass < m_trainingPasses; pass++) {
+            logger(EInfo, "guiding training pass %d of %d", pass + 1, m_trainingPasses);
+            render(1 << pass, sampleIndex, nullptr);
+            sampleIndex += 1 << pass;
+            m_field.update();
+        }
+        m_training = false;
+
+        Streaming stream = {*m_image};
+        render(m_sampler->samplesPerPixel(), sampleIndex, &stream);
+        saveImages();
+    }
+
+    Color Li(const RayDifferential& ray, Sampler& rng) override {
+        Color result = Color::black();
+        RayDifferential currentRay = ray;
+        Color currentWeight = Color::white();
+        // The density of the direction that produced the current ray (infinite for camera rays, which cannot be
+        // produced by next-event estimation).
+        float bsdfPdf = Infinity;
+
+        std::array<RecordedVertex, MaxRecordedVertices> vertices;
+        int vertexCount = 0;
+
+        for (int depth = 0; depth < m_maxDepth; depth++) {
+            Intersection its = m_scene->intersect(currentRay, rng);
+            if (depth == 0) {
+                recordPrimaryHit(its);
+            }
+            if (!its) {
+                // The background might also have been sampled by next-event estimation at the previous vertex
+                const float misWeight = misWeightBackground(currentRay.origin, currentRay.direction, bsdfPdf, 1);
+                result += m_scene->evaluateBackground(currentRay.direction).value * currentWeight * misWeight;
+                break;
+            }
+            its.computeDifferentials(currentRay);
+
+            if (its.instance->emission() != nullptr) {
+                // Emission of area lights might also have been sampled by next-event estimation at the previous vertex
+                const float misWeight = misWeightEmission(currentRay.origin, its, bsdfPdf, 1);
+                result += its.evaluateEmission() * currentWeight * misWeight;
+            }
+
+            // Don't evaluate NEE on last bounce
+            if (depth == m_maxDepth - 1) {
+                break;
+            }
+
+            const int cell = m_field.cellIndex(its.position);
+
+            // Next-event estimation (shadow ray towards a random sampleable light), weighted against sampling the
+            // mixture of the Bsdf and the guide
+            result += estimateDirectLight(its, rng, 1, false, [&](const Vector& wi) {
+                return samplingPdf(its, cell, wi);
+            }) * currentWeight;
+
+            // Sample the Bsdf only after next-event estimation, which must not be skipped when Bsdf sampling fails
+            const float strategy = rng.next();
+            const BsdfSample bsdfSample = its.sampleBsdf(rng);
+            const Point2 guideBinSample = rng.next2D();
+            const Point2 guidePositionSample = rng.next2D();
+
+            Vector wi;
+            Color weight;
+            float pdf;
+            if (std::isinf(bsdfSample.pdf) || !m_field.isTrained(cell)) {
+                // Delta lobes cannot be guided, and neither can vertices for which nothing has been learned yet
+                if (bsdfSample.isInvalid()) {
+                    break;
+                }
+                wi = bsdfSample.wi;
+                weight = bsdfSample.weight;
+                pdf = bsdfSample.pdf;
+            } else {
+                if (strategy < m_bsdfSamplingFraction) {
+                    if (bsdfSample.isInvalid()) {
+                        break;
+                    }
+                    wi = bsdfSample.wi;
+                } else {
+                    wi = m_field.sample(cell, guideBinSample, guidePositionSample);
+                }
+
+                pdf = samplingPdf(its, cell, wi);
+                if (!(pdf > 0)) {
+                    break;
+                }
+                weight = its.evaluateBsdf(wi).value / pdf;
+            }
+
+            // Preparation for next bounce
+            currentWeight *= weight;
+            currentRay = its.spawnRay(currentRay, wi, std::isinf(pdf));
+            bsdfPdf = misBsdfPdf(its, wi, pdf);
+
+            if (m_training && !std::isinf(pdf) && vertexCount < MaxRecordedVertices) {
+                vertices[vertexCount++] = {
+                    .cell = cell,
+                    .wi = wi,
+                    .pdf = pdf,
+                    .weight = currentWeight,
+                    .resultBefore = result,
+                };
+            }
+        }
+
+        // The radiance incident at a vertex is everything the path collected afterwards, divided by the throughput
+        for (int i = 0; i < vertexCount; i++) {
+            const RecordedVertex& vertex = vertices[i];
+            const Color contribution = result - vertex.resultBefore;
+            Color incident;
+            for (int channel = 0; channel < Color::NumComponents; channel++) {
+                incident[channel] = vertex.weight[channel] > 0 ? contribution[channel] / vertex.weight[channel] : 0;
+            }
+            m_field.record(vertex.cell, vertex.wi, incident.luminance() / vertex.pdf);
+        }
+
+        return result;
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+                "GuidedPathTracerIntegrator[\n"
+                "  depth = %d,\n"
+                "  trainingPasses = %d,\n"
+                "  bsdfSamplingFraction = %f,\n"
+                "  sampler = %s,\n"
+                "  image = %s,\n"
+                "]",
+                m_maxDepth,
+                m_trainingPasses,
+                m_bsdfSamplingFraction,
+                indent(m_sampler),
+                indent(m_image)
+        );
+    }
+};
+
+} // namespace lightwave
+
+REGISTER_INTEGRATOR(GuidedPathTracerIntegrator, "guided")
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/color.hpp>
+#include <lightwave/math.hpp>
+#include <lightwave/distribution.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace lightwave {
+
+/**
+ * @brief A learned approximation of the incident radiance in a scene, used to guide the sampling of directions.
+ * The bounding box of the scene is divided into a regular grid of cells, each of which holds a directional histogram
+ * over the sphere of directions. The histograms use a cylindrical (equal-area) parametrization, such that every bin
+ * covers the same solid angle.
+ * Training happens in passes: during a pass, paths record their incident radiance via @ref record (which only uses
+ * atomic additions and hence scales across threads), and @ref update turns the recorded estimates into the sampling
+ * distributions used for the next pass.
+ * @see "Practical Path Guiding for Efficient Light-Transport Simulation" (Müller et al., 2017), which uses adaptive
+ * trees instead of regular grids and histograms.
+ */
+class GuidingField {
+    /// @brief The region of space covered by the grid.
+    Bounds m_bounds;
+    /// @brief The number of cells along each axis of the grid.
+    int m_spatialResolution;
+    /// @brief The number of histogram bins along each axis of the directional parametrization.
+    int m_directionalResolution;
+
+    /// @brief The recorded radiance estimates of the current training pass, for all bins of all cells.
+    std::vector<std::atomic<float>> m_training;
+    /// @brief The sampling distribution of every cell (empty if nothing has been learned for the cell).
+    std::vector<AliasTable> m_distributions;
+
+    int binsPerCell() const { return m_directionalResolution * m_directionalResolution; }
+
+    /// @brief Maps a direction to its histogram bin.
+    int binIndex(const Vector &direction) const {
+        const float u = (std::clamp(direction.z(), -1.f, 1.f) + 1) / 2;
+        float phi = std::atan2(direction.y(), direction.x());
+        if (phi < 0) phi += 2 * Pi;
+        const float v = phi * Inv2Pi;
+
+        const int iu = std::clamp(int(u * m_directionalResolution), 0, m_directionalResolution - 1);
+        const int iv = std::clamp(int(v * m_directionalResolution), 0, m_directionalResolution - 1);
+        return iu * m_directionalResolution + iv;
+    }
+
+public:
+    GuidingField(const Bounds &bounds, int spatialResolution, int directionalResolution)
+        : m_bounds(bounds), m_spatialResolution(spatialResolution), m_directionalResolution(directionalResolution) {
+        if (m_bounds.isUnbounded() || m_bounds.isEmpty()) {
+            // without finite bounds, the entire scene shares a single cell
+            m_spatialResolution = 1;
+        }
+
+        const int cellCount = m_spatialResolution * m_spatialResolution * m_spatialResolution;
+        m_training = std::vector<std::atomic<float>>(size_t(cellCount) * binsPerCell());
+        m_distributions.resize(cellCount);
+    }
+
+    /// @brief Returns the index of the grid cell that contains the given position.
+    int cellIndex(const Point &position) const {
+        if (m_spatialResolution == 1)
+            return 0;
+
+        int index = 0;
+        for (int dim = 0; dim < 3; dim++) {
+            const float extent = m_bounds.max()[dim] - m_bounds.min()[dim];
+            const float offset = extent > 0 ? (position[dim] - m_bounds.min()[dim]) / extent : 0;
+            const int cell = std::clamp(int(offset * m_spatialResolution), 0, m_spatialResolution - 1);
+            index = index * m_spatialResolution + cell;
+        }
+        return index;
+    }
+
+    /// @brief Reports whether a sampling distribution has been learned for the given cell.
+    bool isTrained(int cell) const { return !m_distributions[cell].empty(); }
+
+    /**
+     * @brief Records an estimate of the radiance incident from a given direction, i.e., the radiance divided by the
+     * density with which the direction has been sampled. Can be called from multiple threads concurrently.
+     */
+    void record(int cell, const Vector &direction, float value) {
+        if (!(value > 0) || !std::isfinite(value))
+            return;
+        m_training[size_t(cell) * binsPerCell() + binIndex(direction)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Replaces the sampling distributions by the estimates recorded since the last update, and clears the
+     * recorded estimates for the next training pass.
+     * @note Must not be called while other threads are recording or sampling.
+     */
+    void update() {
+        std::vector<float> weights(binsPerCell());
+        for (size_t cell = 0; cell < m_distributions.size(); cell++) {
+            for (int bin = 0; bin < binsPerCell(); bin++) {
+                weights[bin] = m_training[cell * binsPerCell() + bin].exchange(0, std::memory_order_relaxed);
+            }
+            m_distributions[cell].build(weights);
+        }
+    }
+
+    /**
+     * @brief Forgets everything that has been learned and recorded, such that the field can be trained from scratch.
+     * @note Must not be called while other threads are recording or sampling.
+     */
+    void clear() {
+        for (auto &value : m_training) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        for (auto &distribution : m_distributions) {
+            distribution = AliasTable();
+        }
+    }
+
+    /// @brief Samples a direction proportional to the learned incident radiance of a trained cell.
+    Vector sample(int cell, const Point2 &binSample, const Point2 &positionSample) const {
+        const int bin = m_distributions[cell].sample(binSample.x(), binSample.y());
+        const int iu = bin / m_directionalResolution;
+        const int iv = bin % m_directionalResolution;
+
+        const float z = 2 * (iu + positionSample.x()) / m_directionalResolution - 1;
+        const float phi = 2 * Pi * (iv + positionSample.y()) / m_directionalResolution;
+        const float r = safe_sqrt(1 - z * z);
+        return { r * std::cos(phi), r * std::sin(phi), z };
+    }
+
+    /// @brief Returns the density (in solid angle) of @ref sample producing the given direction.
+    float pdf(int cell, const Vector &direction) const {
+        if (!isTrained(cell))
+            return 0;
+        return m_distributions[cell].pmf(binIndex(direction)) * binsPerCell() * Inv4Pi;
+    }
+};
+
+}
@@ -13,8 +13,9 @@ public:
         remap = properties.get<bool>("remap", true);
     }
 
-    Color Li(const Ray& ray, Sampler& rng) override {
+    Color Li(const RayDifferential& ray, Sampler& rng) override {
         const Intersection intersection = m_scene->intersect(ray, rng);
+        recordPrimaryHit(intersection);
         const Vector normal = intersection ? intersection.frame.normal : Vector(0.0f);
         return remap ? Color((normal + Vector(1.0f)) * 0.5f) : Color(normal);
     }
@@ -1,77 +1,252 @@
 #include <lightwave.hpp>
 
+#include <atomic>
+
 namespace lightwave {
 
 class PathTracerIntegrator : public SamplingIntegrator {
 private:
     int m_maxDepth;
+    /// Whether area lights that can be hit are also sampled by NEE, combining both strategies with the power heuristic.
+    bool m_mis;
+    /// The depth from which on paths are terminated randomly based on their throughput (Russian roulette).
+    int m_rrDepth;
+    /// The maximum luminance of contributions found after the first bounce (infinite if no clamping is desired).
+    float m_clamp;
+
+    /// The number of shadow rays traced for next-event estimation at the first vertex of each path.
+    int m_neeSamples;
+    /// The number of Bsdf samples taken at the first vertex of each path, each of which continues as its own branch.
+    int m_firstBounceSplits;
+
+    /// The number of branches that traced a given number of rays (including the camera ray), recorded during rendering.
+    std::vector<std::atomic<uint64_t>> m_pathLengths;
+    /// The total number of camera rays traced during rendering.
+    uint64_t m_cameraRays;
+    /// The total number of shadow rays traced for next-event estimation during rendering.
+    uint64_t m_shadowRays;
+
+    /**
+     * The path lengths counted by the calling thread, which are only added to the shared counters once the thread has
+     * finished rendering (i.e., when it exits or when it starts counting for another integrator), such that paths are
+     * counted without contention between threads.
+     */
+    struct LocalPathLengths {
+        PathTracerIntegrator *owner = nullptr;
+        std::vector<uint64_t> counts;
+
+        void flush() {
+            if (!owner) return;
+            for (size_t length = 0; length < counts.size(); length++) {
+                owner->m_pathLengths[length].fetch_add(counts[length], std::memory_order_relaxed);
+            }
+            owner = nullptr;
+        }
 
-public:
-    explicit PathTracerIntegrator(const Properties& properties) : SamplingIntegrator(properties) {
-        m_maxDepth = properties.get<int>("depth", 2);
+        ~LocalPathLengths() { flush(); }
+    };
+    static thread_local LocalPathLengths s_localPathLengths;
+
+    /// Counts a branch that has traced the given number of rays.
+    void countPath(int length) {
+        LocalPathLengths &local = s_localPathLengths;
+        if (local.owner != this) {
+            local.flush();
+            local.owner = this;
+            local.counts.assign(m_pathLengths.size(), 0);
+        }
+        local.counts[length]++;
+    }
+
+    /// Scales down contributions that exceed the clamping threshold, which trades bias for fewer fireflies.
+    Color clamp(const Color& contribution) const {
+        const float luminance = contribution.luminance();
+        return luminance > m_clamp ? contribution * (m_clamp / luminance) : contribution;
     }
 
-    Color Li(const Ray& ray, Sampler& rng) override {
+    /// Logs the number of rays that have been traced by each strategy, in total and at each bounce.
+    void logStatistics() const {
+        uint64_t paths = 0;
+        uint64_t rays = 0;
+        for (size_t length = 0; length < m_pathLengths.size(); length++) {
+            paths += m_pathLengths[length];
+            rays += length * m_pathLengths[length];
+        }
+        if (paths == 0 || m_cameraRays == 0) {
+            return;
+        }
+
+        // all branches of a path share its camera ray
+        const uint64_t bounceRays = rays - paths;
+        logger(EInfo, "per camera ray: %.3f branches, %.3f bounce rays, %.3f shadow rays",
+               double(paths) / m_cameraRays, double(bounceRays) / m_cameraRays, double(m_shadowRays) / m_cameraRays);
+        // every branch that traced more than d rays contributes a ray to bounce d > 0 (a depth of zero has no bounces)
+        std::string raysPerBounce = tfm::format("%d", m_cameraRays);
+        uint64_t remaining = paths - m_pathLengths[0] - (m_pathLengths.size() > 1 ? m_pathLengths[1].load() : 0);
+        for (size_t length = 2; length < m_pathLengths.size() && remaining > 0; length++) {
+            raysPerBounce += tfm::format(", %d", remaining);
+            remaining -= m_pathLengths[length];
+        }
+        logger(EInfo, "rays per bounce: %s", raysPerBounce);
+    }
+
+    /**
+     * Traces a path (or a branch of it) starting at the given ray, recording the number of rays that have been traced.
+     * @param bsdfPdf The density with which MIS weights the Bsdf sample that produced the ray (infinite for camera rays,
+     * which cannot be produced by next-event estimation), already multiplied by the number of Bsdf samples.
+     * @param lightSamples The number of shadow rays traced at the vertex the ray starts at.
+     */
+    Color trace(RayDifferential currentRay, Color currentWeight, float bsdfPdf, int lightSamples, int depth, Sampler& rng) {
         Color result = Color::black();
-        Ray currentRay = ray;
-        Color currentWeight = Color::white();
 
-        for (int depth = 0; depth < m_maxDepth; depth++) {
-            const Intersection its = m_scene->intersect(currentRay, rng);
+        for (; depth < m_maxDepth; depth++) {
+            // Russian roulette: terminate paths with low throughput, and compensate survivors to remain unbiased
+            if (depth > 0 && depth >= m_rrDepth) {
+                const float survivalProbability = std::min(
+                        std::max({ currentWeight.r(), currentWeight.g(), currentWeight.b() }), 1.0f);
+                if (rng.next() >= survivalProbability) {
+                    break;
+                }
+                currentWeight /= survivalProbability;
+            }
+
+            Intersection its = m_scene->intersect(currentRay, rng);
+            if (depth == 0) {
+                recordPrimaryHit(its);
+            }
             if (!its) {
-                return result + m_scene->evaluateBackground(currentRay.direction).value * currentWeight;
+                // The background might also have been sampled by next-event estimation at the previous vertex
+                const float misWeight = misWeightBackground(currentRay.origin, currentRay.direction, bsdfPdf,
+                                                            lightSamples, m_mis);
+                const Color contribution = m_scene->evaluateBackground(currentRay.direction).value * currentWeight * misWeight;
+                result += depth > 0 ? clamp(contribution) : contribution;
+                depth++;
+                break;
             }
 
+            // The footprint of the ray lets textures filter details that are too small to be resolved
+            its.computeDifferentials(currentRay);
+
             if (its.instance->emission() != nullptr) {
-                result += its.evaluateEmission() * currentWeight;
+                // Emission of area lights might also have been sampled by next-event estimation at the previous vertex
+                const float misWeight = misWeightEmission(currentRay.origin, its, bsdfPdf, lightSamples, m_mis);
+                const Color contribution = its.evaluateEmission() * currentWeight * misWeight;
+                result += depth > 0 ? clamp(contribution) : contribution;
             }
 
             // Don't evaluate NEE on last bounce
             if (depth == m_maxDepth - 1) {
-                return result;
+                depth++;
+                break;
             }
 
-            const BsdfSample bsdfSample = its.sampleBsdf(rng);
-            // Terminate on invalid sample
-            if (bsdfSample.isInvalid()) {
-                return result;
-            }
+            // Splitting only happens at the first vertex, which amortizes the cost of the camera ray
+            lightSamples = depth == 0 ? m_neeSamples : 1;
+            const int bsdfSamples = depth == 0 ? m_firstBounceSplits : 1;
 
-            // Next-event estimation (shadow ray towards random non-intersectable light)
-            if (m_scene->hasLights()) {
-                const LightSample sampledLight = m_scene->sampleLight(rng);
-                const DirectLightSample sampledLightPoint = sampledLight.light->sampleDirect(its.position, rng);
-
-                if (!sampledLight.light->canBeIntersected() && !sampledLightPoint.isInvalid()) {
-                    const Ray shadowRay = {its.position, sampledLightPoint.wi};
+            // Next-event estimation (shadow rays towards random sampleable lights)
+            for (int lightSample = 0; m_scene->hasLights(m_mis) && lightSample < lightSamples; lightSample++) {
+                const Color direct = estimateDirectLight(its, rng, lightSamples, m_mis, [&](const Vector& wi) {
+                    return bsdfSamples * its.pdfBsdf(wi);
+                });
+                result += clamp(direct * currentWeight) / float(lightSamples);
+            }
 
-                    if (!m_scene->intersect(shadowRay, sampledLightPoint.distance, rng)) {
-                        const BsdfEval bsdfEval = its.evaluateBsdf(sampledLightPoint.wi);
-                        result += sampledLightPoint.weight * bsdfEval.value * currentWeight / sampledLight.probability;
+            if (bsdfSamples > 1) {
+                // Each Bsdf sample continues as its own branch, and the branches are averaged
+                Color branches = Color::black();
+                for (int bsdfSample = 0; bsdfSample < bsdfSamples; bsdfSample++) {
+                    const BsdfSample sample = its.sampleBsdf(rng);
+                    if (sample.isInvalid()) {
+                        countPath(depth + 1);
+                        continue;
                     }
+                    branches += trace(its.spawnRay(currentRay, sample.wi, std::isinf(sample.pdf)),
+                                      currentWeight * sample.weight, misBsdfPdf(its, sample.wi, bsdfSamples * sample.pdf),
+                                      lightSamples, depth + 1, rng);
                 }
+                return result + branches / float(bsdfSamples);
             }
 
-            // Preparation for next bounce
+            // Sample the Bsdf only after next-event estimation, which must not be skipped when Bsdf sampling fails
+            const BsdfSample bsdfSample = its.sampleBsdf(rng);
+            if (bsdfSample.isInvalid()) {
+                depth++;
+                break;
+            }
+
+            // Preparation for next bounce (only specular bounces keep the ray differentials, as rougher bounces
+            // spread the footprint of a pixel across the scene)
             currentWeight *= bsdfSample.weight;
-            currentRay = {its.position, bsdfSample.wi};
+            currentRay = its.spawnRay(currentRay, bsdfSample.wi, std::isinf(bsdfSample.pdf));
+            bsdfPdf = misBsdfPdf(its, bsdfSample.wi, bsdfSample.pdf);
         }
 
+        // depth now holds the number of rays this branch has traced
+        countPath(depth);
         return result;
     }
 
+public:
+    explicit PathTracerIntegrator(const Properties& properties) : SamplingIntegrator(properties),
+                                                                  m_cameraRays(0),
+                                                                  m_shadowRays(0) {
+        m_maxDepth = properties.get<int>("depth", 2);
+        m_mis = properties.get<bool>("mis", false);
+        // Russian roulette is disabled by default, i.e., starts only after the maximum depth has been reached
+        m_rrDepth = properties.get<int>("rrDepth", m_maxDepth);
+        m_clamp = properties.get<float>("clamp", Infinity);
+        m_neeSamples = properties.get<int>("neeSamples", 1);
+        m_firstBounceSplits = properties.get<int>("firstBounceSplits", 1);
+        m_pathLengths = std::vector<std::atomic<uint64_t>>(m_maxDepth + 1);
+    }
+
+    void execute() override {
+        for (auto& count : m_pathLengths) {
+            count = 0;
+        }
+        // rays are counted by the telemetry of each thread, of which only the rays traced by this render are used
+        const uint64_t startCameraRays = Telemetry::total(Telemetry::EPrimaryRays);
+        const uint64_t startShadowRays = Telemetry::total(Telemetry::EShadowRays);
+
+        SamplingIntegrator::execute();
+        // the rendering threads have exited (and hence added their counts) unless rendering is single threaded
+        s_localPathLengths.flush();
+        m_cameraRays = Telemetry::total(Telemetry::EPrimaryRays) - startCameraRays;
+        m_shadowRays = Telemetry::total(Telemetry::EShadowRays) - startShadowRays;
+        logStatistics();
+    }
+
+    Color Li(const RayDifferential& ray, Sampler& rng) override {
+        return trace(ray, Color::white(), Infinity, 0, 0, rng);
+    }
+
     std::string toString() const override {
         return tfm::format(
                 "PathTracerIntegrator[\n"
+                "  depth = %d,\n"
+                "  mis = %s,\n"
+                "  rrDepth = %d,\n"
+                "  clamp = %f,\n"
+                "  neeSamples = %d,\n"
+                "  firstBounceSplits = %d,\n"
                 "  sampler = %s,\n"
                 "  image = %s,\n"
                 "]",
+                m_maxDepth,
+                m_mis ? "true" : "false",
+                m_rrDepth,
+                m_clamp,
+                m_neeSamples,
+                m_firstBounceSplits,
                 indent(m_sampler),
                 indent(m_image)
         );
     }
 };
 
+thread_local PathTracerIntegrator::LocalPathLengths PathTracerIntegrator::s_localPathLengths;
+
 } // namespace lightwave
 
 REGISTER_INTEGRATOR(PathTracerIntegrator, "pathtracer")
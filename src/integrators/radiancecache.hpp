@@ -0,0 +1,171 @@
+#pragma once
+
+#include <lightwave/core.hpp>
+#include <lightwave/color.hpp>
+#include <lightwave/math.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+namespace lightwave {
+
+/**
+ * @brief Caches the radiance leaving surfaces, averaged over small regions of space with similar surface orientation.
+ * Records live in a fixed-size hash table with open addressing, whose keys are derived from the quantized position and
+ * the quantized normal of a surface point, as well as the depth of the path at that point (since paths of limited
+ * length find less radiance the deeper they already are). New records claim an empty slot with a single compare-and-swap, and
+ * estimates are accumulated with atomic additions, so the cache can be filled by many threads without locks.
+ * If all slots a key could occupy are taken, the estimate is dropped.
+ * @note The cache stores a single radiance value per record, hence it only approximates surfaces that reflect
+ * similarly in all directions (i.e., diffuse or very rough surfaces).
+ */
+class RadianceCache {
+    struct Record {
+        /// @brief The key of the region this record belongs to (or zero if the slot is empty).
+        std::atomic<uint64_t> key;
+        /// @brief The sum of all radiance estimates recorded for the region.
+        std::atomic<float> radiance[Color::NumComponents];
+        /// @brief The number of radiance estimates recorded for the region.
+        std::atomic<uint32_t> count;
+    };
+
+    /// @brief The number of consecutive slots that are searched for a key before giving up.
+    static constexpr int MaxProbes = 8;
+
+    std::unique_ptr<Record[]> m_records;
+    uint64_t m_mask;
+    /// @brief The edge length of the cubical regions that share a record.
+    float m_cellSize;
+    /// @brief The number of bins along each axis of the (octahedral) quantization of normals.
+    int m_normalResolution;
+
+    /// @brief Mixes the bits of a 64 bit integer (the finalizer of SplitMix64).
+    static uint64_t hashMix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /// @brief Maps a normal to a bin of its octahedral projection.
+    int normalBin(const Vector &normal) const {
+        const float norm = std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+        float u = normal.x() / norm;
+        float v = normal.y() / norm;
+        if (normal.z() < 0) {
+            const float foldedU = (1 - std::abs(v)) * (u >= 0 ? 1 : -1);
+            const float foldedV = (1 - std::abs(u)) * (v >= 0 ? 1 : -1);
+            u = foldedU;
+            v = foldedV;
+        }
+
+        const int iu = std::clamp(int((u + 1) / 2 * m_normalResolution), 0, m_normalResolution - 1);
+        const int iv = std::clamp(int((v + 1) / 2 * m_normalResolution), 0, m_normalResolution - 1);
+        return iu * m_normalResolution + iv;
+    }
+
+    uint64_t key(const Point &position, const Vector &normal, int depth) const {
+        uint64_t hash = uint64_t(normalBin(normal)) | (uint64_t(depth) << 32);
+        for (int dim = 0; dim < 3; dim++) {
+            const int64_t cell = int64_t(std::floor(position[dim] / m_cellSize));
+            hash = hashMix(hash ^ (uint64_t(cell) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2)));
+        }
+        // zero marks empty slots
+        return hash == 0 ? 1 : hash;
+    }
+
+    /// @brief Returns the record for the given key, optionally claiming an empty slot for it.
+    Record *find(uint64_t key, bool insert) const {
+        for (int probe = 0; probe < MaxProbes; probe++) {
+            Record &record = m_records[(key + probe) & m_mask];
+            uint64_t current = record.key.load(std::memory_order_relaxed);
+            if (current == 0) {
+                if (!insert)
+                    return nullptr;
+                // on failure, current receives the key of whichever thread claimed the slot first
+                if (record.key.compare_exchange_strong(current, key, std::memory_order_relaxed))
+                    return &record;
+            }
+            if (current == key)
+                return &record;
+        }
+        return nullptr;
+    }
+
+public:
+    /// @brief The result of looking up the cache.
+    struct Lookup {
+        /// @brief The average radiance of all estimates recorded for the region.
+        Color radiance;
+        /// @brief The number of estimates recorded for the region (zero if no record exists).
+        int count;
+        /// @brief A value that identifies the record, e.g., for visualizing the structure of the cache.
+        uint64_t key;
+    };
+
+    /**
+     * @param capacityLog2 The base-two logarithm of the number of records the cache can hold.
+     * @param cellSize The edge length of the cubical regions that share a record.
+     * @param normalResolution The number of bins along each axis of the quantization of normals.
+     */
+    RadianceCache(int capacityLog2, float cellSize, int normalResolution)
+        : m_records(new Record[size_t(1) << capacityLog2]()),
+          m_mask((uint64_t(1) << capacityLog2) - 1),
+          m_cellSize(cellSize),
+          m_normalResolution(normalResolution) {}
+
+    /**
+     * @brief Removes all records from the cache.
+     * @note Must not be called while other threads are recording or looking up the cache.
+     */
+    void clear() {
+        for (uint64_t index = 0; index <= m_mask; index++) {
+            Record &record = m_records[index];
+            record.key.store(0, std::memory_order_relaxed);
+            for (int channel = 0; channel < Color::NumComponents; channel++) {
+                record.radiance[channel].store(0, std::memory_order_relaxed);
+            }
+            record.count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief Adds a radiance estimate for the given surface point. Can be called from multiple threads concurrently.
+    void record(const Point &position, const Vector &normal, int depth, const Color &radiance) {
+        for (int channel = 0; channel < Color::NumComponents; channel++) {
+            if (!std::isfinite(radiance[channel]))
+                return;
+        }
+
+        Record *record = find(key(position, normal, depth), true);
+        if (!record)
+            return;
+        for (int channel = 0; channel < Color::NumComponents; channel++) {
+            record->radiance[channel].fetch_add(radiance[channel], std::memory_order_relaxed);
+        }
+        record->count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// @brief Looks up the average radiance recorded for the region of the given surface point.
+    Lookup lookup(const Point &position, const Vector &normal, int depth) const {
+        const uint64_t k = key(position, normal, depth);
+        const Record *record = find(k, false);
+        if (!record)
+            return { .radiance = Color(0), .count = 0, .key = k };
+
+        const uint32_t count = record->count.load(std::memory_order_relaxed);
+        if (count == 0)
+            return { .radiance = Color(0), .count = 0, .key = k };
+
+        Color radiance;
+        for (int channel = 0; channel < Color::NumComponents; channel++) {
+            radiance[channel] = record->radiance[channel].load(std::memory_order_relaxed) / count;
+        }
+        return { .radiance = radiance, .count = int(count), .key = k };
+    }
+};
+
+}
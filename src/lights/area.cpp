@@ -2,9 +2,11 @@
 
 namespace lightwave {
 /**
- * A non-intersectable light with an area sampled via NEE (see point.cpp for details).
+ * A light with an area sampled via NEE (see point.cpp for details).
  * Here we additionally need to divide by the probability of sampling a point on our area, since in the end we want to
  * compute an average.
+ * If the instance is also visible, the light is only sampled for integrators that combine NEE with hitting the light
+ * via multiple importance sampling (see Scene::hasLights).
  */
 class AreaLight final : public Light {
 private:
@@ -13,6 +15,7 @@ private:
 public:
     explicit AreaLight(const Properties& properties) {
         m_instance = properties.getChild<Instance>();
+        m_instance->setLight(this);
     }
 
     DirectLightSample sampleDirect(const Point& origin, Sampler& rng) const override {
@@ -24,20 +27,57 @@ public:
         wi = wi.normalized();
 
         if (m_instance->emission() == nullptr) {
-            return {wi, Color::black(), distance};
+            return DirectLightSample::invalid();
         }
 
         const float cosTheta = abs(sample.frame.normal.dot(wi));
         const Color emission = m_instance->emission()->evaluate(sample.uv, sample.frame.toLocal(-wi)).value
                                * cosTheta / (distanceSquared * sample.pdf);
 
-        return {wi, emission, distance};
+        return {wi, emission, distance, sample.pdf * distanceSquared / cosTheta};
+    }
+
+    /// Relies on the instance reporting the density of sampling the intersected point (in area measure) in @c its.pdf .
+    float pdf(const Point& origin, const Intersection& its) const override {
+        const float cosTheta = abs(its.frame.normal.dot(its.wo));
+        if (cosTheta == 0) {
+            return 0;
+        }
+        return its.pdf * (its.position - origin).lengthSquared() / cosTheta;
     }
 
     bool canBeIntersected() const override {
         return m_instance->isVisible();
     }
 
+    /**
+     * Monte Carlo estimate of the emitted power, i.e., Pi times the radiance integrated over the surface (assuming
+     * the emission is diffuse, hence the radiance is only queried in normal direction).
+     */
+    float estimatePower(const Bounds& sceneBounds, Sampler& rng) const override {
+        if (m_instance->emission() == nullptr) {
+            return 0;
+        }
+
+        constexpr int SampleCount = 64;
+        float sum = 0;
+        for (int i = 0; i < SampleCount; i++) {
+            const AreaSample sample = m_instance->sampleArea(rng);
+            if (sample.pdf > 0) {
+                sum += m_instance->emission()->evaluate(sample.uv, Vector(0, 0, 1)).value.luminance() / sample.pdf;
+            }
+        }
+        return Pi * sum / SampleCount;
+    }
+
+    /// Since shapes do not report the orientation of their surfaces, we conservatively assume emission in all directions.
+    std::optional<LightBounds> getLightBounds() const override {
+        LightBounds result;
+        result.bounds = m_instance->getBoundingBox();
+        result.twoSided = true;
+        return result;
+    }
+
     std::string toString() const override {
         return tfm::format(
                 "AreaLight[\n"
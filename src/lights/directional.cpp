@@ -19,13 +19,19 @@ public:
     }
 
     DirectLightSample sampleDirect(const Point& origin, Sampler& rng) const override {
-        return {m_direction, m_radiosity, Infinity};
+        return {m_direction, m_radiosity, Infinity, Infinity};
     }
 
     bool canBeIntersected() const override {
         return false;
     }
 
+    /// The light passes through the disk that the bounding sphere of the scene casts onto a plane orthogonal to it.
+    float estimatePower(const Bounds& sceneBounds, Sampler& rng) const override {
+        const float radius = sceneBounds.isUnbounded() ? 1 : sceneBounds.diagonal().length() / 2;
+        return Pi * radius * radius * m_radiosity.luminance();
+    }
+
     std::string toString() const override {
         return tfm::format("DirectionalLight[]");
     }
@@ -4,19 +4,76 @@ namespace lightwave {
 /**
  * A light-emitting skybox (actually skysphere) around the scene. The walls of the sphere are infinitely far away from
  * the scene, which allows to abstract the scene into a single point located at its center.
+ * For next-event estimation, directions are importance sampled from a piecewise constant distribution over the texels
+ * of the texture, which makes small and bright light sources (like the sun) converge quickly.
  */
 class EnvironmentMap final : public BackgroundLight {
 private:
     /// @brief The texture to use as background
     ref<Texture> m_texture;
 
-    /// @brief An optional transform from local-to-world space
+    /// @brief An optional transform from local-to-world space (assumed to be a rotation)
     ref<Transform> m_transform;
 
+    /// @brief The number of cells of the sampling distribution in u and v direction.
+    Point2i m_resolution;
+    /// @brief Picks cells proportional to their brightness times their solid angle, stored row by row.
+    AliasTable m_distribution;
+
+    /// @brief The resolution used for the sampling distribution of textures without inherent resolution.
+    static constexpr int DefaultResolution = 64;
+
+    /**
+     * Weighs each cell by the luminance of the texture times sin(theta), since cells close to the poles of the sphere
+     * cover a smaller solid angle. The texture is queried at the center and the corners of each cell, so that cells
+     * that only receive light from a neighbor due to texture filtering can still be sampled.
+     */
+    void buildDistribution() {
+        m_resolution = m_texture->resolution();
+        if (m_resolution.x() <= 0 || m_resolution.y() <= 0) {
+            m_resolution = Point2i(2 * DefaultResolution, DefaultResolution);
+        }
+
+        std::vector<float> weights(m_resolution.x() * m_resolution.y());
+        for (int y = 0; y < m_resolution.y(); y++) {
+            const float sinTheta = std::sin((y + 0.5f) / m_resolution.y() * Pi);
+            for (int x = 0; x < m_resolution.x(); x++) {
+                float maximum = 0;
+                for (const Point2 offset : { Point2(0.5f, 0.5f), Point2(0, 0), Point2(1, 0), Point2(0, 1), Point2(1, 1) }) {
+                    const Point2 uv = {
+                            (x + offset.x()) / m_resolution.x(),
+                            (y + offset.y()) / m_resolution.y(),
+                    };
+                    maximum = std::max(maximum, m_texture->evaluate(uv).luminance());
+                }
+                weights[y * m_resolution.x() + x] = maximum * sinTheta;
+            }
+        }
+
+        m_distribution.build(weights);
+    }
+
+    /// @brief Maps texture coordinates to a direction in local space (the inverse of the mapping in @ref evaluate ).
+    static Vector directionFromUV(const Point2& uv, float& sinTheta) {
+        const float theta = uv.y() * Pi;
+        const float phi = (uv.x() - 0.5f) * 2 * Pi;
+        sinTheta = std::sin(theta);
+        return {sinTheta * std::cos(phi), std::cos(theta), -sinTheta * std::sin(phi)};
+    }
+
+    /// @brief Converts the density of sampling a cell to the density of sampling a direction within it.
+    float pdfFromCell(int cell, float sinTheta) const {
+        if (sinTheta <= 0) return 0;
+        const float pdfUV = m_distribution.pmf(cell) * float(m_resolution.x() * m_resolution.y());
+        return pdfUV / (2 * Pi * Pi * sinTheta);
+    }
+
 public:
     explicit EnvironmentMap(const Properties& properties) {
         m_texture = properties.getChild<Texture>();
         m_transform = properties.getOptionalChild<Transform>();
+
+        buildDistribution();
     }
 
     /**
@@ -36,27 +93,79 @@ public:
         return {m_texture->evaluate({u, v})};
     }
 
+    /**
+     * Picks a cell of the distribution and a uniformly distributed point within it, which is then mapped to the
+     * sphere. The density is converted from texture space to solid angle by the Jacobian of the spherical mapping.
+     */
     DirectLightSample sampleDirect(const Point& origin, Sampler& rng) const override {
-        const Vector direction = squareToUniformSphere(rng.next2D()).normalized();
-        const Color eval = evaluate(direction).value;
+        if (m_distribution.empty()) {
+            return DirectLightSample::invalid();
+        }
+
+        // environment maps have far too many cells to pick one and the position within it from the same numbers
+        const Point2 cellRnd = rng.next2D();
+        const int cell = m_distribution.sample(cellRnd.x(), cellRnd.y());
+        const Point2 rnd = rng.next2D();
+        const Point2 uv = {
+                (cell % m_resolution.x() + rnd.x()) / m_resolution.x(),
+                (cell / m_resolution.x() + rnd.y()) / m_resolution.y(),
+        };
 
-        // implement better importance sampling here, if you ever need it
-        // (useful for environment maps with bright tiny light sources, like the
-        // sun for example)
+        float sinTheta;
+        const Vector localDirection = directionFromUV(uv, sinTheta);
+        const float pdf = pdfFromCell(cell, sinTheta);
+        if (pdf <= 0) {
+            return DirectLightSample::invalid();
+        }
 
+        const Vector direction = m_transform ? m_transform->apply(localDirection).normalized() : localDirection;
         return {
                 .wi = direction,
-                .weight = eval * Inv4Pi,
+                .weight = evaluate(direction).value / pdf,
                 .distance = Infinity,
+                .pdf = pdf,
+        };
+    }
+
+    bool canBeSampled() const override {
+        return !m_distribution.empty();
+    }
+
+    float pdf(const Point& origin, const Vector& wi) const override {
+        if (m_distribution.empty()) {
+            return 0;
+        }
+
+        const Vector localDirection = (m_transform ? m_transform->inverse(wi) : wi).normalized();
+        const float theta = safe_acos(localDirection.y());
+        const float phi = atan2f(-localDirection.z(), localDirection.x());
+
+        const Point2i cell = {
+                std::clamp(int((phi * Inv2Pi + 0.5f) * m_resolution.x()), 0, m_resolution.x() - 1),
+                std::clamp(int(theta * InvPi * m_resolution.y()), 0, m_resolution.y() - 1),
         };
+        return pdfFromCell(cell.y() * m_resolution.x() + cell.x(), std::sin(theta));
+    }
+
+    /// Radiance arriving from all directions, passing through the disk cast by the bounding sphere of the scene.
+    float estimatePower(const Bounds& sceneBounds, Sampler& rng) const override {
+        constexpr int SampleCount = 256;
+        float sum = 0;
+        for (int i = 0; i < SampleCount; i++) {
+            sum += evaluate(squareToUniformSphere(rng.next2D())).value.luminance();
+        }
+
+        const float radius = sceneBounds.isUnbounded() ? 1 : sceneBounds.diagonal().length() / 2;
+        return 4 * Pi * Pi * radius * radius * sum / SampleCount;
     }
 
     std::string toString() const override {
         return tfm::format("EnvironmentMap[\n"
                            "  texture = %s,\n"
-                           "  transform = %s\n"
+                           "  transform = %s,\n"
+                           "  resolution = %s\n"
                            "]",
-                           indent(m_texture), indent(m_transform)
+                           indent(m_texture), indent(m_transform), m_resolution
         );
     }
 };
@@ -33,13 +33,24 @@ public:
         const float distance = std::sqrt(distanceSquared);
         const Color weight = m_intensity / distanceSquared;
 
-        return {wi.normalized(), weight, distance};
+        return {wi.normalized(), weight, distance, Infinity};
     }
 
     bool canBeIntersected() const override {
         return false;
     }
 
+    /// The intensity is emitted uniformly into the entire sphere of directions.
+    float estimatePower(const Bounds& sceneBounds, Sampler& rng) const override {
+        return 4 * Pi * m_intensity.luminance();
+    }
+
+    std::optional<LightBounds> getLightBounds() const override {
+        LightBounds result;
+        result.bounds.extend(m_position);
+        return result;
+    }
+
     std::string toString() const override {
         return tfm::format("PointLight[]");
     }
@@ -0,0 +1,192 @@
+#include <lightwave.hpp>
+
+#ifdef LW_WITH_OIDN
+#include <OpenImageDenoise/oidn.hpp>
+#endif
+
+namespace lightwave {
+
+/**
+ * @brief Removes Monte Carlo noise from a rendered image, guided by the albedo and normal of the first surface hit
+ * (see the AOVs of @ref Film ), which preserves edges and texture detail the noisy image alone cannot tell apart from
+ * noise. Both guides are optional but improve the result considerably.
+ *
+ * Uses Intel Open Image Denoise when lightwave is built with it. Otherwise, a joint bilateral filter is used, which
+ * averages each pixel with neighbors of similar albedo, normal and (pre-filtered) color. To keep texture detail, it
+ * filters the illumination (the color divided by the albedo) rather than the color itself.
+ */
+class Denoise : public Postprocess {
+    /// @brief The albedo of the first surface hit, or null if not available.
+    ref<Image> m_albedo;
+    /// @brief The world space normal of the first surface hit, or null if not available.
+    ref<Image> m_normal;
+
+    /// @brief The radius of the bilateral filter window in pixels.
+    int m_radius;
+    /// @brief How strongly the bilateral filter preserves differences in albedo.
+    float m_albedoSigma;
+    /// @brief How strongly the bilateral filter preserves differences in normals (in terms of @code 1 - cos @endcode).
+    float m_normalSigma;
+    /// @brief How strongly the bilateral filter preserves differences in color, relative to the brightness.
+    float m_colorSigma;
+
+    /// @brief Checks that a guide image matches the resolution of the input.
+    void checkGuide(const ref<Image> &guide, const char *name, const Image &input) const {
+        if (guide && guide->resolution() != input.resolution()) {
+            lightwave_throw("the %s image of <postprocess type=\"denoise\" /> does not match the resolution of the input", name);
+        }
+    }
+
+#ifdef LW_WITH_OIDN
+    void denoiseOIDN(const Image &input, Image &output) {
+        const Point2i resolution = input.resolution();
+        oidn::DeviceRef device = oidn::newDevice();
+        device.commit();
+
+        oidn::FilterRef filter = device.newFilter("RT");
+        filter.setImage("color", const_cast<Color *>(input.data()), oidn::Format::Float3, resolution.x(), resolution.y());
+        if (m_albedo) {
+            filter.setImage("albedo", m_albedo->data(), oidn::Format::Float3, resolution.x(), resolution.y());
+            // normals are only supported in combination with albedo
+            if (m_normal) {
+                filter.setImage("normal", m_normal->data(), oidn::Format::Float3, resolution.x(), resolution.y());
+            }
+        }
+        filter.setImage("output", output.data(), oidn::Format::Float3, resolution.x(), resolution.y());
+        filter.set("hdr", true);
+        filter.commit();
+        filter.execute();
+
+        const char *message;
+        if (device.getError(message) != oidn::Error::None) {
+            lightwave_throw("Open Image Denoise failed: %s", message);
+        }
+    }
+#endif
+
+    /// @brief Returns the illumination of a pixel, i.e., its color with the albedo divided out where possible.
+    Color illumination(const Image &input, const Point2i &pixel) const {
+        Color color = input.get(pixel);
+        if (m_albedo) {
+            const Color &albedo = m_albedo->get(pixel);
+            for (int channel = 0; channel < color.NumComponents; channel++) {
+                if (albedo[channel] > 1e-3f)
+                    color[channel] /= albedo[channel];
+            }
+        }
+        return color;
+    }
+
+    void denoiseBilateral(const Image &input, Image &output) {
+        const Point2i resolution = input.resolution();
+
+        Image illuminations{ resolution };
+        for (auto pixel : input.bounds())
+            illuminations(pixel) = illumination(input, pixel);
+
+        // the color similarity is judged on a 3x3 box filtered version of the image, which is much less noisy
+        Image guide{ resolution };
+        for_each_parallel(Range(0, resolution.y()), [&](int y) {
+            for (int x = 0; x < resolution.x(); x++) {
+                Color sum;
+                int count = 0;
+                for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, resolution.y() - 1); ny++) {
+                    for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, resolution.x() - 1); nx++) {
+                        sum += illuminations(Point2i(nx, ny));
+                        count++;
+                    }
+                }
+                guide(Point2i(x, y)) = sum / float(count);
+            }
+        });
+
+        const float spatialSigma = std::max(m_radius / 2.0f, 0.5f);
+        for_each_parallel(Range(0, resolution.y()), [&](int y) {
+            for (int x = 0; x < resolution.x(); x++) {
+                const Point2i center{ x, y };
+                const Color centerGuide = guide(center);
+                const float colorScale = 1 / (sqr(m_colorSigma) * (sqr(centerGuide.luminance()) + 1e-4f));
+
+                Color sum;
+                float weightSum = 0;
+                for (int ny = std::max(y - m_radius, 0); ny <= std::min(y + m_radius, resolution.y() - 1); ny++) {
+                    for (int nx = std::max(x - m_radius, 0); nx <= std::min(x + m_radius, resolution.x() - 1); nx++) {
+                        const Point2i neighbor{ nx, ny };
+                        float exponent = (sqr(nx - x) + sqr(ny - y)) / (2 * sqr(spatialSigma));
+                        exponent += sqr((guide(neighbor) - centerGuide).luminance()) * colorScale / 2;
+                        if (m_albedo) {
+                            const Color difference = m_albedo->get(neighbor) - m_albedo->get(center);
+                            exponent += (sqr(difference.r()) + sqr(difference.g()) + sqr(difference.b())) /
+                                        (2 * sqr(m_albedoSigma));
+                        }
+                        if (m_normal) {
+                            const Color &a = m_normal->get(neighbor);
+                            const Color &b = m_normal->get(center);
+                            const float cosine = a.r() * b.r() + a.g() * b.g() + a.b() * b.b();
+                            exponent += std::max(1 - cosine, 0.0f) / m_normalSigma;
+                        }
+
+                        const float weight = std::exp(-exponent);
+                        sum += weight * illuminations(neighbor);
+                        weightSum += weight;
+                    }
+                }
+
+                Color result = sum / weightSum;
+                if (m_albedo) {
+                    const Color &albedo = m_albedo->get(center);
+                    for (int channel = 0; channel < result.NumComponents; channel++) {
+                        if (albedo[channel] > 1e-3f)
+                            result[channel] *= albedo[channel];
+                    }
+                }
+                output.get(center) = result;
+            }
+        });
+    }
+
+public:
+    Denoise(const Properties &properties)
+    : Postprocess(properties) {
+        m_albedo = properties.get<Image>("albedo", ref<Image>());
+        m_normal = properties.get<Image>("normal", ref<Image>());
+        m_radius = properties.get<int>("radius", 6);
+        m_albedoSigma = properties.get<float>("albedoSigma", 0.1f);
+        m_normalSigma = properties.get<float>("normalSigma", 0.1f);
+        m_colorSigma = properties.get<float>("colorSigma", 0.5f);
+    }
+
+    void process(const Image &input, Image &output) override {
+        checkGuide(m_albedo, "albedo", input);
+        checkGuide(m_normal, "normal", input);
+
+        Timer timer;
+#ifdef LW_WITH_OIDN
+        denoiseOIDN(input, output);
+        const char *method = "Open Image Denoise";
+#else
+        denoiseBilateral(input, output);
+        const char *method = "joint bilateral filter";
+#endif
+        logger(EInfo, "denoised \"%s\" using %s in %.3fs", input.id(), method, timer.getElapsedTime());
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "Denoise[\n"
+            "  input = %s,\n"
+            "  albedo = %s,\n"
+            "  normal = %s,\n"
+            "  radius = %d\n"
+            "]",
+            indent(m_input),
+            indent(m_albedo),
+            indent(m_normal),
+            m_radius
+        );
+    }
+};
+
+} // namespace lightwave
+
+REGISTER_POSTPROCESS(Denoise, "denoise")
@@ -0,0 +1,31 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/// @brief Scales the brightness of an image by a number of photographic stops (i.e., powers of two).
+class Exposure : public Postprocess {
+    float m_stops;
+    float m_scale;
+
+public:
+    Exposure(const Properties &properties)
+    : Postprocess(properties) {
+        m_stops = properties.get<float>("stops", 0.0f);
+        m_scale = std::exp2(m_stops);
+    }
+
+    bool isPointwise() const override { return true; }
+
+    void apply(Color *pixels, int count) const override {
+        for (int i = 0; i < count; i++)
+            pixels[i] *= m_scale;
+    }
+
+    std::string toString() const override {
+        return tfm::format("Exposure[ stops = %f ]", m_stops);
+    }
+};
+
+}
+
+REGISTER_POSTPROCESS(Exposure, "exposure")
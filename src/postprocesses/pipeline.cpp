@@ -0,0 +1,82 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Runs a sequence of postprocesses (its children, in order), passing the image between them in memory.
+ * Consecutive pointwise postprocesses (e.g., exposure, tone mapping and sRGB quantization) are fused into a single
+ * parallel pass over the image. Only the output of the pipeline is saved, the stages do not need images of their own.
+ */
+class Pipeline : public Postprocess {
+    std::vector<ref<Postprocess>> m_stages;
+
+public:
+    Pipeline(const Properties &properties)
+    : Postprocess(properties) {
+        m_stages = properties.getChildren<Postprocess>();
+    }
+
+    void process(const Image &input, Image &output) override {
+        if (m_stages.empty()) {
+            output.copy(input);
+            return;
+        }
+
+        // stages that are not pointwise cannot work in place, so intermediate results alternate between two buffers
+        Image buffers[2];
+        int nextBuffer = 0;
+        const Image *current = &input;
+        // the current image, if it is one of our buffers (and may hence be modified in place)
+        Image *scratch = nullptr;
+
+        size_t index = 0;
+        while (index < m_stages.size()) {
+            std::vector<Postprocess *> fused;
+            while (index + fused.size() < m_stages.size() && m_stages[index + fused.size()]->isPointwise()) {
+                fused.push_back(m_stages[index + fused.size()].get());
+            }
+            const size_t count = std::max(fused.size(), size_t(1));
+            const bool isLast = index + count == m_stages.size();
+
+            Image *target = &output;
+            if (!isLast) {
+                if (!fused.empty() && scratch) {
+                    target = scratch;
+                } else {
+                    target = &buffers[nextBuffer];
+                    nextBuffer = 1 - nextBuffer;
+                    target->initialize(input.resolution());
+                }
+            }
+
+            if (fused.empty()) {
+                m_stages[index]->process(*current, *target);
+            } else {
+                applyPointwise(*current, *target, fused);
+            }
+
+            current = target;
+            scratch = target;
+            index += count;
+        }
+    }
+
+    std::string toString() const override {
+        std::string stages;
+        for (const auto &stage : m_stages)
+            stages += "\n" + indent(stage) + ",";
+        return tfm::format(
+            "Pipeline[\n"
+            "  input = %s,\n"
+            "  stages = [%s\n"
+            "  ]\n"
+            "]",
+            indent(m_input),
+            indent(stages)
+        );
+    }
+};
+
+}
+
+REGISTER_POSTPROCESS(Pipeline, "pipeline")
@@ -0,0 +1,45 @@
+#include <lightwave.hpp>
+
+namespace lightwave {
+
+/**
+ * @brief Encodes a linear image with the sRGB transfer function and quantizes it to a given number of bits per
+ * channel (8 by default), as is done when displaying the image or storing it in an 8-bit format.
+ * Values outside of [0,1] are clamped. The result is no longer linear, so this is usually the last stage of a pipeline.
+ */
+class SrgbQuantize : public Postprocess {
+    int m_bits;
+    float m_levels;
+
+    static float encode(float linear) {
+        linear = std::clamp(linear, 0.0f, 1.0f);
+        return linear <= 0.0031308f ? 12.92f * linear : 1.055f * std::pow(linear, 1 / 2.4f) - 0.055f;
+    }
+
+public:
+    SrgbQuantize(const Properties &properties)
+    : Postprocess(properties) {
+        m_bits = properties.get<int>("bits", 8);
+        if (m_bits < 1 || m_bits > 24) {
+            lightwave_throw("sRGB quantization only supports between 1 and 24 bits per channel");
+        }
+        m_levels = float((1 << m_bits) - 1);
+    }
+
+    bool isPointwise() const override { return true; }
+
+    void apply(Color *pixels, int count) const override {
+        for (int i = 0; i < count; i++) {
+            for (int channel = 0; channel < Color::NumComponents; channel++)
+                pixels[i][channel] = std::round(encode(pixels[i][channel]) * m_levels) / m_levels;
+        }
+    }
+
+    std::string toString() const override {
+        return tfm::format("SrgbQuantize[ bits = %d ]", m_bits);
+    }
+};
+
+}
+
+REGISTER_POSTPROCESS(SrgbQuantize, "srgb")
@@ -2,54 +2,147 @@
 
 namespace lightwave {
 
+/**
+ * @brief Compresses the dynamic range of an image to [0,1] with one of several operators:
+ * - @c drago (default): The logarithmic mapping of Drago et al., adapted to the brightest pixel of the image. The
+ *   @c bias controls the contrast, where 0.5 is similar to the extended Reinhard operator.
+ * - @c reinhard : The extended Reinhard operator, which maps the luminance @c white (by default, the brightest pixel
+ *   of the image) to one.
+ * - @c aces : The fit of the ACES filmic curve by Narkowicz, applied to each channel.
+ *
+ * Luminances are processed in batches by branch-free loops using @ref fast_log2 and @ref fast_exp2 , which lets
+ * compilers vectorize the kernels.
+ */
 class ToneMapping : public Postprocess {
 private:
+    enum Operator {
+        EDrago,
+        EReinhard,
+        EAces,
+    };
+
+    /// @brief The number of pixels processed at once, which keeps the luminances and scales of a batch in L1 cache.
+    static constexpr int BatchSize = 256;
+
+    Operator m_operator;
     float m_bias;
     float m_factor;
+    /// @brief The luminance mapped to one by the Reinhard operator, or zero to use the brightest pixel.
+    float m_white;
+
+    /// @brief The luminance of the brightest pixel of the image that is being processed.
+    float m_maxLuminance = 0;
+    /// @brief The normalization of the Drago operator, i.e., @code 1 / log10(1 + maxLuminance) @endcode .
+    float m_dragoScale = 0;
+    /// @brief The inverse squared white point of the Reinhard operator.
+    float m_invWhite2 = 0;
+
+    /// @brief Computes the factors that scale pixels of given luminance to their tone mapped luminance.
+    void dragoScales(const float *luminance, float *scales, int count) const {
+        // members are copied to locals, as compilers cannot rule out that they alias the output
+        const float invMaxLuminance = 1 / m_maxLuminance;
+        const float dragoScale = m_dragoScale;
+        const float factor = m_factor;
+        for (int i = 0; i < count; i++) {
+            // black pixels stay black, and are replaced by a positive value to keep the logarithms finite
+            const float l = std::max(luminance[i], 1e-20f);
+            // the ratio of two logarithms does not depend on their base
+            const float numerator = fast_log2(1 + l);
+            const float denominator = fast_log2(2 + 8 * fast_pow(l * invMaxLuminance, factor));
+            const float scale = dragoScale * numerator / (denominator * l);
+            scales[i] = float(luminance[i] > 0) * scale;
+        }
+    }
+
+    /// @brief Computes the factors that scale pixels of given luminance to their tone mapped luminance.
+    void reinhardScales(const float *luminance, float *scales, int count) const {
+        const float invWhite2 = m_invWhite2;
+        for (int i = 0; i < count; i++) {
+            const float l = std::max(luminance[i], 0.0f);
+            scales[i] = (1 + l * invWhite2) / (1 + l);
+        }
+    }
+
+    /// @brief Scales pixels by factors that only depend on their luminance, computed for a batch of pixels at a time.
+    template <typename F> static void scaleByLuminance(Color *pixels, int count, F &&computeScales) {
+        float luminance[BatchSize];
+        float scales[BatchSize];
+        for (int start = 0; start < count; start += BatchSize) {
+            const int batch = std::min(BatchSize, count - start);
+            for (int i = 0; i < batch; i++)
+                luminance[i] = pixels[start + i].luminance();
+            computeScales(luminance, scales, batch);
+            for (int i = 0; i < batch; i++)
+                pixels[start + i] *= scales[i];
+        }
+    }
+
+    static float aces(float x) {
+        x = std::max(x, 0.0f);
+        return std::min((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f), 1.0f);
+    }
 
 public:
     explicit ToneMapping(const Properties& properties) : Postprocess(properties) {
+        m_operator = properties.getEnum<Operator>("operator", EDrago, {
+            { "drago", EDrago },
+            { "reinhard", EReinhard },
+            { "aces", EAces },
+        });
         m_bias = properties.get<float>("bias", 0.1f);
         m_factor = log10f(m_bias) / log10f(0.5f);
+        m_white = properties.get<float>("white", 0.0f);
+        // a fixed white point does not need statistics, hence prepare is not called for it
+        m_invWhite2 = m_white > 0 ? 1 / sqr(m_white) : 0;
     }
 
-    void execute() override {
+    bool isPointwise() const override { return true; }
+    bool needsStatistics() const override { return m_operator == EDrago || (m_operator == EReinhard && m_white <= 0); }
 
-        m_output->initialize(m_input->resolution());
+    void prepare(const ImageStatistics &statistics) override {
+        m_maxLuminance = statistics.maxLuminance;
+        m_dragoScale = m_maxLuminance > 0 ? 1.0f / log10f(1.0f + m_maxLuminance) : 0;
+        if (m_white <= 0) {
+            m_invWhite2 = m_maxLuminance > 0 ? 1 / sqr(m_maxLuminance) : 0;
+        }
+    }
 
-        float max_l = 0.0f;
-        for (const auto pixel: m_input->bounds()) {
-            if (m_input->get(pixel).luminance() > max_l) {
-                max_l = m_input->get(pixel).luminance();
+    void apply(Color *pixels, int count) const override {
+        if (m_operator == EAces) {
+            for (int i = 0; i < count; i++) {
+                for (int channel = 0; channel < Color::NumComponents; channel++)
+                    pixels[i][channel] = aces(pixels[i][channel]);
             }
+            return;
         }
 
-        for (const auto pixel: m_input->bounds()) {
-            const float l = m_input->get(pixel).luminance();
-
-            //This is the most basic Reinhard method
-            //const float l_new = l / (1.0f + l);
-
-            //This is the extended Reinhard, which works the best at the moment
-            //const float numerator = l * (1.0f + l / sqr(max_l));
-            //const float l_new = numerator / (1.0f + l);
-
-            //We can use the below method by Drago et al. to choose the degree of contrast we want, by varying the bias.
-            //Bias 0.5 is similar to tone mapping with extended Reinhard
-            const float p1 = 1.0f / log10f(1.0f + max_l);
-            const float p2 = log10f(1.0f + l);
-            const float p3 = log10f(2.0f + 8.0f * powf(l / max_l, m_factor));
-            const float l_new = p1 * (p2 / p3);
-
-            m_output->get(pixel) = m_input->get(pixel) * (l_new / l);
+        if (m_operator == EDrago && m_maxLuminance <= 0) {
+            // the image is black
+            return;
         }
 
-        m_output->save();
-        std::cout << "Tone Mapped Image is generated with Drago et. al's method" << std::endl;
+        if (m_operator == EDrago) {
+            scaleByLuminance(pixels, count, [this](const float *luminance, float *scales, int batch) {
+                dragoScales(luminance, scales, batch);
+            });
+        } else {
+            scaleByLuminance(pixels, count, [this](const float *luminance, float *scales, int batch) {
+                reinhardScales(luminance, scales, batch);
+            });
+        }
     }
 
     std::string toString() const override {
-        return tfm::format("ToneMapping[]");
+        return tfm::format(
+            "ToneMapping[\n"
+            "  operator = %s,\n"
+            "  bias = %f,\n"
+            "  white = %f\n"
+            "]",
+            m_operator == EDrago ? "drago" : m_operator == EReinhard ? "reinhard" : "aces",
+            m_bias,
+            m_white
+        );
     }
 };
 
@@ -0,0 +1,106 @@
+#include <lightwave.hpp>
+
+#include "hash.hpp"
+#include "pcg32.h"
+
+#include <array>
+
+namespace lightwave {
+
+/// @brief The bases used for the individual dimensions of the Halton sequence.
+static constexpr std::array<uint32_t, 32> HaltonPrimes = {
+    2,  3,  5,  7,  11, 13, 17, 19, 23, 29, 31, 37,  41,  43,  47,  53,
+    59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+};
+
+/**
+ * @brief Mirrors the digits of @c index in the given base around the decimal point, while randomly shifting each
+ * digit by an amount that depends on all less significant digits of the index (a nested random digit shift).
+ * This randomizes the sequence without destroying its stratification, similar to Owen scrambling.
+ * Since the shifts also apply to leading zeros, digits are generated until the result is accurate to float precision.
+ */
+static inline float scrambledRadicalInverse(uint32_t base, uint32_t index, uint32_t seed) {
+    const double invBase = 1.0 / base;
+    uint64_t reversed    = 0;
+    double invBaseN      = 1;
+    while (invBaseN > 0x1p-24) {
+        const uint32_t next  = index / base;
+        const uint32_t digit = index - next * base;
+        const uint32_t shift = hashCombine(seed, uint32_t(reversed)) % base;
+        reversed             = reversed * base + (digit + shift) % base;
+        invBaseN *= invBase;
+        index = next;
+    }
+    return std::min(float(reversed * invBaseN), 0x1.fffffep-1f);
+}
+
+/**
+ * @brief A low discrepancy sampler based on the Halton sequence, with one prime base per dimension.
+ * Pixels are decorrelated by scrambling the digits of each dimension with a seed derived from the pixel.
+ * Dimensions beyond the supported number of bases fall back to independent random numbers.
+ */
+class Halton final : public Sampler {
+    uint32_t m_seed;
+    /// @brief The seed of the current pixel, from which the scrambling of the individual dimensions is derived.
+    uint32_t m_pixelSeed;
+    /// @brief The index of the current sample within the pixel.
+    uint32_t m_index;
+    /// @brief The next dimension that will be generated.
+    uint32_t m_dimension;
+    /// @brief Used for dimensions that exceed the number of supported bases.
+    pcg32 m_pcg;
+
+    float sample(uint32_t dimension) {
+        if (dimension >= HaltonPrimes.size())
+            return m_pcg.nextFloat();
+
+        return scrambledRadicalInverse(HaltonPrimes[dimension], m_index,
+                                       hashCombine(m_pixelSeed, dimension));
+    }
+
+    void reset(uint32_t pixelSeed, int sampleIndex) {
+        m_pixelSeed = pixelSeed;
+        m_index     = sampleIndex;
+        m_dimension = 0;
+        m_pcg.seed(pixelSeed, sampleIndex);
+    }
+
+protected:
+    /// @brief Generates a single pair of dimensions, since blocks are discarded at the end of each sample.
+    int generate(float *values) override {
+        values[0] = sample(m_dimension++);
+        values[1] = sample(m_dimension++);
+        return 2;
+    }
+
+    void reseed(int sampleIndex) override {
+        reset(hashMix(m_seed), sampleIndex);
+    }
+
+    void reseed(const Point2i &pixel, int sampleIndex) override {
+        reset(hashCombine(hashCombine(hashMix(m_seed), pixel.x()), pixel.y()), sampleIndex);
+    }
+
+public:
+    Halton(const Properties &properties)
+    : Sampler(properties) {
+        m_seed = properties.get<int>("seed", 1337);
+    }
+
+    ref<Sampler> clone() const override {
+        return std::make_shared<Halton>(*this);
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "Halton[\n"
+            "  count = %d\n"
+            "]",
+            m_samplesPerPixel
+        );
+    }
+};
+
+}
+
+REGISTER_SAMPLER(Halton, "halton")
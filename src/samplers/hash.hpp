@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lightwave {
+
+/// @brief Mixes the bits of a 32 bit integer (a low-bias integer hash, see "Hash Prospector" by Chris Wellons).
+inline uint32_t hashMix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+/// @brief Combines a seed with another value, e.g., to derive a seed per pixel or per dimension.
+inline uint32_t hashCombine(uint32_t seed, uint32_t value) {
+    return hashMix(seed ^ (value + 0x9e3779b9U + (seed << 6) + (seed >> 2)));
+}
+
+/// @brief Maps a 32 bit integer to a float in [0,1), keeping only as many bits as a float can represent exactly.
+inline float uintToUnitFloat(uint32_t x) {
+    return float(x >> 8) * 0x1p-24f;
+}
+
+}
@@ -1,5 +1,6 @@
 #include <lightwave.hpp>
 
+#include <bit>
 #include <functional>
 #include "pcg32.h"
 
@@ -12,28 +13,66 @@ namespace lightwave {
  * jittered sampling or blue noise sampling).
  * @see Internally, this sampler uses the PCG32 library to generate random numbers.
  */
-class Independent : public Sampler {
+class Independent final : public Sampler {
     uint64_t m_seed;
     pcg32 m_pcg;
 
-public:
-    Independent(const Properties &properties)
-    : Sampler(properties) {
-        m_seed = properties.get<int>("seed", 1337);
+    /// @brief The number of PCG32 streams that are advanced in lock-step when generating a block.
+    static constexpr int Lanes = 8;
+
+protected:
+    /**
+     * Fills an entire block by running several PCG32 streams in lock-step, where lane @c i starts @c i steps ahead of
+     * the scalar generator and every lane jumps @c Lanes steps at once. This yields exactly the sequence of the scalar
+     * generator, but breaks the serial dependency between consecutive numbers so that the compiler can vectorize the
+     * loop.
+     */
+    int generate(float *values) override {
+        static_assert(MaxBlockSize % Lanes == 0);
+
+        uint64_t states[Lanes];
+        states[0] = m_pcg.state;
+        for (int lane = 1; lane < Lanes; lane++)
+            states[lane] = states[lane - 1] * PCG32_MULT + m_pcg.inc;
+
+        // the affine map that advances a state by Lanes steps (see pcg32::advance)
+        uint64_t jumpMult = 1u, jumpPlus = 0u;
+        for (int lane = 0; lane < Lanes; lane++) {
+            jumpMult *= PCG32_MULT;
+            jumpPlus = jumpPlus * PCG32_MULT + m_pcg.inc;
+        }
+
+        for (int i = 0; i < MaxBlockSize; i += Lanes) {
+            for (int lane = 0; lane < Lanes; lane++) {
+                const uint64_t state = states[lane];
+                const uint32_t xorshifted =
+                    (uint32_t) (((state >> 18u) ^ state) >> 27u);
+                const uint32_t rot = (uint32_t) (state >> 59u);
+                const uint32_t bits =
+                    (xorshifted >> rot) | (xorshifted << ((~rot + 1u) & 31));
+                values[i + lane] = std::bit_cast<float>((bits >> 9) | 0x3f800000u) - 1.0f;
+                states[lane] = state * jumpMult + jumpPlus;
+            }
+        }
+
+        m_pcg.state = states[0];
+        return MaxBlockSize;
     }
 
-    void seed(int sampleIndex) override {
+    void reseed(int sampleIndex) override {
         m_pcg.seed(m_seed, sampleIndex);
     }
 
-    void seed(const Point2i &pixel, int sampleIndex) override {
+    void reseed(const Point2i &pixel, int sampleIndex) override {
         const uint64_t a = (uint64_t(pixel.x()) << 32) ^ pixel.y();
         m_pcg.seed(m_seed, a);
         m_pcg.seed(m_pcg.nextUInt(), sampleIndex);
     }
 
-    float next() override {
-        return m_pcg.nextFloat();
+public:
+    Independent(const Properties &properties)
+    : Sampler(properties) {
+        m_seed = properties.get<int>("seed", 1337);
     }
 
     ref<Sampler> clone() const override {
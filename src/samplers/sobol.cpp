@@ -0,0 +1,143 @@
+#include <lightwave.hpp>
+
+#include "hash.hpp"
+
+#include <array>
+
+namespace lightwave {
+
+/**
+ * @brief Lookup tables for the second Sobol dimension, one per byte of the index.
+ * Since the generator matrix is applied by XOR-ing the direction numbers of all set bits, the contributions of the
+ * individual bytes can be precomputed, which avoids a hard to predict branch per bit.
+ */
+static constexpr std::array<std::array<uint32_t, 256>, 4> SobolTables = [] {
+    std::array<uint32_t, 32> directions {};
+    directions[0] = 1U << 31;
+    for (int i = 1; i < 32; i++)
+        directions[i] = directions[i - 1] ^ (directions[i - 1] >> 1);
+
+    std::array<std::array<uint32_t, 256>, 4> tables {};
+    for (int byte = 0; byte < 4; byte++) {
+        for (int value = 0; value < 256; value++) {
+            for (int bit = 0; bit < 8; bit++) {
+                if (value & (1 << bit))
+                    tables[byte][value] ^= directions[8 * byte + bit];
+            }
+        }
+    }
+    return tables;
+}();
+
+static inline uint32_t reverseBits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+    x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fU) | ((x & 0x0f0f0f0fU) << 4);
+    x = ((x >> 8) & 0x00ff00ffU) | ((x & 0x00ff00ffU) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+/**
+ * @brief A hash-based approximation of a random permutation that only lets bits influence higher bits.
+ * @see "Stratified Sampling for Stochastic Transparency" (Laine and Karras, 2011), with the improved constants from
+ * "Practical Hash-based Owen Scrambling" (Burley, 2020).
+ */
+static inline uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cU;
+    x ^= x * 0xb82f1e52U;
+    x ^= x * 0xc7afe638U;
+    x ^= x * 0x8d22f6e6U;
+    return x;
+}
+
+/// @brief Owen scrambling of a 32 bit fixed point number, i.e., a permutation where each bit only depends on higher bits.
+static inline uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) {
+    return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+}
+
+/// @brief Generates the second dimension of the Sobol sequence (the first one is just the reversed index).
+static inline uint32_t sobolSecondDimension(uint32_t index) {
+    return SobolTables[0][index & 0xff] ^ SobolTables[1][(index >> 8) & 0xff] ^
+           SobolTables[2][(index >> 16) & 0xff] ^ SobolTables[3][index >> 24];
+}
+
+/**
+ * @brief A low discrepancy sampler based on the Owen-scrambled Sobol sequence.
+ * Each pair of dimensions is drawn from the (well stratified) first two Sobol dimensions, which are decorrelated from
+ * other pairs by shuffling the sample index and scrambling the points with seeds derived from the pixel and the
+ * dimension (i.e., "padding").
+ * Sample counts that are powers of two give the best results.
+ * @see "Practical Hash-based Owen Scrambling" (Burley, 2020)
+ */
+class Sobol final : public Sampler {
+    uint32_t m_seed;
+    /// @brief The seed of the current pixel, from which the seeds of the individual dimensions are derived.
+    uint32_t m_pixelSeed;
+    /// @brief The index of the current sample within the pixel.
+    uint32_t m_index;
+    /// @brief The next pair of dimensions that will be generated.
+    uint32_t m_dimension;
+
+    /// @brief Returns the shuffled sample index and the seed used to scramble the points of the given dimension.
+    uint32_t shuffledIndex(uint32_t dimension, uint32_t &dimensionSeed) const {
+        dimensionSeed = hashCombine(m_pixelSeed, dimension);
+        return nestedUniformScramble(m_index, dimensionSeed);
+    }
+
+    /// @brief Computes the first dimension of the scrambled point (since the first Sobol dimension is the reversed
+    /// index, the scrambling simplifies to a single permutation of the index).
+    static float first(uint32_t shuffled, uint32_t dimensionSeed) {
+        return uintToUnitFloat(reverseBits(laineKarrasPermutation(shuffled, hashMix(dimensionSeed + 1))));
+    }
+
+    static float second(uint32_t shuffled, uint32_t dimensionSeed) {
+        return uintToUnitFloat(nestedUniformScramble(sobolSecondDimension(shuffled), hashMix(dimensionSeed + 2)));
+    }
+
+protected:
+    /// @brief Generates a single (stratified) pair of dimensions, since blocks are discarded at the end of each sample.
+    int generate(float *values) override {
+        uint32_t dimensionSeed;
+        const uint32_t shuffled = shuffledIndex(m_dimension++, dimensionSeed);
+        values[0] = first(shuffled, dimensionSeed);
+        values[1] = second(shuffled, dimensionSeed);
+        return 2;
+    }
+
+    void reseed(int sampleIndex) override {
+        m_pixelSeed = hashMix(m_seed);
+        m_index     = sampleIndex;
+        m_dimension = 0;
+    }
+
+    void reseed(const Point2i &pixel, int sampleIndex) override {
+        m_pixelSeed = hashCombine(hashCombine(hashMix(m_seed), pixel.x()), pixel.y());
+        m_index     = sampleIndex;
+        m_dimension = 0;
+    }
+
+public:
+    Sobol(const Properties &properties)
+    : Sampler(properties) {
+        m_seed = properties.get<int>("seed", 1337);
+        m_stratifiesPairs = true;
+    }
+
+    ref<Sampler> clone() const override {
+        return std::make_shared<Sobol>(*this);
+    }
+
+    std::string toString() const override {
+        return tfm::format(
+            "Sobol[\n"
+            "  count = %d\n"
+            "]",
+            m_samplesPerPixel
+        );
+    }
+};
+
+}
+
+REGISTER_SAMPLER(Sobol, "sobol")
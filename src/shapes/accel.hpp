@@ -3,6 +3,7 @@
 #include <lightwave/core.hpp>
 #include <lightwave/math.hpp>
 #include <lightwave/shape.hpp>
+#include <lightwave/telemetry.hpp>
 
 #include <numeric>
 
@@ -357,6 +358,7 @@ protected:
     /// @brief Builds the acceleration structure.
     void buildAccelerationStructure() {
         Timer buildTimer;
+        Telemetry::ScopedTimer timer{ Telemetry::EBvhBuild };
 
         // fill primitive indices with 0 to primitiveCount - 1
         m_primitiveIndices.resize(numberOfPrimitives());
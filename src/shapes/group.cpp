@@ -11,6 +11,13 @@ namespace lightwave {
  */
 class Group final : public AccelerationStructure {
     std::vector<ref<Shape>> m_children;
+    /**
+     * @brief Whether this group is the root of the scene geometry (see @ref markAsSceneRoot ).
+     * Other groups can be wrapped by area lights, hence their intersections report the density of @ref sampleArea
+     * picking the hit child, which area lights need to weight hits using multiple importance sampling. The root group
+     * leaves the densities of its children untouched, since each of them is wrapped by its own area light.
+     */
+    bool m_isSceneRoot = false;
 
 protected:
     int numberOfPrimitives() const override {
@@ -18,7 +25,11 @@ protected:
     }
 
     bool intersect(int primitiveIndex, const Ray &ray, Intersection &its, Sampler &rng) const override {
-        return m_children[primitiveIndex]->intersect(ray, its, rng);
+        if (!m_children[primitiveIndex]->intersect(ray, its, rng))
+            return false;
+        if (!m_isSceneRoot)
+            its.pdf /= m_children.size();
+        return true;
     }
 
     Bounds getBoundingBox(int primitiveIndex) const override {
@@ -39,12 +50,17 @@ public:
         for (auto &child : m_children) child->markAsVisible();
     }
 
+    void markAsSceneRoot() override {
+        m_isSceneRoot = true;
+    }
+
     AreaSample sampleArea(Sampler &rng) const override {
         int childIndex = int(rng.next() * m_children.size());
         childIndex = std::min(childIndex, int(m_children.size()) - 1);
 
         AreaSample sample = m_children[childIndex]->sampleArea(rng);
-        sample.pdf /= m_children.size();
+        if (!m_isSceneRoot)
+            sample.pdf /= m_children.size();
         return sample;
     }
 
@@ -29,10 +29,64 @@ private:
     std::filesystem::path m_originalPath;
     /// @brief Whether to interpolate the normals from m_vertices, or report the geometric normal instead.
     bool m_smoothNormals;
+    /// @brief Picks triangles proportional to their surface area for @ref sampleArea .
+    AliasTable m_areaDistribution;
+    /// @brief The density of uniformly sampling a point on the surface of the mesh, i.e., one over its surface area.
+    float m_areaPdf;
     /// @brief Used to avoid self-intersections and other Möller-Trumbore artifacts
     static constexpr float SmallerEpsilon = 1e-8f;
     static constexpr float LargerEpsilon = 1e-4f;
 
+    /// @brief Returns the surface area of the given triangle.
+    float triangleArea(int primitiveIndex) const {
+        const Vector3i indices = m_triangles[primitiveIndex];
+        const Point v0 = m_vertices[indices.x()].position;
+        const Point v1 = m_vertices[indices.y()].position;
+        const Point v2 = m_vertices[indices.z()].position;
+        return (v1 - v0).cross(v2 - v0).length() / 2;
+    }
+
+    /**
+     * @brief Populates the surface event with position, texture coordinates, shading frame and area pdf for the given
+     * barycentric coordinates on a triangle (shared by intersection and area sampling).
+     */
+    void populate(SurfaceEvent& surf, int primitiveIndex, const Vector2& bary) const {
+        const Vector3i indices = m_triangles[primitiveIndex];
+        const Vertex v0 = m_vertices[indices.x()];
+        const Vertex v1 = m_vertices[indices.y()];
+        const Vertex v2 = m_vertices[indices.z()];
+        const Vertex interpolatedVertex = Vertex::interpolate(bary, v0, v1, v2);
+
+        surf.uv = interpolatedVertex.texcoords;
+        surf.position = interpolatedVertex.position;
+
+        const Vector normal = m_smoothNormals
+                              ? interpolatedVertex.normal.normalized()
+                              : (v1.position - v0.position).cross(v2.position - v0.position).normalized();
+        surf.frame = Frame(normal);
+        surf.pdf = m_areaPdf;
+        if (!Texture::anyUsesFootprint()) {
+            // the derivatives are only needed to filter textures over the footprint of rays
+            return;
+        }
+
+        // the derivatives of the position with respect to the texture coordinates are constant across the triangle,
+        // and are found by solving p0 - p2 = du02 * dpdu + dv02 * dpdv (and likewise for p1 - p2)
+        const Vector2 duv02 = v0.texcoords - v2.texcoords;
+        const Vector2 duv12 = v1.texcoords - v2.texcoords;
+        const float determinant = duv02.x() * duv12.y() - duv02.y() * duv12.x();
+        if (std::abs(determinant) > 1e-12f) {
+            const Vector dp02 = v0.position - v2.position;
+            const Vector dp12 = v1.position - v2.position;
+            surf.dpdu = (duv12.y() * dp02 - duv02.y() * dp12) / determinant;
+            surf.dpdv = (duv02.x() * dp12 - duv12.x() * dp02) / determinant;
+        } else {
+            // the triangle has no (or degenerate) texture coordinates
+            surf.dpdu = Vector(0);
+            surf.dpdv = Vector(0);
+        }
+    }
+
 protected:
     int numberOfPrimitives() const override {
         return int(m_triangles.size());
@@ -77,21 +131,17 @@ protected:
             return false;
         }
 
-        const Vertex interpolatedVertex = Vertex::interpolate({u, v}, v0V, v1V, v2V);
-
         // If the primitive has an alpha mask, we need to check whether the coordinate is transparent
-        if (its.alphaMask && its.alphaMask->scalar(interpolatedVertex.texcoords) < rng.next()) {
-            return false;
+        if (its.alphaMask) {
+            const Vector2 texcoords = interpolateBarycentric({u, v}, v0V.texcoords, v1V.texcoords, v2V.texcoords);
+            its.stats.alphaCounter++;
+            if (its.alphaMask->scalar(texcoords) < rng.next()) {
+                return false;
+            }
         }
 
         its.t = t;
-        its.uv = interpolatedVertex.texcoords;
-        its.position = interpolatedVertex.position;
-
-        const Vector normal = m_smoothNormals
-                              ? interpolatedVertex.normal.normalized()
-                              : v0v1.cross(v0v2).normalized();
-        its.frame = Frame(normal);
+        populate(its, primitiveIndex, {u, v});
 
         return true;
     }
@@ -127,11 +177,32 @@ public:
                m_vertices.size()
         );
         buildAccelerationStructure();
+
+        std::vector<float> areas(m_triangles.size());
+        for (int i = 0; i < int(m_triangles.size()); i++) {
+            areas[i] = triangleArea(i);
+        }
+        m_areaDistribution.build(areas);
+        m_areaPdf = m_areaDistribution.empty() ? 0 : 1 / m_areaDistribution.total();
     }
 
+    /**
+     * Picks a triangle proportional to its area in constant time and a uniformly distributed point on it, hence all
+     * points on the mesh are sampled with the same density.
+     */
     AreaSample sampleArea(Sampler& rng) const override {
-        // only implement this if you need triangle mesh area light sampling for your rendering competition
-        NOT_IMPLEMENTED
+        if (m_areaDistribution.empty()) {
+            return AreaSample::invalid();
+        }
+
+        // meshes can consist of millions of triangles, hence separate random numbers are needed for the alias table
+        const Point2 selection = rng.next2D();
+        const int primitiveIndex = m_areaDistribution.sample(selection.x(), selection.y());
+        const Point2 bary = squareToUniformTriangle(rng.next2D());
+
+        AreaSample sample;
+        populate(sample, primitiveIndex, {bary.x(), bary.y()});
+        return sample;
     }
 
     std::string toString() const override {
@@ -19,6 +19,9 @@ private:
         // map the position from [-1,-1,0]..[+1,+1,0] to [0,0]..[1,1] by discarding the z component and rescaling
         surf.uv.x() = (position.x() + 1) * 0.5f;
         surf.uv.y() = (position.y() + 1) * 0.5f;
+        // and accordingly, a unit step in texture space spans the whole side length of 2
+        surf.dpdu = Vector(2, 0, 0);
+        surf.dpdv = Vector(0, 2, 0);
 
         // the tangent always points in positive x direction
         surf.frame.tangent = Vector(1, 0, 0);
@@ -61,6 +64,7 @@ public:
         // If the primitive has an alpha mask, we need to check whether the coordinate is transparent
         if (its.alphaMask) {
             const Point2 uv = {(position.x() + 1.0f) * 0.5f, (position.y() + 1.0f) * 0.5f};
+            its.stats.alphaCounter++;
             if (its.alphaMask->scalar(uv) < rng.next()) {
                 return false;
             }
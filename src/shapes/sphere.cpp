@@ -6,6 +6,28 @@ namespace lightwave {
  */
 class Sphere : public Shape {
 private:
+    /**
+     * Sets the derivatives of the position with respect to the texture coordinates for a point on the sphere, where u
+     * is proportional to the azimuth angle around the y axis and v to the polar angle from the y axis.
+     */
+    static void setDerivatives(SurfaceEvent& surf, const Vector& normal) {
+        if (!Texture::anyUsesFootprint()) {
+            // the derivatives are only needed to filter textures over the footprint of rays
+            return;
+        }
+
+        const float sinTheta = std::sqrt(sqr(normal.x()) + sqr(normal.z()));
+        if (sinTheta < 1e-6f) {
+            // the texture coordinates are singular at the poles
+            surf.dpdu = Vector(0);
+            surf.dpdv = Vector(0);
+            return;
+        }
+        const float cosTheta = normal.y();
+        surf.dpdu = 2 * Pi * Vector(normal.z(), 0, -normal.x());
+        surf.dpdv = Pi * Vector(cosTheta * normal.x() / sinTheta, -sinTheta, cosTheta * normal.z() / sinTheta);
+    }
+
     /**
      * Checks whether the given ray distance could lead to a valid intersection, and if so, checks the value of the
      * alpha mask at that position. alpha=0 means the ray always passes through and there is no intersection,
@@ -25,6 +47,7 @@ private:
                 acosf(normal.y()) * InvPi + 0.5f
         };
 
+        its.stats.alphaCounter++;
         if (its.alphaMask->scalar(uv) < rng.next()) {
             return false;
         }
@@ -33,6 +56,7 @@ private:
         its.position = normal; // normalizing ensures the point is on the surface of the sphere
         its.frame = Frame(normal);
         its.uv = uv;
+        setDerivatives(its, normal);
 
         // Since we sample the area uniformly, the pdf is given by 1/surfaceArea
         its.pdf = Inv4Pi;
@@ -55,6 +79,7 @@ private:
                 atan2f(normal.x(), normal.z()) * Inv2Pi + 0.5f,
                 acosf(normal.y()) * InvPi + 0.5f
         };
+        setDerivatives(surf, normal);
 
         // Since we sample the area uniformly, the pdf is given by 1/surfaceArea
         surf.pdf = Inv4Pi;
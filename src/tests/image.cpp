@@ -3,7 +3,7 @@
 namespace lightwave {
 
 /**
- * @brief Tests whether the output of an integrator matches a given reference image.
+ * @brief Tests whether the output of an integrator (or of a postprocess) matches a given reference image.
  * 
  * Paired with different integrators, this can be used to test nearly all aspects of your renderer:
  * For example, with a normal integrator (which returns the normal vector at the first intersection),
@@ -11,10 +11,15 @@ namespace lightwave {
  * 
  * @note Internally, this computes the mean absolute error (MAE) of the image and compares it against
  * a specified threshold.
+ * With @c aov set, an AOV recorded by the film of the integrator is compared instead of the rendered image.
  */
 class CompareImage : public Test {
     /// @brief The integrator to execute and compare against a reference image.
     ref<SamplingIntegrator> m_integrator;
+    /// @brief The postprocess to execute and compare against a reference image (instead of an integrator).
+    ref<Postprocess> m_postprocess;
+    /// @brief The name of the AOV of the integrator to compare, or empty to compare the output image.
+    std::string m_aov;
     /// @brief The directory the resulting image should be stored to.
     std::filesystem::path m_basePath;
     /// @brief The threshold to compare the MAE (mean absolute error) against.
@@ -26,7 +31,15 @@ class CompareImage : public Test {
 
 public:
     CompareImage(const Properties &properties) {
-        m_integrator = properties.getChild<SamplingIntegrator>();
+        m_integrator = properties.getOptionalChild<SamplingIntegrator>();
+        m_postprocess = properties.getOptionalChild<Postprocess>();
+        if (!m_integrator == !m_postprocess) {
+            lightwave_throw("<test type=\"image\" /> needs either an <integrator /> or a <postprocess /> child");
+        }
+        m_aov = properties.get<std::string>("aov", "");
+        if (!m_aov.empty() && !m_integrator) {
+            lightwave_throw("<test type=\"image\" /> can only compare AOVs of an <integrator />");
+        }
         m_thresholdMAE = properties.get<float>("mae", 1e-1);
         m_thresholdME = properties.get<float>("me", 2e-4);
         m_basePath = properties.basePath(); // we store the test image in the same folder as the scene file
@@ -39,8 +52,16 @@ public:
         ref<Image> image = std::make_shared<Image>();
         image->setBasePath(m_basePath);
         image->setId(id() + "_test");
-        m_integrator->setImage(image);
-        m_integrator->execute();
+        if (m_integrator) {
+            m_integrator->setImage(image);
+            m_integrator->execute();
+        } else {
+            m_postprocess->setOutput(image);
+            m_postprocess->execute();
+        }
+        if (!m_aov.empty()) {
+            image = findAov();
+        }
 
         if (std::getenv("reference")) {
             image->saveAt(referencePath);
@@ -61,6 +82,14 @@ public:
     }
 
 private:
+    ref<Image> findAov() const {
+        for (const auto &aov : m_integrator->film()->aovs()) {
+            if (aov.name == m_aov)
+                return aov.image;
+        }
+        lightwave_throw("the film of the integrator does not record the AOV \"%s\"", m_aov);
+    }
+
     void compare(const Image &image, const Image &reference) const {
         if (image.resolution() != reference.resolution()) {
             lightwave_throw("resolution does not match reference image");
@@ -17,7 +17,7 @@ public:
         m_scale = properties.get<Point2>("scale", Point2(1.0f));
     }
 
-    Color evaluate(const Point2& uv) const override {
+    Color evaluate(const TexCoord& uv) const override {
         const int scaledU = static_cast<int>(floorf(uv.x() * m_scale.x()));
         const int scaledV = static_cast<int>(floorf(uv.y() * m_scale.y()));
 
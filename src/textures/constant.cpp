@@ -11,7 +11,7 @@ public:
         m_value = properties.get<Color>("value");
     }
 
-    Color evaluate(const Point2& uv) const override {
+    Color evaluate(const TexCoord& uv) const override {
         return m_value;
     }
 
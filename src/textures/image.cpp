@@ -1,5 +1,7 @@
 #include <lightwave.hpp>
 
+#include "texels.hpp"
+
 namespace lightwave {
 
 class ImageTexture : public Texture {
@@ -12,21 +14,28 @@ private:
     enum class FilterMode : std::uint8_t {
         Nearest,
         Bilinear,
+        Trilinear,
+        Anisotropic,
     };
 
-    ref<Image> m_image;
+    /**
+     * @brief The pixels of the image, in a compact format unless that would lose precision (see @ref TexelImage ).
+     * For filters that use MIP mapping, this is followed by successively downsampled versions of the image, each of
+     * which has half the resolution of the previous one, down to a single pixel.
+     */
+    std::vector<TexelImage> m_levels;
     float m_exposure;
     BorderMode m_border;
     FilterMode m_filter;
+    /// @brief The maximum ratio between the longer and the shorter axis of the footprint in anisotropic mode.
+    int m_maxAnisotropy;
 
     /**
      * Clamps or wraps the given coordinates according to the image resolution and the selected BorderMode.
      * @param xy a coordinate in the image pixel space, potentially out of image bounds
      * @returns a coordinate in the image pixel space, guaranteed to be inside of the image boundaries.
      */
-    inline Point2i handleBorders(Point2i xy) const {
-        const Point2i resolution = m_image->resolution();
-
+    inline Point2i handleBorders(Point2i xy, const Point2i &resolution) const {
         if (m_border == BorderMode::Clamp) {
             xy.x() = std::clamp(xy.x(), 0, resolution.x() - 1);
             xy.y() = std::clamp(xy.y(), 0, resolution.y() - 1);
@@ -40,9 +49,173 @@ private:
         return xy;
     }
 
+    /**
+     * Builds the MIP pyramid by averaging blocks of 2x2 pixels of the previous level (in linear space), which are
+     * stored in the same texel format as the full resolution image. For odd resolutions, the pixels of the last row
+     * or column are repeated.
+     */
+    void buildPyramid(const Image &image) {
+        Image previous;
+        previous.copy(image);
+        while (previous.resolution().x() > 1 || previous.resolution().y() > 1) {
+            const Point2i resolution = previous.resolution();
+            Image level{ Point2i(std::max(1, (resolution.x() + 1) / 2), std::max(1, (resolution.y() + 1) / 2)) };
+            for (int y = 0; y < level.resolution().y(); y++) {
+                for (int x = 0; x < level.resolution().x(); x++) {
+                    const int x0 = std::min(2 * x, resolution.x() - 1), x1 = std::min(2 * x + 1, resolution.x() - 1);
+                    const int y0 = std::min(2 * y, resolution.y() - 1), y1 = std::min(2 * y + 1, resolution.y() - 1);
+                    level(Point2i(x, y)) = 0.25f * (previous(Point2i(x0, y0)) + previous(Point2i(x1, y0)) +
+                                                    previous(Point2i(x0, y1)) + previous(Point2i(x1, y1)));
+                }
+            }
+            m_levels.emplace_back(level, m_levels.front().format());
+            previous = std::move(level);
+        }
+    }
+
+    /// @brief Looks up the pixel containing the given position (in pixels of the given level).
+    template <typename Texel>
+    Color nearest(const TexelImage &level, const Point2 &uvScaled) const {
+        const Point2i coords = handleBorders({
+                static_cast<int>(floorf(uvScaled.x())),
+                static_cast<int>(floorf(uvScaled.y()))
+        }, level.resolution());
+        return level.texels<Texel>()[coords.y() * level.resolution().x() + coords.x()].decode(level.table());
+    }
+
+    /// @brief Interpolates between the four pixels closest to the given position (in pixels of the given level).
+    template <typename Texel>
+    Color bilinear(const TexelImage &level, Point2 uvScaled) const {
+        const Texel *texels = level.texels<Texel>();
+        const LinearizationTable &table = level.table();
+        const Point2i resolution = level.resolution();
+        const auto fetch = [&](const Point2i &xy) {
+            return texels[xy.y() * resolution.x() + xy.x()].decode(table);
+        };
+
+        // Which four pixels to choose is determined by the proximity of the given uv-coordinate to the center
+        // points of the pixels (which are located at 0.5, 1.5, etc.). Thus, the weights of the 4 colors equal
+        // the distances of the uv coordinate to these values.
+        // We can get them either by subtracting 0.5 and using floor(), or using round() and adding 0.5 in the
+        // weight computation: either way works.
+        uvScaled.x() -= 0.5f;
+        uvScaled.y() -= 0.5f;
+
+        const int xMin = static_cast<int>(floorf(uvScaled.x()));
+        const int xMax = xMin + 1;
+        const int yMin = static_cast<int>(floorf(uvScaled.y()));
+        const int yMax = yMin + 1;
+
+        const float xMaxWeight = uvScaled.x() - static_cast<float>(xMin);
+        const float xMinWeight = 1.0f - xMaxWeight;
+        const float yMaxWeight = uvScaled.y() - static_cast<float>(yMin);
+        const float yMinWeight = 1.0f - yMaxWeight;
+
+        const Point2i minCoords = handleBorders({xMin, yMin}, resolution);
+        const Point2i maxCoords = handleBorders({xMax, yMax}, resolution);
+
+        return xMinWeight * yMinWeight * fetch(minCoords)
+               + xMinWeight * yMaxWeight * fetch({minCoords.x(), maxCoords.y()})
+               + xMaxWeight * yMinWeight * fetch({maxCoords.x(), minCoords.y()})
+               + xMaxWeight * yMaxWeight * fetch(maxCoords);
+    }
+
+    /**
+     * @brief Interpolates bilinear lookups in the two MIP levels closest to the given level of detail, where level 0
+     * is the full resolution image, and each level above it halves the resolution.
+     */
+    template <typename Texel>
+    Color trilinear(const Point2 &uv, float lod) const {
+        const auto lookup = [&](int index) {
+            const TexelImage &level = m_levels[index];
+            return bilinear<Texel>(level, {
+                    uv.x() * static_cast<float>(level.resolution().x()),
+                    (1.0f - uv.y()) * static_cast<float>(level.resolution().y())
+            });
+        };
+
+        const int lastLevel = int(m_levels.size()) - 1;
+        if (!(lod > 0)) {
+            return lookup(0);
+        }
+        if (lod >= float(lastLevel)) {
+            return lookup(lastLevel);
+        }
+        const int lower = int(lod);
+        const float weight = lod - float(lower);
+        return (1 - weight) * lookup(lower) + weight * lookup(lower + 1);
+    }
+
+    /**
+     * @brief Filters the image according to the footprint of the texture coordinates, using the MIP pyramid.
+     * Kept out of @ref evaluate , so that the more common nearest and bilinear lookups stay small.
+     */
+    template <typename Texel>
+    [[gnu::noinline]] Color filterMipMapped(const TexCoord& uv) const {
+        // the lengths of the axes of the footprint in pixels of the full resolution image
+        const Vector2 resolution = Vector2(m_levels.front().resolution().cast<float>());
+        const float xLength = (uv.dx * resolution).length();
+        const float yLength = (uv.dy * resolution).length();
+        if (m_filter == FilterMode::Trilinear) {
+            // The level of detail is chosen such that the longer axis of the footprint spans about one pixel
+            return trilinear<Texel>(uv, std::log2(std::max({ xLength, yLength, 1.0f })));
+        }
+
+        // The level of detail is chosen by the shorter axis of the footprint, and several lookups are spread along its
+        // longer axis (up to the maximum anisotropy, beyond which the image gets blurry instead)
+        const Vector2 &major = xLength >= yLength ? uv.dx : uv.dy;
+        const float majorLength = std::max(xLength, yLength);
+        const float minorLength = std::max(std::min(xLength, yLength), majorLength / float(m_maxAnisotropy));
+        const float lod = std::log2(std::max(minorLength, 1.0f));
+        const int lookups = majorLength > 1 ? int(std::ceil(majorLength / minorLength - 0.01f)) : 1;
+        Color sum = Color::black();
+        for (int lookup = 0; lookup < lookups; lookup++) {
+            const float offset = (float(lookup) + 0.5f) / float(lookups) - 0.5f;
+            sum += trilinear<Texel>(Point2(Vector2(uv) + offset * major), lod);
+        }
+        return sum / float(lookups);
+    }
+
+    /**
+     * @brief Evaluates the texture for images stored with the given texel type.
+     * Not inlined into the dispatching @ref evaluate , as one function holding all formats measured slower.
+     */
+    template <typename Texel>
+    [[gnu::noinline]] Color evaluate(const TexCoord& uv) const {
+        const TexelImage &image = m_levels.front();
+        const Vector2 resolution = Vector2(image.resolution().cast<float>());
+        const Point2 uvScaled = {
+                uv.x() * resolution.x(),
+                (1.0f - uv.y()) * resolution.y()
+        };
+
+        switch (m_filter) {
+            case FilterMode::Nearest:
+                return nearest<Texel>(image, uvScaled) * m_exposure;
+
+            case FilterMode::Bilinear:
+                return bilinear<Texel>(image, uvScaled) * m_exposure;
+
+            case FilterMode::Trilinear:
+            case FilterMode::Anisotropic:
+                return filterMipMapped<Texel>(uv) * m_exposure;
+        }
+        return Color::black();
+    }
+
 public:
     explicit ImageTexture(const Properties& properties) {
-        m_image = properties.has("filename") ? std::make_shared<Image>(properties) : properties.getChild<Image>();
+        const ref<Image> image =
+            properties.has("filename") ? std::make_shared<Image>(properties) : properties.getChild<Image>();
+        // the image itself is no longer needed (unless it is referenced elsewhere) once converted to texels
+        m_levels.emplace_back(*image, properties.getEnum<std::optional<TexelFormat>>("format", std::nullopt, {
+                {"auto",   std::nullopt},
+                {"rgb8",   TexelFormat::RGB8},
+                {"rgba8",  TexelFormat::RGBA8},
+                {"r8",     TexelFormat::R8},
+                {"rgb16f", TexelFormat::RGB16F},
+                {"rgb32f", TexelFormat::RGB32F},
+        }));
         m_exposure = properties.get<float>("exposure", 1.0f);
 
         m_border = properties.getEnum<BorderMode>("border", BorderMode::Repeat, {
@@ -51,9 +224,17 @@ public:
         });
 
         m_filter = properties.getEnum<FilterMode>("filter", FilterMode::Bilinear, {
-                {"nearest",  FilterMode::Nearest},
-                {"bilinear", FilterMode::Bilinear},
+                {"nearest",     FilterMode::Nearest},
+                {"bilinear",    FilterMode::Bilinear},
+                {"trilinear",   FilterMode::Trilinear},
+                {"anisotropic", FilterMode::Anisotropic},
         });
+        m_maxAnisotropy = std::max(1, properties.get<int>("maxAnisotropy", 8));
+
+        if (m_filter == FilterMode::Trilinear || m_filter == FilterMode::Anisotropic) {
+            markUsesFootprint();
+            buildPyramid(*image);
+        }
     }
 
     /**
@@ -64,60 +245,40 @@ public:
      * In nearest neighbor mode, we simply use the coordinate of the pixel which uv maps to.
      * In bilinear filtering mode, we perform simple anti-aliasing by sampling the colors of the 4 pixels surrounding
      * the given uv-coordinate and interpolate its color value from them.
+     * In trilinear and anisotropic mode, the footprint of the texture coordinates selects how much the image is
+     * prefiltered (by looking up downsampled versions of it), which avoids aliasing where the image is minified.
+     * Lookups without footprint (e.g., after diffuse bounces) fall back to bilinear filtering.
+     * Lookups are dispatched to a version of the filtering code that is specialized for the texel format.
      */
-    Color evaluate(const Point2& uv) const override {
-        Point2 uvScaled = {
-                uv.x() * static_cast<float>(m_image->resolution().x()),
-                (1.0f - uv.y()) * static_cast<float>(m_image->resolution().y())
-        };
-
-        switch (m_filter) {
-            case FilterMode::Nearest: {
-                const Point2i coords = {
-                        static_cast<int>(floorf(uvScaled.x())),
-                        static_cast<int>(floorf(uvScaled.y()))
-                };
-                return m_image->get(handleBorders(coords)) * m_exposure;
-            }
-
-            case FilterMode::Bilinear: {
-                // Which four pixels to choose is determined by the proximity of the given uv-coordinate to the center
-                // points of the pixels (which are located at 0.5, 1.5, etc.). Thus, the weights of the 4 colors equal
-                // the distances of the uv coordinate to these values.
-                // We can get them either by subtracting 0.5 and using floor(), or using round() and adding 0.5 in the
-                // weight computation: either way works.
-                uvScaled.x() -= 0.5f;
-                uvScaled.y() -= 0.5f;
-
-                const int xMin = static_cast<int>(floorf(uvScaled.x()));
-                const int xMax = xMin + 1;
-                const int yMin = static_cast<int>(floorf(uvScaled.y()));
-                const int yMax = yMin + 1;
-
-                const float xMaxWeight = uvScaled.x() - static_cast<float>(xMin);
-                const float xMinWeight = 1.0f - xMaxWeight;
-                const float yMaxWeight = uvScaled.y() - static_cast<float>(yMin);
-                const float yMinWeight = 1.0f - yMaxWeight;
-
-                const Point2i minCoords = handleBorders({xMin, yMin});
-                const Point2i maxCoords = handleBorders({xMax, yMax});
-
-                const Color interpolatedColor = xMinWeight * yMinWeight * m_image->get(minCoords)
-                                                + xMinWeight * yMaxWeight * m_image->get({minCoords.x(), maxCoords.y()})
-                                                + xMaxWeight * yMinWeight * m_image->get({maxCoords.x(), minCoords.y()})
-                                                + xMaxWeight * yMaxWeight * m_image->get(maxCoords);
-
-                return interpolatedColor * m_exposure;
-            }
+    Color evaluate(const TexCoord& uv) const override {
+        Telemetry::count(Telemetry::ETextureFetches);
+        switch (m_levels.front().format()) {
+            case TexelFormat::RGB8: return evaluate<TexelRGB8>(uv);
+            case TexelFormat::RGBA8: return evaluate<TexelRGBA8>(uv);
+            case TexelFormat::R8: return evaluate<TexelR8>(uv);
+            case TexelFormat::RGB16F: return evaluate<TexelRGB16F>(uv);
+            case TexelFormat::RGB32F: return evaluate<TexelRGB32F>(uv);
         }
+        return Color::black();
+    }
+
+    Point2i resolution() const override {
+        return m_levels.front().resolution();
     }
 
     std::string toString() const override {
+        static const char *formats[] = { "rgb8", "rgba8", "r8", "rgb16f", "rgb32f" };
+        size_t bytes = 0;
+        for (const auto &level : m_levels)
+            bytes += level.bytes();
         return tfm::format("ImageTexture[\n"
-                           "  image = %s,\n"
+                           "  resolution = %s,\n"
+                           "  format = %s (%d bytes),\n"
+                           "  levels = %d,\n"
                            "  exposure = %f,\n"
                            "]",
-                           indent(m_image), m_exposure
+                           m_levels.front().resolution(), formats[int(m_levels.front().format())], bytes,
+                           m_levels.size(), m_exposure
         );
     }
 };
@@ -0,0 +1,299 @@
+/**
+ * @file texels.hpp
+ * @brief Contains the TexelImage class, which stores the pixels of texture images in compact formats.
+ */
+
+#pragma once
+
+#include <lightwave/color.hpp>
+#include <lightwave/image.hpp>
+#include <lightwave/math.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vector>
+
+namespace lightwave {
+
+/// @brief The formats that texels can be stored in.
+enum class TexelFormat : std::uint8_t {
+    /// @brief Three 8-bit channels, linearized through a lookup table (e.g., for JPG and PNG files).
+    RGB8,
+    /// @brief Like RGB8, but padded to four bytes per texel (the alpha channel is unused).
+    RGBA8,
+    /// @brief A single 8-bit channel for grayscale images, linearized through a lookup table.
+    R8,
+    /// @brief Three 16-bit half floats (e.g., for HDR environment maps where full precision is not needed).
+    RGB16F,
+    /// @brief Three 32-bit floats, i.e., the pixels of the image as they are.
+    RGB32F,
+};
+
+/**
+ * @brief Converts a float to the nearest 16-bit half float (rounding to even), values beyond the range of half floats
+ * become infinite.
+ * @note See "half <-> float conversions" [Giesen 2012].
+ */
+inline uint16_t floatToHalf(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t result;
+    if (bits >= 0x47800000u) {
+        // too large for half floats, infinity or NaN
+        result = bits > 0x7f800000u ? 0x7e00 : 0x7c00;
+    } else if (bits < 0x38800000u) {
+        // subnormal half float or zero: adding 0.5 lets the hardware round the mantissa into place
+        const float shifted = std::bit_cast<float>(bits) + 0.5f;
+        result = std::bit_cast<uint32_t>(shifted) - 0x3f000000u;
+    } else {
+        const uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += (uint32_t(15 - 127) << 23) + 0xfff + mantissaOdd;
+        result = bits >> 13;
+    }
+    return uint16_t(result | (sign >> 16));
+}
+
+/// @brief Converts a 16-bit half float to a float (which is always exact).
+inline float halfToFloat(uint16_t half) {
+    constexpr uint32_t shiftedExponent = 0x7c00u << 13;
+    uint32_t bits = uint32_t(half & 0x7fff) << 13;
+    const uint32_t exponent = bits & shiftedExponent;
+    bits += uint32_t(127 - 15) << 23;
+    if (exponent == shiftedExponent) {
+        // infinity or NaN
+        bits += uint32_t(128 - 16) << 23;
+    } else if (exponent == 0) {
+        // zero or subnormal, which is renormalized by the floating point unit
+        bits += 1 << 23;
+        bits = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) - std::bit_cast<float>(113u << 23));
+    }
+    return std::bit_cast<float>(bits | (uint32_t(half & 0x8000) << 16));
+}
+
+/// @brief Maps the values of 8-bit channels to linear values, i.e., undoes the gamma they were encoded with.
+struct LinearizationTable {
+    std::array<float, 256> values;
+
+    explicit LinearizationTable(float gamma = 1) {
+        // same conversion as Image::loadImage, so that textures from 8-bit files are represented exactly
+        for (int value = 0; value < 256; value++)
+            values[value] = float(std::pow(double(value / 255.0f), double(gamma)));
+    }
+
+    float operator()(uint8_t value) const { return values[value]; }
+};
+
+/**
+ * @brief Finds the 8-bit values that a @ref LinearizationTable maps closest to given linear values.
+ * Since positive floats are ordered like their bit patterns, the upper bits of a value select a bucket that tells
+ * where in the (sorted) table to start looking, after which at most a few entries need to be skipped.
+ */
+class LinearizationEncoder {
+    static constexpr int BucketShift = 16;
+    /// @brief The bucket of the value 1, beyond which all values encode to 255.
+    static constexpr uint32_t BucketCount = (0x3f800000u >> BucketShift) + 1;
+
+    const LinearizationTable &m_table;
+    /// @brief For each bucket, the last table entry that lies below all values within the bucket.
+    std::vector<uint8_t> m_buckets;
+
+public:
+    explicit LinearizationEncoder(const LinearizationTable &table) : m_table(table), m_buckets(BucketCount) {
+        int entry = 0;
+        for (uint32_t bucket = 0; bucket < BucketCount; bucket++) {
+            while (entry < 255 && (std::bit_cast<uint32_t>(table.values[entry + 1]) >> BucketShift) < bucket)
+                entry++;
+            m_buckets[bucket] = uint8_t(entry);
+        }
+    }
+
+    /// @brief Returns the 8-bit value that is linearized to the value closest to the given one.
+    uint8_t encode(float value) const {
+        if (!(value > 0))
+            return 0;
+        if (value >= 1)
+            return 255;
+        int entry = m_buckets[std::bit_cast<uint32_t>(value) >> BucketShift];
+        while (entry < 255 && m_table.values[entry + 1] <= value)
+            entry++;
+        if (entry < 255 && m_table.values[entry + 1] - value < value - m_table.values[entry])
+            entry++;
+        return uint8_t(entry);
+    }
+
+};
+
+/// @brief The 8-bit values of the red, green and blue channel of a pixel.
+using Codes = std::array<uint8_t, 3>;
+
+struct TexelRGB8 {
+    static constexpr bool Encoded = true;
+    Codes channels;
+
+    explicit TexelRGB8(const Codes &codes) : channels(codes) {}
+    Color decode(const LinearizationTable &table) const {
+        return { table(channels[0]), table(channels[1]), table(channels[2]) };
+    }
+};
+
+struct TexelRGBA8 {
+    static constexpr bool Encoded = true;
+    std::array<uint8_t, 4> channels;
+
+    explicit TexelRGBA8(const Codes &codes) : channels({ codes[0], codes[1], codes[2], 255 }) {}
+    Color decode(const LinearizationTable &table) const {
+        return { table(channels[0]), table(channels[1]), table(channels[2]) };
+    }
+};
+
+struct TexelR8 {
+    static constexpr bool Encoded = true;
+    /// @brief The red channel, which is all that matters for grayscale images (and scalar textures).
+    uint8_t value;
+
+    explicit TexelR8(const Codes &codes) : value(codes[0]) {}
+    Color decode(const LinearizationTable &table) const { return Color(table(value)); }
+};
+
+struct TexelRGB16F {
+    static constexpr bool Encoded = false;
+    std::array<uint16_t, 3> channels;
+
+    explicit TexelRGB16F(const Color &color)
+    : channels({ floatToHalf(color.r()), floatToHalf(color.g()), floatToHalf(color.b()) }) {}
+    Color decode(const LinearizationTable &) const {
+        return { halfToFloat(channels[0]), halfToFloat(channels[1]), halfToFloat(channels[2]) };
+    }
+};
+
+struct TexelRGB32F {
+    static constexpr bool Encoded = false;
+    Color color;
+
+    explicit TexelRGB32F(const Color &color) : color(color) {}
+    Color decode(const LinearizationTable &) const { return color; }
+};
+
+/**
+ * @brief The pixels of an image, stored in one of the texel formats.
+ * Unless a format is requested, the most compact format that reproduces every pixel exactly is chosen: images loaded
+ * from 8-bit files (with or without gamma) use RGB8 (or R8 if they are grayscale), and all other images use RGB32F.
+ * Images are stored in 8-bit formats with the gamma (2.2 or linear) that reproduces them exactly, or with gamma 2.2
+ * (which spends the 8 bits more evenly across perceived brightness) if neither does.
+ */
+class TexelImage {
+    Point2i m_resolution;
+    TexelFormat m_format;
+    LinearizationTable m_table;
+    std::variant<std::vector<TexelRGB8>, std::vector<TexelRGBA8>, std::vector<TexelR8>, std::vector<TexelRGB16F>,
+                 std::vector<TexelRGB32F>>
+        m_texels;
+    /// @brief The texels stored in @ref m_texels , which saves checking the type of the variant for every lookup.
+    const void *m_data;
+
+    /**
+     * @brief Encodes all pixels with 8 bits per channel using @ref m_table , and returns whether all of them were
+     * reproduced exactly. If @c exactOnly is set, encoding stops at the first pixel that is not.
+     */
+    bool encode(const Image &image, bool exactOnly, std::vector<Codes> &codes, bool &grayscale) const {
+        const LinearizationEncoder encoder{ m_table };
+        const size_t pixelCount = size_t(m_resolution.x()) * m_resolution.y();
+        codes.resize(pixelCount);
+        bool exact = true;
+        grayscale = true;
+        for (size_t index = 0; index < pixelCount; index++) {
+            const Color &pixel = image.data()[index];
+            for (int channel = 0; channel < Color::NumComponents; channel++) {
+                codes[index][channel] = encoder.encode(pixel[channel]);
+                exact &= m_table(codes[index][channel]) == pixel[channel];
+            }
+            if (!exact && exactOnly)
+                return false;
+            grayscale &= codes[index][0] == codes[index][1] && codes[index][1] == codes[index][2];
+        }
+        return exact;
+    }
+
+    template <typename Texel> void store(const Image &image, const std::vector<Codes> &codes) {
+        std::vector<Texel> texels;
+        const size_t pixelCount = size_t(m_resolution.x()) * m_resolution.y();
+        texels.reserve(pixelCount);
+        for (size_t index = 0; index < pixelCount; index++) {
+            if constexpr (Texel::Encoded) {
+                texels.emplace_back(codes[index]);
+            } else {
+                texels.emplace_back(image.data()[index]);
+            }
+        }
+        m_data = texels.data();
+        m_texels = std::move(texels);
+    }
+
+public:
+    TexelImage(const Image &image, std::optional<TexelFormat> format) : m_resolution(image.resolution()) {
+        // images from 8-bit files are reproduced exactly by one of the tables, which is found while encoding them
+        std::vector<Codes> codes;
+        bool exact = false, grayscale = false;
+        for (const float gamma : { 2.2f, 1.0f }) {
+            m_table = LinearizationTable{ gamma };
+            if ((exact = encode(image, true, codes, grayscale)))
+                break;
+        }
+
+        if (!format) {
+            if (exact) {
+                format = grayscale ? TexelFormat::R8 : TexelFormat::RGB8;
+            } else {
+                format = TexelFormat::RGB32F;
+            }
+        }
+        m_format = *format;
+
+        const bool encoded =
+            m_format == TexelFormat::RGB8 || m_format == TexelFormat::RGBA8 || m_format == TexelFormat::R8;
+        if (!exact) {
+            m_table = LinearizationTable{ 2.2f };
+            if (encoded)
+                encode(image, false, codes, grayscale);
+        }
+
+        switch (m_format) {
+        case TexelFormat::RGB8: store<TexelRGB8>(image, codes); break;
+        case TexelFormat::RGBA8: store<TexelRGBA8>(image, codes); break;
+        case TexelFormat::R8: store<TexelR8>(image, codes); break;
+        case TexelFormat::RGB16F: store<TexelRGB16F>(image, codes); break;
+        case TexelFormat::RGB32F: store<TexelRGB32F>(image, codes); break;
+        }
+    }
+
+    // copies would refer to the texels of the original, while moves keep the texels in place
+    TexelImage(const TexelImage &) = delete;
+    TexelImage &operator=(const TexelImage &) = delete;
+    TexelImage(TexelImage &&) = default;
+    TexelImage &operator=(TexelImage &&) = default;
+
+    const Point2i &resolution() const { return m_resolution; }
+    TexelFormat format() const { return m_format; }
+    /// @brief Returns the table that linearizes the channels of 8-bit formats.
+    const LinearizationTable &table() const { return m_table; }
+
+    /// @brief Returns the texels, which must be stored with the given texel type (see @ref format ).
+    template <typename Texel> const Texel *texels() const {
+        assert(std::holds_alternative<std::vector<Texel>>(m_texels));
+        return static_cast<const Texel *>(m_data);
+    }
+
+    /// @brief Returns the number of bytes used to store the texels.
+    size_t bytes() const {
+        return std::visit([](const auto &texels) { return texels.size() * sizeof(texels[0]); }, m_texels);
+    }
+};
+
+} // namespace lightwave